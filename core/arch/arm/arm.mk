@@ -99,6 +99,15 @@ ifeq ($(CFG_CORE_LARGE_PHYS_ADDR),y)
 $(call force,CFG_WITH_LPAE,y)
 endif
 
+# With LPAE, physically contiguous user TA memory, including memref
+# parameters, is mapped with the contiguous hint on aligned groups of 16
+# pages so that each group may use a single TLB entry. Large mappings get
+# a virtual address aligned like their physical address when possible.
+CFG_CORE_MMU_USER_CONTIG_HINT ?= $(CFG_WITH_LPAE)
+ifeq ($(CFG_CORE_MMU_USER_CONTIG_HINT),y)
+$(call force,CFG_WITH_LPAE,y,required by CFG_CORE_MMU_USER_CONTIG_HINT)
+endif
+
 # SPMC configuration "S-EL1 SPMC" where SPM Core is implemented at S-EL1,
 # that is, OP-TEE.
 ifeq ($(CFG_CORE_SEL1_SPMC),y)
@@ -49,4 +49,14 @@ static inline bool timeout_elapsed(uint64_t expire)
 	return barrier_read_counter_timer() > expire;
 }
 
+static inline uint64_t timer_cnt_read(void)
+{
+	return barrier_read_counter_timer();
+}
+
+static inline uint64_t timer_cnt_freq(void)
+{
+	return read_cntfrq();
+}
+
 #endif
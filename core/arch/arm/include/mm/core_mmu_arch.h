@@ -45,6 +45,11 @@
 #ifdef CFG_WITH_LPAE
 #define CORE_MMU_PGDIR_SHIFT	U(21)
 #define CORE_MMU_PGDIR_LEVEL	U(3)
+/*
+ * Number of aligned entries of a translation table which can be tagged
+ * with the contiguous hint, 64 KiB at page level.
+ */
+#define CORE_MMU_CONTIG_ENTRIES	U(16)
 #else
 #define CORE_MMU_PGDIR_SHIFT	U(20)
 #define CORE_MMU_PGDIR_LEVEL	U(2)
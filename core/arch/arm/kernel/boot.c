@@ -461,6 +461,8 @@ static void init_runtime(unsigned long pageable_part)
 	struct fobj *fobj = NULL;
 	uint8_t *paged_store = NULL;
 	uint8_t *hashes = NULL;
+	size_t verify_size = pageable_size;
+	uint64_t t = 0;
 
 	assert(pageable_size % SMALL_PAGE_SIZE == 0);
 	assert(embdata->total_len >= embdata->hashes_offset +
@@ -517,9 +519,16 @@ static void init_runtime(unsigned long pageable_part)
 	 */
 	undo_init_relocation(paged_store);
 
-	/* Check that hashes of what's in pageable area is OK */
-	DMSG("Checking hashes of pageable area");
-	for (n = 0; (n * SMALL_PAGE_SIZE) < pageable_size; n++) {
+	/*
+	 * Check that hashes of what's in pageable area is OK. The pages
+	 * past the init part are checked by the pager each time they are
+	 * paged in, checking them now only catches a corruption earlier.
+	 */
+	if (IS_ENABLED(CFG_CORE_PAGER_LAZY_VERIFY))
+		verify_size = init_size;
+	DMSG("Checking hashes of %zu bytes of pageable area", verify_size);
+	t = barrier_read_counter_timer();
+	for (n = 0; (n * SMALL_PAGE_SIZE) < verify_size; n++) {
 		const uint8_t *hash = hashes + n * TEE_SHA256_HASH_SIZE;
 		const uint8_t *page = paged_store + n * SMALL_PAGE_SIZE;
 		TEE_Result res;
@@ -532,6 +541,10 @@ static void init_runtime(unsigned long pageable_part)
 			panic();
 		}
 	}
+	t = barrier_read_counter_timer() - t;
+	IMSG("Pager: checked %zu/%zu pages in %"PRIu64" us",
+	     verify_size / SMALL_PAGE_SIZE, pageable_size / SMALL_PAGE_SIZE,
+	     t * 1000000 / read_cntfrq());
 
 	/*
 	 * Assert prepaged init sections are page aligned so that nothing
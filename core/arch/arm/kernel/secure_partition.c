@@ -30,7 +30,6 @@
 #include <types_ext.h>
 #include <utee_defines.h>
 #include <util.h>
-#include <zlib.h>
 
 #define SP_MANIFEST_ATTR_READ		BIT(0)
 #define SP_MANIFEST_ATTR_WRITE		BIT(1)
@@ -9,6 +9,7 @@
 
 #include <arm.h>
 #include <assert.h>
+#include <bench.h>
 #include <config.h>
 #include <io.h>
 #include <keep.h>
@@ -18,11 +19,13 @@
 #include <kernel/lockdep.h>
 #include <kernel/misc.h>
 #include <kernel/panic.h>
+#include <kernel/sample_prof.h>
 #include <kernel/spinlock.h>
 #include <kernel/spmc_sp_handler.h>
 #include <kernel/tee_ta_manager.h>
 #include <kernel/thread.h>
 #include <kernel/thread_private.h>
+#include <kernel/user_access.h>
 #include <kernel/user_mode_ctx_struct.h>
 #include <kernel/virtualization.h>
 #include <mm/core_memprot.h>
@@ -33,6 +36,7 @@
 #include <smccc.h>
 #include <sm/sm.h>
 #include <trace.h>
+#include <unw/unwind.h>
 #include <util.h>
 
 #ifdef CFG_CORE_UNMAP_CORE_AT_EL0
@@ -221,24 +225,16 @@ static void __thread_alloc_and_run(uint32_t a0, uint32_t a1, uint32_t a2,
 				   void *pc)
 {
 	struct thread_core_local *l = thread_get_core_local();
-	bool found_thread = false;
-	size_t n = 0;
+	uint64_t bm_begin = bm_tp_begin();
+	int n = 0;
 
 	assert(l->curr_thread == THREAD_ID_INVALID);
 
-	thread_lock_global();
-
-	for (n = 0; n < CFG_NUM_THREADS; n++) {
-		if (threads[n].state == THREAD_STATE_FREE) {
-			threads[n].state = THREAD_STATE_ACTIVE;
-			found_thread = true;
-			break;
-		}
-	}
+	n = thread_state_alloc();
 
-	thread_unlock_global();
+	bm_tp_end(BENCHMARK_TP_THREAD_ALLOC, bm_begin);
 
-	if (!found_thread)
+	if (n == THREAD_ID_INVALID)
 		return;
 
 	l->curr_thread = n;
@@ -353,6 +349,72 @@ static void __noprof ftrace_resume(void)
 }
 #endif
 
+#ifdef ARM64
+static size_t get_user_stack(vaddr_t fp, vaddr_t *ips, size_t max_ips)
+{
+	uint64_t frame[2] = { };
+	size_t n = 0;
+
+	/* AArch64 frame records: { previous FP, LR } */
+	while (n < max_ips && fp && IS_ALIGNED(fp, sizeof(uint64_t))) {
+		if (copy_from_user(frame, (void *)fp, sizeof(frame)))
+			break;
+		if (!frame[1])
+			break;
+		ips[n++] = (frame[1] &
+			    GENMASK_64(CFG_LPAE_ADDR_SPACE_BITS - 1, 0)) - 4;
+		/* The stack grows down, anything else is a corrupt chain */
+		if (frame[0] <= fp)
+			break;
+		fp = frame[0];
+	}
+
+	return n;
+}
+
+static size_t get_kernel_stack(struct thread_ctx_regs *regs, vaddr_t pc,
+			       vaddr_t *ips, size_t max_ips)
+{
+	struct unwind_state_arm64 state = {
+		.fp = regs->x[29],
+		.sp = regs->sp,
+		.pc = pc,
+	};
+	size_t n = 0;
+
+	while (n < max_ips && unwind_stack_arm64(&state, thread_stack_start(),
+						 thread_stack_size()))
+		ips[n++] = state.pc;
+
+	return n;
+}
+#endif
+
+/*
+ * Feeds the system-wide sampling profiler with the state of a thread
+ * interrupted by a foreign interrupt. The registers are those saved by the
+ * interrupt handler.
+ */
+static void sample_suspended_thread(struct thread_ctx_regs *regs __maybe_unused,
+				    uint32_t cpsr, vaddr_t pc)
+{
+	vaddr_t ips[SAMPLE_PROF_MAX_DEPTH] = { pc };
+	size_t depth = sample_prof_max_depth();
+	size_t n = 1;
+
+	if (!depth)
+		return;
+
+#ifdef ARM64
+	if (!is_from_user(cpsr))
+		n += get_kernel_stack(regs, pc, ips + 1, depth - 1);
+	else if (!(cpsr & (SPSR_MODE_RW_32 << SPSR_MODE_RW_SHIFT)))
+		n += get_user_stack(regs->x[29], ips + 1, depth - 1);
+#endif
+
+	sample_prof_add(is_from_user(cpsr), ips, n);
+}
+
 static bool is_user_mode(struct thread_ctx_regs *regs)
 {
 	return is_from_user((uint32_t)regs->cpsr);
@@ -450,6 +512,8 @@ void thread_state_free(void)
 	if (IS_ENABLED(CFG_NS_VIRTUALIZATION))
 		virt_unset_guest();
 	thread_unlock_global();
+
+	thread_pool_shrink();
 }
 
 #ifdef CFG_WITH_PAGER
@@ -491,6 +555,9 @@ int thread_state_suspend(uint32_t flags, uint32_t cpsr, vaddr_t pc)
 
 	thread_check_canaries();
 
+	if (flags & THREAD_FLAGS_EXIT_ON_FOREIGN_INTR)
+		sample_suspended_thread(&threads[ct].regs, cpsr, pc);
+
 	release_unused_kernel_stack(threads + ct, cpsr);
 
 	if (is_from_user(cpsr)) {
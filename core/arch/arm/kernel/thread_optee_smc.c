@@ -4,6 +4,7 @@
  */
 
 #include <assert.h>
+#include <bench.h>
 #include <compiler.h>
 #include <config.h>
 #include <io.h>
@@ -12,6 +13,7 @@
 #include <kernel/notif.h>
 #include <kernel/thread.h>
 #include <kernel/thread_private.h>
+#include <kernel/trace_ext.h>
 #include <kernel/virtualization.h>
 #include <mm/core_mmu.h>
 #include <optee_msg.h>
@@ -168,7 +170,9 @@ static uint32_t call_entry_std(struct optee_msg_arg *arg, size_t num_params,
 	else
 		rv = OPTEE_SMC_RETURN_OK;
 
-	thread_rpc_shm_cache_clear(&thr->shm_cache);
+	thread_rpc_shm_cache_clear(&thr->shm_cache,
+				   IS_ENABLED(CFG_PREALLOC_RPC_CACHE) &&
+				   thread_prealloc_rpc_cache);
 	if (rpc_arg)
 		thr->rpc_arg = NULL;
 
@@ -296,10 +300,16 @@ uint32_t __weak __thread_std_smc_entry(uint32_t a0, uint32_t a1, uint32_t a2,
 				       uint32_t a3, uint32_t a4 __unused,
 				       uint32_t a5 __unused)
 {
+	uint32_t rv = 0;
+
 	if (IS_ENABLED(CFG_NS_VIRTUALIZATION))
 		virt_on_stdcall();
 
-	return std_smc_entry(a0, a1, a2, a3);
+	rv = std_smc_entry(a0, a1, a2, a3);
+	/* Have the messages logged while serving this call printed */
+	trace_ext_request_drain();
+
+	return rv;
 }
 
 bool thread_disable_prealloc_rpc_cache(uint64_t *cookie)
@@ -329,6 +339,9 @@ bool thread_disable_prealloc_rpc_cache(uint64_t *cookie)
 				goto out;
 			}
 		}
+
+		if (thread_rpc_shm_cache_pop_pool(cookie))
+			goto out;
 	}
 
 	*cookie = 0;
@@ -563,6 +576,7 @@ uint32_t thread_rpc_cmd(uint32_t cmd, size_t num_params,
 			struct thread_param *params)
 {
 	uint32_t rpc_args[THREAD_RPC_NUM_ARGS] = { OPTEE_SMC_RETURN_RPC_CMD };
+	uint64_t bm_begin = 0;
 	void *arg = NULL;
 	uint64_t carg = 0;
 	uint32_t ret = 0;
@@ -576,7 +590,9 @@ uint32_t thread_rpc_cmd(uint32_t cmd, size_t num_params,
 		return ret;
 
 	reg_pair_from_64(carg, rpc_args + 1, rpc_args + 2);
+	bm_begin = bm_tp_begin();
 	thread_rpc(rpc_args);
+	bm_tp_end(bm_tp_rpc_id(cmd), bm_begin);
 
 	return get_rpc_arg_res(arg, num_params, params);
 }
@@ -5,6 +5,7 @@
  */
 
 #include <assert.h>
+#include <bench.h>
 #include <ffa.h>
 #include <initcall.h>
 #include <io.h>
@@ -17,6 +18,7 @@
 #include <kernel/thread.h>
 #include <kernel/thread_private.h>
 #include <kernel/thread_spmc.h>
+#include <kernel/trace_ext.h>
 #include <mm/core_mmu.h>
 #include <mm/mobj.h>
 #include <optee_ffa.h>
@@ -683,7 +685,8 @@ static int add_mem_share(tee_mm_entry_t *mm, void *buf, size_t blen,
 	    ADD_OVERFLOW(n, addr_range_offs, &n) || n > blen)
 		return FFA_INVALID_PARAMETERS;
 
-	share.mf = mobj_ffa_sel1_spmc_new(share.page_count);
+	share.mf = mobj_ffa_sel1_spmc_new(share.page_count,
+					  share.region_count);
 	if (!share.mf)
 		return FFA_NO_MEMORY;
 
@@ -1052,7 +1055,7 @@ static TEE_Result yielding_call_with_arg(uint64_t cookie, uint32_t offset)
 
 	res = tee_entry_std(arg, num_params);
 
-	thread_rpc_shm_cache_clear(&thr->shm_cache);
+	thread_rpc_shm_cache_clear(&thr->shm_cache, false);
 	thr->rpc_arg = NULL;
 
 out_dec_map:
@@ -1080,10 +1083,15 @@ uint32_t __weak __thread_std_smc_entry(uint32_t a0, uint32_t a1,
 	 * a4 <- w6
 	 * a5 <- w7
 	 */
+	uint32_t rv = FFA_DENIED;
+
 	thread_get_tsd()->rpc_target_info = swap_src_dst(a0);
 	if (a1 == OPTEE_FFA_YIELDING_CALL_WITH_ARG)
-		return yielding_call_with_arg(reg_pair_to_64(a3, a2), a4);
-	return FFA_DENIED;
+		rv = yielding_call_with_arg(reg_pair_to_64(a3, a2), a4);
+	/* Have the messages logged while serving this call printed */
+	trace_ext_request_drain();
+
+	return rv;
 }
 
 static bool set_fmem(struct optee_msg_param *param, struct thread_param *tpm)
@@ -1198,13 +1206,16 @@ uint32_t thread_rpc_cmd(uint32_t cmd, size_t num_params,
 		},
 	};
 	struct optee_msg_arg *arg = NULL;
+	uint64_t bm_begin = 0;
 	uint32_t ret = 0;
 
 	ret = get_rpc_arg(cmd, num_params, params, &arg);
 	if (ret)
 		return ret;
 
+	bm_begin = bm_tp_begin();
 	thread_rpc(&rpc_arg);
+	bm_tp_end(bm_tp_rpc_id(cmd), bm_begin);
 
 	return get_rpc_arg_res(arg, num_params, params);
 }
@@ -1472,6 +1483,7 @@ struct mobj_ffa *thread_spmc_populate_mobj_from_rx(uint64_t cookie)
 	struct ffa_mem_access *descr_array = NULL;
 	struct ffa_mem_region *descr = NULL;
 	struct mobj_ffa *mf = NULL;
+	unsigned int num_regions = 0;
 	unsigned int num_pages = 0;
 	unsigned int offs = 0;
 	struct thread_smc_args ffa_rx_release_args = {
@@ -1494,12 +1506,13 @@ struct mobj_ffa *thread_spmc_populate_mobj_from_rx(uint64_t cookie)
 	descr = (struct ffa_mem_region *)((vaddr_t)retrieve_desc + offs);
 
 	num_pages = READ_ONCE(descr->total_page_count);
-	mf = mobj_ffa_spmc_new(cookie, num_pages);
+	num_regions = READ_ONCE(descr->address_range_count);
+	mf = mobj_ffa_spmc_new(cookie, num_pages, num_regions);
 	if (!mf)
 		goto out;
 
-	if (set_pages(descr->address_range_array,
-		      READ_ONCE(descr->address_range_count), num_pages, mf)) {
+	if (set_pages(descr->address_range_array, num_regions, num_pages,
+		      mf)) {
 		mobj_ffa_spmc_delete(mf);
 		goto out;
 	}
@@ -19,10 +19,21 @@
 #include <string.h>
 #include <util.h>
 
-static unsigned int prtn_list_lock __nex_data = SPINLOCK_UNLOCK;
+#define PRTN_HASH_SIZE	16
+
+/*
+ * Guest partitions hashed by guest ID, each bucket with its own lock so
+ * that the standard calls of different guests don't contend when they
+ * look up their partition.
+ */
+struct prtn_bucket {
+	unsigned int lock;
+	LIST_HEAD(prtn_list_head, guest_partition) list;
+};
 
-static LIST_HEAD(prtn_list_head, guest_partition) prtn_list __nex_data =
-	LIST_HEAD_INITIALIZER(prtn_list_head);
+static struct prtn_bucket prtn_hash[PRTN_HASH_SIZE] __nex_data = {
+	[0 ... PRTN_HASH_SIZE - 1] = { .lock = SPINLOCK_UNLOCK },
+};
 
 /* Free pages used for guest partitions */
 tee_mm_pool_t virt_mapper_pool __nex_bss;
@@ -67,6 +78,24 @@ static void set_current_prtn(struct guest_partition *prtn)
 	thread_unmask_exceptions(exceptions);
 }
 
+static struct prtn_bucket *get_prtn_bucket(uint16_t guest_id)
+{
+	return prtn_hash + guest_id % PRTN_HASH_SIZE;
+}
+
+/* Called with the lock of the bucket of @guest_id held */
+static struct guest_partition *find_prtn(struct prtn_bucket *bucket,
+					 uint16_t guest_id)
+{
+	struct guest_partition *prtn = NULL;
+
+	LIST_FOREACH(prtn, &bucket->list, link)
+		if (prtn->id == guest_id)
+			return prtn;
+
+	return NULL;
+}
+
 static size_t get_ta_ram_size(void)
 {
 	return ROUNDDOWN(TA_RAM_SIZE / CFG_VIRT_GUEST_COUNT -
@@ -268,6 +297,7 @@ err:
 
 TEE_Result virt_guest_created(uint16_t guest_id)
 {
+	struct prtn_bucket *bucket = get_prtn_bucket(guest_id);
 	struct guest_partition *prtn = NULL;
 	TEE_Result res = TEE_SUCCESS;
 	uint32_t exceptions = 0;
@@ -292,9 +322,9 @@ TEE_Result virt_guest_created(uint16_t guest_id)
 	/* Do the preinitcalls */
 	call_preinitcalls();
 
-	exceptions = cpu_spin_lock_xsave(&prtn_list_lock);
-	LIST_INSERT_HEAD(&prtn_list, prtn, link);
-	cpu_spin_unlock_xrestore(&prtn_list_lock, exceptions);
+	exceptions = cpu_spin_lock_xsave(&bucket->lock);
+	LIST_INSERT_HEAD(&bucket->list, prtn, link);
+	cpu_spin_unlock_xrestore(&bucket->lock, exceptions);
 
 	IMSG("Added guest %d", guest_id);
 
@@ -306,20 +336,17 @@ TEE_Result virt_guest_created(uint16_t guest_id)
 
 TEE_Result virt_guest_destroyed(uint16_t guest_id)
 {
+	struct prtn_bucket *bucket = get_prtn_bucket(guest_id);
 	struct guest_partition *prtn;
 	uint32_t exceptions;
 
 	IMSG("Removing guest %d", guest_id);
 
-	exceptions = cpu_spin_lock_xsave(&prtn_list_lock);
-
-	LIST_FOREACH(prtn, &prtn_list, link) {
-		if (prtn->id == guest_id) {
-			LIST_REMOVE(prtn, link);
-			break;
-		}
-	}
-	cpu_spin_unlock_xrestore(&prtn_list_lock, exceptions);
+	exceptions = cpu_spin_lock_xsave(&bucket->lock);
+	prtn = find_prtn(bucket, guest_id);
+	if (prtn)
+		LIST_REMOVE(prtn, link);
+	cpu_spin_unlock_xrestore(&bucket->lock, exceptions);
 
 	if (prtn) {
 		if (!refcount_dec(&prtn->refc)) {
@@ -342,6 +369,7 @@ TEE_Result virt_guest_destroyed(uint16_t guest_id)
 
 TEE_Result virt_set_guest(uint16_t guest_id)
 {
+	struct prtn_bucket *bucket = NULL;
 	struct guest_partition *prtn;
 	uint32_t exceptions;
 
@@ -354,18 +382,17 @@ TEE_Result virt_set_guest(uint16_t guest_id)
 	if (prtn)
 		panic("Virtual guest partition is already set");
 
-	exceptions = cpu_spin_lock_xsave(&prtn_list_lock);
-	LIST_FOREACH(prtn, &prtn_list, link) {
-		if (prtn->id == guest_id) {
-			set_current_prtn(prtn);
-			core_mmu_set_prtn(prtn->mmu_prtn);
-			refcount_inc(&prtn->refc);
-			cpu_spin_unlock_xrestore(&prtn_list_lock,
-						 exceptions);
-			return TEE_SUCCESS;
-		}
+	bucket = get_prtn_bucket(guest_id);
+	exceptions = cpu_spin_lock_xsave(&bucket->lock);
+	prtn = find_prtn(bucket, guest_id);
+	if (prtn) {
+		set_current_prtn(prtn);
+		core_mmu_set_prtn(prtn->mmu_prtn);
+		refcount_inc(&prtn->refc);
+		cpu_spin_unlock_xrestore(&bucket->lock, exceptions);
+		return TEE_SUCCESS;
 	}
-	cpu_spin_unlock_xrestore(&prtn_list_lock, exceptions);
+	cpu_spin_unlock_xrestore(&bucket->lock, exceptions);
 
 	if (guest_id == HYP_CLNT_ID)
 		return TEE_SUCCESS;
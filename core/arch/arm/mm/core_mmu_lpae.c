@@ -334,6 +334,9 @@ static uint32_t desc_to_mattr(unsigned level, uint64_t desc)
 	if (desc & UPPER_ATTRS(PXN))
 		a &= ~TEE_MATTR_PX;
 
+	if (desc & UPPER_ATTRS(CONT_HINT))
+		a |= TEE_MATTR_CONTIGUOUS;
+
 	COMPILE_TIME_ASSERT(ATTR_DEVICE_nGnRnE_INDEX ==
 			    TEE_MATTR_MEM_TYPE_STRONGLY_O);
 	COMPILE_TIME_ASSERT(ATTR_DEVICE_nGnRE_INDEX == TEE_MATTR_MEM_TYPE_DEV);
@@ -389,6 +392,8 @@ static uint64_t mattr_to_desc(unsigned level, uint32_t attr)
 		desc |= UPPER_ATTRS(XN);
 	if (!(a & TEE_MATTR_PX))
 		desc |= UPPER_ATTRS(PXN);
+	if (a & TEE_MATTR_CONTIGUOUS)
+		desc |= UPPER_ATTRS(CONT_HINT);
 
 	if (a & TEE_MATTR_UR)
 		desc |= LOWER_ATTRS(AP_UNPRIV);
@@ -55,12 +55,30 @@ static size_t mobj_reg_shm_size(size_t nr_pages)
 	return s;
 }
 
-static SLIST_HEAD(reg_shm_head, mobj_reg_shm) reg_shm_list =
-	SLIST_HEAD_INITIALIZER(reg_shm_head);
+SLIST_HEAD(reg_shm_head, mobj_reg_shm);
 
-static unsigned int reg_shm_slist_lock = SPINLOCK_UNLOCK;
+/*
+ * Registered shared memory objects are hashed on their cookie. The lock of
+ * a bucket protects its list, its statistics and the guarded, releasing
+ * and release_frees fields of the objects in the list.
+ */
+struct reg_shm_bucket {
+	unsigned int lock;
+	struct reg_shm_head list;
+	size_t len;
+	uint64_t lookups;
+	uint64_t probes;
+};
+
+static struct reg_shm_bucket reg_shm_buckets[BIT(CFG_SHM_COOKIE_HASH_BITS)];
 static unsigned int reg_shm_map_lock = SPINLOCK_UNLOCK;
 
+static struct reg_shm_bucket *reg_shm_bucket(uint64_t cookie)
+{
+	return reg_shm_buckets +
+	       mobj_cookie_hash(cookie, CFG_SHM_COOKIE_HASH_BITS);
+}
+
 static struct mobj_reg_shm *to_mobj_reg_shm(struct mobj *mobj);
 
 static TEE_Result mobj_reg_shm_get_pa(struct mobj *mobj, size_t offst,
@@ -121,22 +139,27 @@ static void reg_shm_unmap_helper(struct mobj_reg_shm *r)
 	r->mm = NULL;
 }
 
+/* Called with the lock of the bucket of @mobj_reg_shm held */
 static void reg_shm_free_helper(struct mobj_reg_shm *mobj_reg_shm)
 {
 	uint32_t exceptions = cpu_spin_lock_xsave(&reg_shm_map_lock);
+	struct reg_shm_bucket *b = NULL;
 
 	if (mobj_reg_shm->mm)
 		reg_shm_unmap_helper(mobj_reg_shm);
 
 	cpu_spin_unlock_xrestore(&reg_shm_map_lock, exceptions);
 
-	SLIST_REMOVE(&reg_shm_list, mobj_reg_shm, mobj_reg_shm, next);
+	b = reg_shm_bucket(mobj_reg_shm->cookie);
+	SLIST_REMOVE(&b->list, mobj_reg_shm, mobj_reg_shm, next);
+	b->len--;
 	free(mobj_reg_shm);
 }
 
 static void mobj_reg_shm_free(struct mobj *mobj)
 {
 	struct mobj_reg_shm *r = to_mobj_reg_shm(mobj);
+	struct reg_shm_bucket *b = reg_shm_bucket(r->cookie);
 	uint32_t exceptions = 0;
 
 	if (r->guarded && !r->releasing) {
@@ -147,17 +170,17 @@ static void mobj_reg_shm_free(struct mobj *mobj)
 		 * unless mobj_reg_shm_release_by_cookie() is waiting for
 		 * the mobj to be released.
 		 */
-		exceptions = cpu_spin_lock_xsave(&reg_shm_slist_lock);
+		exceptions = cpu_spin_lock_xsave(&b->lock);
 		reg_shm_free_helper(r);
-		cpu_spin_unlock_xrestore(&reg_shm_slist_lock, exceptions);
+		cpu_spin_unlock_xrestore(&b->lock, exceptions);
 	} else {
 		/*
 		 * We've reached the point where an unguarded reg shm can
 		 * be released by cookie. Notify eventual waiters.
 		 */
-		exceptions = cpu_spin_lock_xsave(&reg_shm_slist_lock);
+		exceptions = cpu_spin_lock_xsave(&b->lock);
 		r->release_frees = true;
-		cpu_spin_unlock_xrestore(&reg_shm_slist_lock, exceptions);
+		cpu_spin_unlock_xrestore(&b->lock, exceptions);
 
 		mutex_lock(&shm_mu);
 		if (shm_release_waiters)
@@ -297,6 +320,7 @@ struct mobj *mobj_reg_shm_alloc(paddr_t *pages, size_t num_pages,
 				paddr_t page_offset, uint64_t cookie)
 {
 	struct mobj_reg_shm *mobj_reg_shm = NULL;
+	struct reg_shm_bucket *b = NULL;
 	size_t i = 0;
 	uint32_t exceptions = 0;
 	size_t s = 0;
@@ -331,9 +355,11 @@ struct mobj *mobj_reg_shm_alloc(paddr_t *pages, size_t num_pages,
 			goto err;
 	}
 
-	exceptions = cpu_spin_lock_xsave(&reg_shm_slist_lock);
-	SLIST_INSERT_HEAD(&reg_shm_list, mobj_reg_shm, next);
-	cpu_spin_unlock_xrestore(&reg_shm_slist_lock, exceptions);
+	b = reg_shm_bucket(cookie);
+	exceptions = cpu_spin_lock_xsave(&b->lock);
+	SLIST_INSERT_HEAD(&b->list, mobj_reg_shm, next);
+	b->len++;
+	cpu_spin_unlock_xrestore(&b->lock, exceptions);
 
 	return &mobj_reg_shm->mobj;
 err:
@@ -343,29 +369,37 @@ err:
 
 void mobj_reg_shm_unguard(struct mobj *mobj)
 {
-	uint32_t exceptions = cpu_spin_lock_xsave(&reg_shm_slist_lock);
+	struct mobj_reg_shm *r = to_mobj_reg_shm(mobj);
+	struct reg_shm_bucket *b = reg_shm_bucket(r->cookie);
+	uint32_t exceptions = cpu_spin_lock_xsave(&b->lock);
 
-	to_mobj_reg_shm(mobj)->guarded = false;
-	cpu_spin_unlock_xrestore(&reg_shm_slist_lock, exceptions);
+	r->guarded = false;
+	cpu_spin_unlock_xrestore(&b->lock, exceptions);
 }
 
-static struct mobj_reg_shm *reg_shm_find_unlocked(uint64_t cookie)
+/* Called with the lock of bucket @b held */
+static struct mobj_reg_shm *reg_shm_find_unlocked(struct reg_shm_bucket *b,
+						  uint64_t cookie)
 {
 	struct mobj_reg_shm *mobj_reg_shm = NULL;
 
-	SLIST_FOREACH(mobj_reg_shm, &reg_shm_list, next)
+	b->lookups++;
+	SLIST_FOREACH(mobj_reg_shm, &b->list, next) {
+		b->probes++;
 		if (mobj_reg_shm->cookie == cookie)
 			return mobj_reg_shm;
+	}
 
 	return NULL;
 }
 
 struct mobj *mobj_reg_shm_get_by_cookie(uint64_t cookie)
 {
-	uint32_t exceptions = cpu_spin_lock_xsave(&reg_shm_slist_lock);
-	struct mobj_reg_shm *r = reg_shm_find_unlocked(cookie);
+	struct reg_shm_bucket *b = reg_shm_bucket(cookie);
+	uint32_t exceptions = cpu_spin_lock_xsave(&b->lock);
+	struct mobj_reg_shm *r = reg_shm_find_unlocked(b, cookie);
 
-	cpu_spin_unlock_xrestore(&reg_shm_slist_lock, exceptions);
+	cpu_spin_unlock_xrestore(&b->lock, exceptions);
 	if (!r)
 		return NULL;
 
@@ -374,6 +408,7 @@ struct mobj *mobj_reg_shm_get_by_cookie(uint64_t cookie)
 
 TEE_Result mobj_reg_shm_release_by_cookie(uint64_t cookie)
 {
+	struct reg_shm_bucket *b = reg_shm_bucket(cookie);
 	uint32_t exceptions = 0;
 	struct mobj_reg_shm *r = NULL;
 
@@ -383,14 +418,14 @@ TEE_Result mobj_reg_shm_release_by_cookie(uint64_t cookie)
 	 * wrong cookie and perhaps a second time, regardless return
 	 * TEE_ERROR_BAD_PARAMETERS.
 	 */
-	exceptions = cpu_spin_lock_xsave(&reg_shm_slist_lock);
-	r = reg_shm_find_unlocked(cookie);
+	exceptions = cpu_spin_lock_xsave(&b->lock);
+	r = reg_shm_find_unlocked(b, cookie);
 	if (!r || r->guarded || r->releasing)
 		r = NULL;
 	else
 		r->releasing = true;
 
-	cpu_spin_unlock_xrestore(&reg_shm_slist_lock, exceptions);
+	cpu_spin_unlock_xrestore(&b->lock, exceptions);
 
 	if (!r)
 		return TEE_ERROR_BAD_PARAMETERS;
@@ -411,12 +446,12 @@ TEE_Result mobj_reg_shm_release_by_cookie(uint64_t cookie)
 	assert(shm_release_waiters);
 
 	while (true) {
-		exceptions = cpu_spin_lock_xsave(&reg_shm_slist_lock);
+		exceptions = cpu_spin_lock_xsave(&b->lock);
 		if (r->release_frees) {
 			reg_shm_free_helper(r);
 			r = NULL;
 		}
-		cpu_spin_unlock_xrestore(&reg_shm_slist_lock, exceptions);
+		cpu_spin_unlock_xrestore(&b->lock, exceptions);
 
 		if (!r)
 			break;
@@ -430,6 +465,31 @@ TEE_Result mobj_reg_shm_release_by_cookie(uint64_t cookie)
 	return TEE_SUCCESS;
 }
 
+void mobj_reg_shm_get_cookie_stats(struct mobj_cookie_stats *stats,
+				   bool reset)
+{
+	struct reg_shm_bucket *b = NULL;
+	uint32_t exceptions = 0;
+
+	*stats = (struct mobj_cookie_stats){
+		.buckets = ARRAY_SIZE(reg_shm_buckets),
+	};
+
+	for (b = reg_shm_buckets; b < reg_shm_buckets +
+	     ARRAY_SIZE(reg_shm_buckets); b++) {
+		exceptions = cpu_spin_lock_xsave(&b->lock);
+		stats->lookups += b->lookups;
+		stats->probes += b->probes;
+		stats->entries += b->len;
+		stats->max_chain = MAX(stats->max_chain, b->len);
+		if (reset) {
+			b->lookups = 0;
+			b->probes = 0;
+		}
+		cpu_spin_unlock_xrestore(&b->lock, exceptions);
+	}
+}
+
 struct mobj *mobj_mapped_shm_alloc(paddr_t *pages, size_t num_pages,
 				  paddr_t page_offset, uint64_t cookie)
 {
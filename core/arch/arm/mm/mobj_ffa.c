@@ -13,6 +13,21 @@
 #include <mm/mobj.h>
 #include <sys/queue.h>
 
+/*
+ * A physically contiguous part of a shared memory object, starting at page
+ * @page_idx of the object.
+ */
+struct mobj_ffa_range {
+	paddr_t pa;
+	unsigned int page_idx;
+	unsigned int page_count;
+};
+
+/*
+ * The pages of an object are described with up to @max_ranges ranges,
+ * sorted on their page index. Adjacent ranges which are also contiguous in
+ * physical memory are merged.
+ */
 struct mobj_ffa {
 	struct mobj mobj;
 	SLIST_ENTRY(mobj_ffa) link;
@@ -24,7 +39,9 @@ struct mobj_ffa {
 	bool registered_by_cookie;
 	bool unregistered_by_cookie;
 #endif
-	paddr_t pages[];
+	unsigned int range_count;
+	unsigned int max_ranges;
+	struct mobj_ffa_range ranges[];
 };
 
 SLIST_HEAD(mobj_ffa_head, mobj_ffa);
@@ -34,10 +51,23 @@ SLIST_HEAD(mobj_ffa_head, mobj_ffa);
 static bitstr_t bit_decl(shm_bits, NUM_SHMS);
 #endif
 
-static struct mobj_ffa_head shm_head = SLIST_HEAD_INITIALIZER(shm_head);
-static struct mobj_ffa_head shm_inactive_head =
-	SLIST_HEAD_INITIALIZER(shm_inactive_head);
+/*
+ * Shared memory objects are hashed on their cookie. An object is either in
+ * the active or in the inactive list of its bucket, both protected by the
+ * lock of the bucket together with the statistics.
+ */
+struct ffa_shm_bucket {
+	unsigned int lock;
+	struct mobj_ffa_head active;
+	struct mobj_ffa_head inactive;
+	size_t len;
+	uint64_t lookups;
+	uint64_t probes;
+};
+
+static struct ffa_shm_bucket shm_buckets[BIT(CFG_SHM_COOKIE_HASH_BITS)];
 
+/* Protects the mapping of the objects and the cookie bitmap */
 static unsigned int shm_lock = SPINLOCK_UNLOCK;
 
 static const struct mobj_ops mobj_ffa_ops;
@@ -48,32 +78,36 @@ static struct mobj_ffa *to_mobj_ffa(struct mobj *mobj)
 	return container_of(mobj, struct mobj_ffa, mobj);
 }
 
-static size_t shm_size(size_t num_pages)
+static size_t shm_size(size_t num_ranges)
 {
 	size_t s = 0;
 
-	if (MUL_OVERFLOW(sizeof(paddr_t), num_pages, &s))
+	if (MUL_OVERFLOW(sizeof(struct mobj_ffa_range), num_ranges, &s))
 		return 0;
 	if (ADD_OVERFLOW(sizeof(struct mobj_ffa), s, &s))
 		return 0;
 	return s;
 }
 
-static struct mobj_ffa *ffa_new(unsigned int num_pages)
+static struct mobj_ffa *ffa_new(unsigned int num_pages,
+				unsigned int num_ranges)
 {
 	struct mobj_ffa *mf = NULL;
 	size_t s = 0;
 
-	if (!num_pages)
+	if (!num_pages || !num_ranges)
 		return NULL;
 
-	s = shm_size(num_pages);
+	/* Each range holds at least one page */
+	num_ranges = MIN(num_ranges, num_pages);
+	s = shm_size(num_ranges);
 	if (!s)
 		return NULL;
 	mf = calloc(1, s);
 	if (!mf)
 		return NULL;
 
+	mf->max_ranges = num_ranges;
 	mf->mobj.ops = &mobj_ffa_ops;
 	mf->mobj.size = num_pages * SMALL_PAGE_SIZE;
 	mf->mobj.phys_granule = SMALL_PAGE_SIZE;
@@ -83,13 +117,14 @@ static struct mobj_ffa *ffa_new(unsigned int num_pages)
 }
 
 #ifdef CFG_CORE_SEL1_SPMC
-struct mobj_ffa *mobj_ffa_sel1_spmc_new(unsigned int num_pages)
+struct mobj_ffa *mobj_ffa_sel1_spmc_new(unsigned int num_pages,
+					unsigned int num_ranges)
 {
 	struct mobj_ffa *mf = NULL;
 	uint32_t exceptions = 0;
 	int i = 0;
 
-	mf = ffa_new(num_pages);
+	mf = ffa_new(num_pages, num_ranges);
 	if (!mf)
 		return NULL;
 
@@ -120,6 +155,11 @@ static size_t get_page_count(struct mobj_ffa *mf)
 	return ROUNDUP(mf->mobj.size, SMALL_PAGE_SIZE) / SMALL_PAGE_SIZE;
 }
 
+static struct ffa_shm_bucket *shm_bucket(uint64_t cookie)
+{
+	return shm_buckets + mobj_cookie_hash(cookie, CFG_SHM_COOKIE_HASH_BITS);
+}
+
 static bool cmp_cookie(struct mobj_ffa *mf, uint64_t cookie)
 {
 	return mf->cookie == cookie;
@@ -172,6 +212,22 @@ static struct mobj_ffa *find_in_list(struct mobj_ffa_head *head,
 	return NULL;
 }
 
+/* Called with the lock of bucket @b held */
+static struct mobj_ffa *find_cookie(struct ffa_shm_bucket *b,
+				    struct mobj_ffa_head *head, uint64_t cookie)
+{
+	struct mobj_ffa *mf = NULL;
+
+	b->lookups++;
+	SLIST_FOREACH(mf, head, link) {
+		b->probes++;
+		if (mf->cookie == cookie)
+			return mf;
+	}
+
+	return NULL;
+}
+
 #if defined(CFG_CORE_SEL1_SPMC)
 void mobj_ffa_sel1_spmc_delete(struct mobj_ffa *mf)
 {
@@ -189,12 +245,13 @@ void mobj_ffa_sel1_spmc_delete(struct mobj_ffa *mf)
 	free(mf);
 }
 #else /* !defined(CFG_CORE_SEL1_SPMC) */
-struct mobj_ffa *mobj_ffa_spmc_new(uint64_t cookie, unsigned int num_pages)
+struct mobj_ffa *mobj_ffa_spmc_new(uint64_t cookie, unsigned int num_pages,
+				   unsigned int num_ranges)
 {
 	struct mobj_ffa *mf = NULL;
 
 	assert(cookie != OPTEE_MSG_FMEM_INVALID_GLOBAL_ID);
-	mf = ffa_new(num_pages);
+	mf = ffa_new(num_pages, num_ranges);
 	if (mf)
 		mf->cookie = cookie;
 	return mf;
@@ -209,20 +266,47 @@ void mobj_ffa_spmc_delete(struct mobj_ffa *mf)
 TEE_Result mobj_ffa_add_pages_at(struct mobj_ffa *mf, unsigned int *idx,
 				 paddr_t pa, unsigned int num_pages)
 {
-	unsigned int n = 0;
+	struct mobj_ffa_range *r = NULL;
 	size_t tot_page_count = get_page_count(mf);
+	unsigned int n = 0;
 
 	if (ADD_OVERFLOW(*idx, num_pages, &n) || n > tot_page_count)
 		return TEE_ERROR_BAD_PARAMETERS;
 
+	if (pa & SMALL_PAGE_MASK)
+		return TEE_ERROR_BAD_PARAMETERS;
+
 	if (!IS_ENABLED(CFG_CORE_SEL2_SPMC) &&
 	    !core_pbuf_is(CORE_MEM_NON_SEC, pa, num_pages * SMALL_PAGE_SIZE))
 		return TEE_ERROR_BAD_PARAMETERS;
 
-	for (n = 0; n < num_pages; n++)
-		mf->pages[n + *idx] = pa + n * SMALL_PAGE_SIZE;
+	if (!num_pages)
+		return TEE_SUCCESS;
+
+	/* Pages are added in order, extend the last range if possible */
+	if (mf->range_count) {
+		r = mf->ranges + mf->range_count - 1;
+		if (r->page_idx + r->page_count != *idx)
+			return TEE_ERROR_BAD_PARAMETERS;
+		if (r->pa + r->page_count * SMALL_PAGE_SIZE == pa) {
+			r->page_count += num_pages;
+			(*idx) += num_pages;
+			return TEE_SUCCESS;
+		}
+	} else if (*idx) {
+		return TEE_ERROR_BAD_PARAMETERS;
+	}
+
+	if (mf->range_count == mf->max_ranges)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	r = mf->ranges + mf->range_count;
+	r->pa = pa;
+	r->page_idx = *idx;
+	r->page_count = num_pages;
+	mf->range_count++;
 
-	(*idx) += n;
+	(*idx) += num_pages;
 	return TEE_SUCCESS;
 }
 
@@ -233,14 +317,16 @@ uint64_t mobj_ffa_get_cookie(struct mobj_ffa *mf)
 
 uint64_t mobj_ffa_push_to_inactive(struct mobj_ffa *mf)
 {
+	struct ffa_shm_bucket *b = shm_bucket(mf->cookie);
 	uint32_t exceptions = 0;
 
-	exceptions = cpu_spin_lock_xsave(&shm_lock);
-	assert(!find_in_list(&shm_inactive_head, cmp_ptr, (vaddr_t)mf));
-	assert(!find_in_list(&shm_inactive_head, cmp_cookie, mf->cookie));
-	assert(!find_in_list(&shm_head, cmp_cookie, mf->cookie));
-	SLIST_INSERT_HEAD(&shm_inactive_head, mf, link);
-	cpu_spin_unlock_xrestore(&shm_lock, exceptions);
+	exceptions = cpu_spin_lock_xsave(&b->lock);
+	assert(!find_in_list(&b->inactive, cmp_ptr, (vaddr_t)mf));
+	assert(!find_in_list(&b->inactive, cmp_cookie, mf->cookie));
+	assert(!find_in_list(&b->active, cmp_cookie, mf->cookie));
+	SLIST_INSERT_HEAD(&b->inactive, mf, link);
+	b->len++;
+	cpu_spin_unlock_xrestore(&b->lock, exceptions);
 
 	return mf->cookie;
 }
@@ -258,12 +344,13 @@ static void unmap_helper(struct mobj_ffa *mf)
 #ifdef CFG_CORE_SEL1_SPMC
 TEE_Result mobj_ffa_sel1_spmc_reclaim(uint64_t cookie)
 {
+	struct ffa_shm_bucket *b = shm_bucket(cookie);
 	TEE_Result res = TEE_SUCCESS;
 	struct mobj_ffa *mf = NULL;
 	uint32_t exceptions = 0;
 
-	exceptions = cpu_spin_lock_xsave(&shm_lock);
-	mf = find_in_list(&shm_head, cmp_cookie, cookie);
+	exceptions = cpu_spin_lock_xsave(&b->lock);
+	mf = find_cookie(b, &b->active, cookie);
 	/*
 	 * If the mobj is found here it's still active and cannot be
 	 * reclaimed.
@@ -275,7 +362,7 @@ TEE_Result mobj_ffa_sel1_spmc_reclaim(uint64_t cookie)
 		goto out;
 	}
 
-	mf = find_in_list(&shm_inactive_head, cmp_cookie, cookie);
+	mf = find_cookie(b, &b->inactive, cookie);
 	if (!mf) {
 		res = TEE_ERROR_ITEM_NOT_FOUND;
 		goto out;
@@ -290,11 +377,12 @@ TEE_Result mobj_ffa_sel1_spmc_reclaim(uint64_t cookie)
 		goto out;
 	}
 
-	if (!pop_from_list(&shm_inactive_head, cmp_ptr, (vaddr_t)mf))
+	if (!pop_from_list(&b->inactive, cmp_ptr, (vaddr_t)mf))
 		panic();
+	b->len--;
 	res = TEE_SUCCESS;
 out:
-	cpu_spin_unlock_xrestore(&shm_lock, exceptions);
+	cpu_spin_unlock_xrestore(&b->lock, exceptions);
 	if (!res)
 		mobj_ffa_sel1_spmc_delete(mf);
 	return res;
@@ -303,13 +391,14 @@ out:
 
 TEE_Result mobj_ffa_unregister_by_cookie(uint64_t cookie)
 {
+	struct ffa_shm_bucket *b = shm_bucket(cookie);
 	TEE_Result res = TEE_SUCCESS;
 	struct mobj_ffa *mf = NULL;
 	uint32_t exceptions = 0;
 
 	assert(cookie != OPTEE_MSG_FMEM_INVALID_GLOBAL_ID);
-	exceptions = cpu_spin_lock_xsave(&shm_lock);
-	mf = find_in_list(&shm_head, cmp_cookie, cookie);
+	exceptions = cpu_spin_lock_xsave(&b->lock);
+	mf = find_cookie(b, &b->active, cookie);
 	/*
 	 * If the mobj is found here it's still active and cannot be
 	 * unregistered.
@@ -320,7 +409,7 @@ TEE_Result mobj_ffa_unregister_by_cookie(uint64_t cookie)
 		res = TEE_ERROR_BUSY;
 		goto out;
 	}
-	mf = find_in_list(&shm_inactive_head, cmp_cookie, cookie);
+	mf = find_cookie(b, &b->inactive, cookie);
 	/*
 	 * If the mobj isn't found or if it already has been unregistered.
 	 */
@@ -335,27 +424,29 @@ TEE_Result mobj_ffa_unregister_by_cookie(uint64_t cookie)
 		res = TEE_ERROR_ITEM_NOT_FOUND;
 		goto out;
 	}
-	mf = pop_from_list(&shm_inactive_head, cmp_cookie, cookie);
+	mf = pop_from_list(&b->inactive, cmp_ptr, (vaddr_t)mf);
+	b->len--;
 	mobj_ffa_spmc_delete(mf);
 	thread_spmc_relinquish(cookie);
 #endif
 	res = TEE_SUCCESS;
 
 out:
-	cpu_spin_unlock_xrestore(&shm_lock, exceptions);
+	cpu_spin_unlock_xrestore(&b->lock, exceptions);
 	return res;
 }
 
 struct mobj *mobj_ffa_get_by_cookie(uint64_t cookie,
 				    unsigned int internal_offs)
 {
+	struct ffa_shm_bucket *b = shm_bucket(cookie);
 	struct mobj_ffa *mf = NULL;
 	uint32_t exceptions = 0;
 
 	if (internal_offs >= SMALL_PAGE_SIZE)
 		return NULL;
-	exceptions = cpu_spin_lock_xsave(&shm_lock);
-	mf = find_in_list(&shm_head, cmp_cookie, cookie);
+	exceptions = cpu_spin_lock_xsave(&b->lock);
+	mf = find_cookie(b, &b->active, cookie);
 	if (mf) {
 		if (mf->page_offset == internal_offs) {
 			if (!refcount_inc(&mf->mobj.refc)) {
@@ -375,7 +466,11 @@ struct mobj *mobj_ffa_get_by_cookie(uint64_t cookie,
 			mf = NULL;
 		}
 	} else {
-		mf = pop_from_list(&shm_inactive_head, cmp_cookie, cookie);
+		mf = find_cookie(b, &b->inactive, cookie);
+		if (mf) {
+			SLIST_REMOVE(&b->inactive, mf, mobj_ffa, link);
+			b->len--;
+		}
 #if !defined(CFG_CORE_SEL1_SPMC)
 		/* Try to retrieve it from the SPM at S-EL2 */
 		if (mf) {
@@ -413,11 +508,12 @@ struct mobj *mobj_ffa_get_by_cookie(uint64_t cookie,
 			mf->mobj.size -= internal_offs;
 			mf->page_offset = internal_offs;
 
-			SLIST_INSERT_HEAD(&shm_head, mf, link);
+			SLIST_INSERT_HEAD(&b->active, mf, link);
+			b->len++;
 		}
 	}
 
-	cpu_spin_unlock_xrestore(&shm_lock, exceptions);
+	cpu_spin_unlock_xrestore(&b->lock, exceptions);
 
 	if (!mf) {
 		EMSG("Failed to get cookie %#"PRIx64" internal_offs %#x",
@@ -427,6 +523,26 @@ struct mobj *mobj_ffa_get_by_cookie(uint64_t cookie,
 	return &mf->mobj;
 }
 
+/* Returns the physical address of page @page_idx of the object */
+static paddr_t get_page_pa(struct mobj_ffa *mf, unsigned int page_idx)
+{
+	unsigned int lo = 0;
+	unsigned int hi = mf->range_count;
+	unsigned int mid = 0;
+
+	assert(mf->range_count);
+	while (hi - lo > 1) {
+		mid = lo + (hi - lo) / 2;
+		if (mf->ranges[mid].page_idx <= page_idx)
+			lo = mid;
+		else
+			hi = mid;
+	}
+
+	return mf->ranges[lo].pa +
+	       (page_idx - mf->ranges[lo].page_idx) * SMALL_PAGE_SIZE;
+}
+
 static TEE_Result ffa_get_pa(struct mobj *mobj, size_t offset,
 			     size_t granule, paddr_t *pa)
 {
@@ -443,11 +559,11 @@ static TEE_Result ffa_get_pa(struct mobj *mobj, size_t offset,
 	full_offset = offset + mf->page_offset;
 	switch (granule) {
 	case 0:
-		p = mf->pages[full_offset / SMALL_PAGE_SIZE] +
+		p = get_page_pa(mf, full_offset / SMALL_PAGE_SIZE) +
 		    (full_offset & SMALL_PAGE_MASK);
 		break;
 	case SMALL_PAGE_SIZE:
-		p = mf->pages[full_offset / SMALL_PAGE_SIZE];
+		p = get_page_pa(mf, full_offset / SMALL_PAGE_SIZE);
 		break;
 	default:
 		return TEE_ERROR_GENERIC;
@@ -478,13 +594,15 @@ static void *ffa_get_va(struct mobj *mobj, size_t offset, size_t len)
 static void ffa_inactivate(struct mobj *mobj)
 {
 	struct mobj_ffa *mf = to_mobj_ffa(mobj);
+	struct ffa_shm_bucket *b = shm_bucket(mf->cookie);
+	uint32_t map_exceptions = 0;
 	uint32_t exceptions = 0;
 
-	exceptions = cpu_spin_lock_xsave(&shm_lock);
+	exceptions = cpu_spin_lock_xsave(&b->lock);
 	/*
 	 * If refcount isn't 0 some other thread has found this mobj in
-	 * shm_head after the mobj_put() that put us here and before we got
-	 * the lock.
+	 * the active list after the mobj_put() that put us here and before
+	 * we got the lock.
 	 */
 	if (refcount_val(&mobj->refc)) {
 		DMSG("cookie %#"PRIx64" was resurrected", mf->cookie);
@@ -492,12 +610,14 @@ static void ffa_inactivate(struct mobj *mobj)
 	}
 
 	DMSG("cookie %#"PRIx64, mf->cookie);
-	if (!pop_from_list(&shm_head, cmp_ptr, (vaddr_t)mf))
+	if (!pop_from_list(&b->active, cmp_ptr, (vaddr_t)mf))
 		panic();
+	map_exceptions = cpu_spin_lock_xsave(&shm_lock);
 	unmap_helper(mf);
-	SLIST_INSERT_HEAD(&shm_inactive_head, mf, link);
+	cpu_spin_unlock_xrestore(&shm_lock, map_exceptions);
+	SLIST_INSERT_HEAD(&b->inactive, mf, link);
 out:
-	cpu_spin_unlock_xrestore(&shm_lock, exceptions);
+	cpu_spin_unlock_xrestore(&b->lock, exceptions);
 }
 
 static TEE_Result ffa_get_mem_type(struct mobj *mobj __unused, uint32_t *mt)
@@ -522,6 +642,32 @@ static uint64_t ffa_get_cookie(struct mobj *mobj)
 	return to_mobj_ffa(mobj)->cookie;
 }
 
+/* Maps the first @num_pages pages of the object at @va, range by range */
+static TEE_Result map_ranges(struct mobj_ffa *mf, vaddr_t va,
+			     size_t num_pages)
+{
+	struct mobj_ffa_range *r = NULL;
+	TEE_Result res = TEE_SUCCESS;
+	size_t mapped = 0;
+	size_t n = 0;
+
+	for (r = mf->ranges; mapped < num_pages; r++) {
+		assert(r < mf->ranges + mf->range_count);
+		n = MIN(num_pages - mapped, (size_t)r->page_count);
+		res = core_mmu_map_contiguous_pages(va + mapped *
+						    SMALL_PAGE_SIZE, r->pa, n,
+						    MEM_AREA_NSEC_SHM);
+		if (res) {
+			if (mapped)
+				core_mmu_unmap_pages(va, mapped);
+			return res;
+		}
+		mapped += n;
+	}
+
+	return TEE_SUCCESS;
+}
+
 static TEE_Result ffa_inc_map(struct mobj *mobj)
 {
 	TEE_Result res = TEE_SUCCESS;
@@ -556,9 +702,8 @@ static TEE_Result ffa_inc_map(struct mobj *mobj)
 			goto out;
 		}
 
-		res = core_mmu_map_pages(tee_mm_get_smem(mf->mm), mf->pages,
-					 sz / SMALL_PAGE_SIZE,
-					 MEM_AREA_NSEC_SHM);
+		res = map_ranges(mf, tee_mm_get_smem(mf->mm),
+				 sz / SMALL_PAGE_SIZE);
 		if (res) {
 			tee_mm_free(mf->mm);
 			mf->mm = NULL;
@@ -589,6 +734,29 @@ static TEE_Result ffa_dec_map(struct mobj *mobj)
 	return TEE_SUCCESS;
 }
 
+void mobj_ffa_get_cookie_stats(struct mobj_cookie_stats *stats, bool reset)
+{
+	struct ffa_shm_bucket *b = NULL;
+	uint32_t exceptions = 0;
+
+	*stats = (struct mobj_cookie_stats){
+		.buckets = ARRAY_SIZE(shm_buckets),
+	};
+
+	for (b = shm_buckets; b < shm_buckets + ARRAY_SIZE(shm_buckets); b++) {
+		exceptions = cpu_spin_lock_xsave(&b->lock);
+		stats->lookups += b->lookups;
+		stats->probes += b->probes;
+		stats->entries += b->len;
+		stats->max_chain = MAX(stats->max_chain, b->len);
+		if (reset) {
+			b->lookups = 0;
+			b->probes = 0;
+		}
+		cpu_spin_unlock_xrestore(&b->lock, exceptions);
+	}
+}
+
 static TEE_Result mapped_shm_init(void)
 {
 	vaddr_t pool_start = 0;
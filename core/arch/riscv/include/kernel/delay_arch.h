@@ -22,4 +22,14 @@ static inline bool timeout_elapsed(uint64_t expire)
 	return read_time() > expire;
 }
 
+static inline uint64_t timer_cnt_read(void)
+{
+	return read_time();
+}
+
+static inline uint64_t timer_cnt_freq(void)
+{
+	return CFG_RISCV_MTIME_RATE;
+}
+
 #endif /*__KERNEL_DELAY_ARCH_H*/
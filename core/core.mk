@@ -152,6 +152,12 @@ libdir = core/lib/zlib
 include mk/lib.mk
 endif
 
+ifeq ($(CFG_LZ4),y)
+libname = lz4
+libdir = core/lib/lz4
+include mk/lib.mk
+endif
+
 libname = unw
 libdir = lib/libunw
 include mk/lib.mk
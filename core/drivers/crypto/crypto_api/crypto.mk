@@ -0,0 +1,16 @@
+# Software reference backend of the crypto job queue, registered as the
+# cipher job queue. It executes the jobs with the software crypto library,
+# to exercise the queueing logic on platforms without crypto accelerator.
+# CFG_CRYPTO_DRV_JOB_SW_DEPTH is the number of slots of its emulated job ring.
+CFG_CRYPTO_DRV_JOB_SW ?= n
+CFG_CRYPTO_DRV_JOB_SW_DEPTH ?= 8
+
+ifeq ($(CFG_CRYPTO_DRV_JOB_SW),y)
+$(call force,CFG_CRYPTO_DRIVER,y,Mandated by CFG_CRYPTO_DRV_JOB_SW)
+$(call force,CFG_CRYPTO_DRV_JOB,y,Mandated by CFG_CRYPTO_DRV_JOB_SW)
+CFG_CRYPTO_DRIVER_DEBUG ?= 0
+endif
+
+# Asynchronous job queue interface of the crypto drivers, letting callers
+# keep several operations in flight on the hardware job rings.
+CFG_CRYPTO_DRV_JOB ?= n
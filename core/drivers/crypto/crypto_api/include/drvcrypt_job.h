@@ -0,0 +1,187 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2026, Linaro Limited
+ *
+ * Brief   Asynchronous job queue interface of the crypto drivers.
+ */
+#ifndef __DRVCRYPT_JOB_H__
+#define __DRVCRYPT_JOB_H__
+
+#include <drvcrypt.h>
+#include <kernel/mutex.h>
+#include <sys/queue.h>
+#include <tee_api_types.h>
+
+/*
+ * A job queue lets a caller have several crypto operations in flight and
+ * wait for their completion later, instead of blocking on each of them.
+ *
+ * The caller fills a struct drvcrypt_job and submits it with
+ * drvcrypt_job_submit(). The queue forwards up to @depth jobs to the
+ * backend (the hardware job ring), the others are kept in submission order
+ * until the backend completes a job. The backend reports each completion
+ * with drvcrypt_job_complete() and the caller collects the result with
+ * drvcrypt_job_wait().
+ *
+ * All functions must be called from thread context. Drivers completing jobs
+ * from an interrupt must defer drvcrypt_job_complete() to a bottom half,
+ * or implement the poll operation.
+ */
+
+enum drvcrypt_job_state {
+	DRVCRYPT_JOB_IDLE = 0,	/* Not submitted yet */
+	DRVCRYPT_JOB_QUEUED,	/* Waiting for a free backend slot */
+	DRVCRYPT_JOB_RUNNING,	/* Owned by the backend */
+	DRVCRYPT_JOB_DONE,	/* Completed, @res is valid */
+};
+
+struct drvcrypt_job_queue;
+
+/*
+ * Crypto job
+ *
+ * @data     Operation data, the type depends on the queue the job is
+ *           submitted to, see the backend documentation
+ * @done     Optional callback, called when the job completes, before
+ *           drvcrypt_job_wait() returns. Also called with the error in
+ *           @res if the backend fails to start the job.
+ * @priv     Free for use by the owner of the job
+ * @res      Result of the operation, valid once the job is done
+ * @state    State of the job
+ * @queue    Queue the job was submitted to
+ * @link     Link in the list of queued jobs
+ */
+struct drvcrypt_job {
+	void *data;
+	void (*done)(struct drvcrypt_job *job);
+	void *priv;
+	TEE_Result res;
+	enum drvcrypt_job_state state;
+	struct drvcrypt_job_queue *queue;
+	TAILQ_ENTRY(drvcrypt_job) link;
+};
+
+/*
+ * Data of a job submitted to the CRYPTO_CIPHER queue
+ *
+ * @ctx      Context of the generic cipher API, allocated with
+ *           crypto_cipher_alloc_ctx() and initialized with
+ *           crypto_cipher_init()
+ * @encrypt  True to encrypt, false to decrypt
+ * @last     True if this is the last update of the operation
+ * @src      Input data
+ * @dst      [out] Output data, at least @src.length bytes
+ */
+struct drvcrypt_job_cipher {
+	void *ctx;
+	bool encrypt;
+	bool last;
+	struct drvcrypt_buf src;
+	struct drvcrypt_buf dst;
+};
+
+/*
+ * Job queue backend operations
+ *
+ * @submit   Starts a job. Must not call drvcrypt_job_complete(), errors are
+ *           reported by the return value.
+ * @flush    Optional, called after a batch of jobs has been submitted, for
+ *           instance to ring the doorbell of the hardware once.
+ * @poll     Optional, completes the finished jobs when the backend has no
+ *           other way to do it. Called by the waiters.
+ */
+struct drvcrypt_job_queue_ops {
+	TEE_Result (*submit)(struct drvcrypt_job_queue *queue,
+			     struct drvcrypt_job *job);
+	void (*flush)(struct drvcrypt_job_queue *queue);
+	void (*poll)(struct drvcrypt_job_queue *queue);
+};
+
+/*
+ * Job queue statistics
+ *
+ * @submitted    Number of jobs submitted
+ * @completed    Number of jobs completed
+ * @batches      Number of batches of jobs passed to the backend
+ * @max_queued   Maximum number of jobs waiting for a backend slot
+ */
+struct drvcrypt_job_stats {
+	uint64_t submitted;
+	uint64_t completed;
+	uint64_t batches;
+	size_t max_queued;
+};
+
+struct drvcrypt_job_queue {
+	const struct drvcrypt_job_queue_ops *ops;
+	size_t depth;
+	size_t running;
+	size_t queued;
+	struct mutex mu;
+	struct condvar cv;
+	TAILQ_HEAD(, drvcrypt_job) jobs;
+	struct drvcrypt_job_stats stats;
+};
+
+/*
+ * Initialize a job queue
+ *
+ * @queue    Queue to initialize
+ * @ops      Backend operations
+ * @depth    Maximum number of jobs owned by the backend at the same time
+ */
+TEE_Result drvcrypt_job_queue_init(struct drvcrypt_job_queue *queue,
+				   const struct drvcrypt_job_queue_ops *ops,
+				   size_t depth);
+
+/*
+ * Submit a job, doesn't wait for its completion
+ *
+ * @queue    Job queue
+ * @job      Job to submit, must stay valid until it's done
+ */
+TEE_Result drvcrypt_job_submit(struct drvcrypt_job_queue *queue,
+			       struct drvcrypt_job *job);
+
+/*
+ * Wait for the completion of a submitted job and return its result
+ *
+ * @job      Submitted job
+ */
+TEE_Result drvcrypt_job_wait(struct drvcrypt_job *job);
+
+/*
+ * Report the completion of a job, called by the backend
+ *
+ * @job      Job owned by the backend
+ * @res      Result of the operation
+ */
+void drvcrypt_job_complete(struct drvcrypt_job *job, TEE_Result res);
+
+/*
+ * Get a copy of the queue statistics
+ *
+ * @queue    Job queue
+ * @stats    [out] Statistics
+ */
+void drvcrypt_job_get_stats(struct drvcrypt_job_queue *queue,
+			    struct drvcrypt_job_stats *stats);
+
+/*
+ * Register the job queue of a Cryptographic module
+ *
+ * @algo_id  ID of the Cryptographic module
+ * @queue    Job queue
+ */
+TEE_Result drvcrypt_register_job_queue(enum drvcrypt_algo_id algo_id,
+				       struct drvcrypt_job_queue *queue);
+
+/*
+ * Return the job queue registered for a Cryptographic module, NULL if none
+ *
+ * @algo_id  ID of the Cryptographic module
+ */
+struct drvcrypt_job_queue *
+drvcrypt_get_job_queue(enum drvcrypt_algo_id algo_id);
+
+#endif /* __DRVCRYPT_JOB_H__ */
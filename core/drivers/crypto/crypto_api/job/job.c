@@ -0,0 +1,206 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ *
+ * Brief   Asynchronous job queue of the crypto drivers.
+ */
+#include <assert.h>
+#include <drvcrypt.h>
+#include <drvcrypt_job.h>
+#include <kernel/mutex.h>
+#include <util.h>
+
+static struct drvcrypt_job_queue *job_queues[CRYPTO_MAX_ALGO];
+
+TAILQ_HEAD(job_list, drvcrypt_job);
+
+/*
+ * Pass queued jobs to the backend while it has free slots
+ * Called with the queue mutex held.
+ *
+ * @queue    Job queue
+ * @failed   [out] Jobs the backend refused, to be completed with
+ *           finish_jobs() once the queue mutex is released
+ */
+static void run_queued_jobs(struct drvcrypt_job_queue *queue,
+			    struct job_list *failed)
+{
+	struct drvcrypt_job *job = NULL;
+	TEE_Result res = TEE_ERROR_GENERIC;
+	bool submitted = false;
+
+	while (queue->running < queue->depth) {
+		job = TAILQ_FIRST(&queue->jobs);
+		if (!job)
+			break;
+
+		TAILQ_REMOVE(&queue->jobs, job, link);
+		queue->queued--;
+
+		job->state = DRVCRYPT_JOB_RUNNING;
+		res = queue->ops->submit(queue, job);
+		if (res) {
+			CRYPTO_TRACE("Job %p submission failed %#"PRIx32, job,
+				     res);
+			job->res = res;
+			queue->stats.completed++;
+			TAILQ_INSERT_TAIL(failed, job, link);
+			continue;
+		}
+
+		queue->running++;
+		submitted = true;
+	}
+
+	if (submitted) {
+		queue->stats.batches++;
+		if (queue->ops->flush)
+			queue->ops->flush(queue);
+	}
+}
+
+/*
+ * Run the callback of completed jobs and wake up their waiters
+ * Called without the queue mutex held.
+ *
+ * @queue    Job queue
+ * @jobs     Completed jobs, their result is already set
+ */
+static void finish_jobs(struct drvcrypt_job_queue *queue,
+			struct job_list *jobs)
+{
+	struct drvcrypt_job *job = NULL;
+
+	while ((job = TAILQ_FIRST(jobs))) {
+		TAILQ_REMOVE(jobs, job, link);
+
+		if (job->done)
+			job->done(job);
+
+		mutex_lock(&queue->mu);
+		job->state = DRVCRYPT_JOB_DONE;
+		condvar_broadcast(&queue->cv);
+		mutex_unlock(&queue->mu);
+	}
+}
+
+TEE_Result drvcrypt_job_queue_init(struct drvcrypt_job_queue *queue,
+				   const struct drvcrypt_job_queue_ops *ops,
+				   size_t depth)
+{
+	if (!queue || !ops || !ops->submit || !depth)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	*queue = (struct drvcrypt_job_queue){
+		.ops = ops,
+		.depth = depth,
+	};
+	mutex_init(&queue->mu);
+	condvar_init(&queue->cv);
+	TAILQ_INIT(&queue->jobs);
+
+	return TEE_SUCCESS;
+}
+
+TEE_Result drvcrypt_job_submit(struct drvcrypt_job_queue *queue,
+			       struct drvcrypt_job *job)
+{
+	struct job_list failed = TAILQ_HEAD_INITIALIZER(failed);
+
+	if (!queue || !job)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (job->state != DRVCRYPT_JOB_IDLE && job->state != DRVCRYPT_JOB_DONE)
+		return TEE_ERROR_BAD_STATE;
+
+	mutex_lock(&queue->mu);
+
+	job->queue = queue;
+	job->res = TEE_ERROR_GENERIC;
+	job->state = DRVCRYPT_JOB_QUEUED;
+	TAILQ_INSERT_TAIL(&queue->jobs, job, link);
+	queue->queued++;
+	queue->stats.submitted++;
+	queue->stats.max_queued = MAX(queue->stats.max_queued, queue->queued);
+
+	run_queued_jobs(queue, &failed);
+
+	mutex_unlock(&queue->mu);
+
+	finish_jobs(queue, &failed);
+
+	return TEE_SUCCESS;
+}
+
+void drvcrypt_job_complete(struct drvcrypt_job *job, TEE_Result res)
+{
+	struct drvcrypt_job_queue *queue = job->queue;
+	struct job_list done = TAILQ_HEAD_INITIALIZER(done);
+
+	assert(job->state == DRVCRYPT_JOB_RUNNING);
+
+	mutex_lock(&queue->mu);
+	assert(queue->running);
+	queue->running--;
+	queue->stats.completed++;
+	job->res = res;
+	TAILQ_INSERT_HEAD(&done, job, link);
+	/* Refill the backend before running the callback of this job */
+	run_queued_jobs(queue, &done);
+	mutex_unlock(&queue->mu);
+
+	finish_jobs(queue, &done);
+}
+
+TEE_Result drvcrypt_job_wait(struct drvcrypt_job *job)
+{
+	struct drvcrypt_job_queue *queue = NULL;
+
+	if (!job || !job->queue || job->state == DRVCRYPT_JOB_IDLE)
+		return TEE_ERROR_BAD_STATE;
+
+	queue = job->queue;
+
+	mutex_lock(&queue->mu);
+	while (job->state != DRVCRYPT_JOB_DONE) {
+		if (queue->ops->poll) {
+			mutex_unlock(&queue->mu);
+			queue->ops->poll(queue);
+			mutex_lock(&queue->mu);
+		} else {
+			condvar_wait(&queue->cv, &queue->mu);
+		}
+	}
+	mutex_unlock(&queue->mu);
+
+	return job->res;
+}
+
+void drvcrypt_job_get_stats(struct drvcrypt_job_queue *queue,
+			    struct drvcrypt_job_stats *stats)
+{
+	mutex_lock(&queue->mu);
+	*stats = queue->stats;
+	mutex_unlock(&queue->mu);
+}
+
+TEE_Result drvcrypt_register_job_queue(enum drvcrypt_algo_id algo_id,
+				       struct drvcrypt_job_queue *queue)
+{
+	if (algo_id >= CRYPTO_MAX_ALGO || job_queues[algo_id])
+		return TEE_ERROR_GENERIC;
+
+	CRYPTO_TRACE("Registering job queue id %d with 0x%p", algo_id, queue);
+	job_queues[algo_id] = queue;
+
+	return TEE_SUCCESS;
+}
+
+struct drvcrypt_job_queue *
+drvcrypt_get_job_queue(enum drvcrypt_algo_id algo_id)
+{
+	if (algo_id >= CRYPTO_MAX_ALGO)
+		return NULL;
+
+	return job_queues[algo_id];
+}
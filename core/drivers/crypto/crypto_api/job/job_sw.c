@@ -0,0 +1,132 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ *
+ * Brief   Software reference backend of the crypto job queue.
+ *
+ * The backend mimics a hardware job ring: submitted jobs are written in a
+ * ring of CFG_CRYPTO_DRV_JOB_SW_DEPTH slots, become visible to the
+ * "hardware" when the queue flushes the batch, and are executed with the
+ * synchronous crypto API when a waiter polls the queue.
+ *
+ * It is registered as the CRYPTO_CIPHER job queue, the job data is a
+ * struct drvcrypt_job_cipher.
+ */
+#include <assert.h>
+#include <crypto/crypto.h>
+#include <drvcrypt.h>
+#include <drvcrypt_job.h>
+#include <initcall.h>
+#include <kernel/mutex.h>
+#include <kernel/spinlock.h>
+#include <util.h>
+
+struct sw_ring {
+	unsigned int lock;
+	struct drvcrypt_job *slots[CFG_CRYPTO_DRV_JOB_SW_DEPTH];
+	size_t head;		/* Oldest job */
+	size_t count;		/* Jobs in the ring */
+	size_t posted;		/* Jobs visible to the executor */
+};
+
+static struct drvcrypt_job_queue sw_queue;
+static struct sw_ring sw_ring = { .lock = SPINLOCK_UNLOCK };
+/* Serializes the execution of the jobs, they may share a crypto context */
+static struct mutex sw_exec_mu = MUTEX_INITIALIZER;
+
+static TEE_Result sw_submit(struct drvcrypt_job_queue *queue __unused,
+			    struct drvcrypt_job *job)
+{
+	struct drvcrypt_job_cipher *cjob = job->data;
+	uint32_t exceptions = 0;
+	size_t idx = 0;
+
+	if (!cjob || !cjob->ctx || cjob->dst.length < cjob->src.length)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	exceptions = cpu_spin_lock_xsave(&sw_ring.lock);
+	/* The queue never submits more than the depth of the ring */
+	assert(sw_ring.count < ARRAY_SIZE(sw_ring.slots));
+	idx = (sw_ring.head + sw_ring.count) % ARRAY_SIZE(sw_ring.slots);
+	sw_ring.slots[idx] = job;
+	sw_ring.count++;
+	cpu_spin_unlock_xrestore(&sw_ring.lock, exceptions);
+
+	return TEE_SUCCESS;
+}
+
+static void sw_flush(struct drvcrypt_job_queue *queue __unused)
+{
+	uint32_t exceptions = cpu_spin_lock_xsave(&sw_ring.lock);
+
+	sw_ring.posted = sw_ring.count;
+	cpu_spin_unlock_xrestore(&sw_ring.lock, exceptions);
+}
+
+static struct drvcrypt_job *sw_pop(void)
+{
+	uint32_t exceptions = cpu_spin_lock_xsave(&sw_ring.lock);
+	struct drvcrypt_job *job = NULL;
+
+	if (sw_ring.posted) {
+		job = sw_ring.slots[sw_ring.head];
+		sw_ring.head = (sw_ring.head + 1) % ARRAY_SIZE(sw_ring.slots);
+		sw_ring.count--;
+		sw_ring.posted--;
+	}
+	cpu_spin_unlock_xrestore(&sw_ring.lock, exceptions);
+
+	return job;
+}
+
+static TEE_Result sw_run(struct drvcrypt_job *job)
+{
+	struct drvcrypt_job_cipher *cjob = job->data;
+	TEE_OperationMode mode = TEE_MODE_DECRYPT;
+
+	if (cjob->encrypt)
+		mode = TEE_MODE_ENCRYPT;
+
+	return crypto_cipher_update(cjob->ctx, mode, cjob->last,
+				    cjob->src.data, cjob->src.length,
+				    cjob->dst.data);
+}
+
+static void sw_poll(struct drvcrypt_job_queue *queue __unused)
+{
+	struct drvcrypt_job *job = NULL;
+	TEE_Result res = TEE_ERROR_GENERIC;
+
+	while (true) {
+		mutex_lock(&sw_exec_mu);
+		job = sw_pop();
+		if (job)
+			res = sw_run(job);
+		mutex_unlock(&sw_exec_mu);
+
+		if (!job)
+			break;
+
+		drvcrypt_job_complete(job, res);
+	}
+}
+
+static const struct drvcrypt_job_queue_ops sw_queue_ops = {
+	.submit = sw_submit,
+	.flush = sw_flush,
+	.poll = sw_poll,
+};
+
+static TEE_Result drvcrypt_job_sw_init(void)
+{
+	TEE_Result res = TEE_ERROR_GENERIC;
+
+	res = drvcrypt_job_queue_init(&sw_queue, &sw_queue_ops,
+				      ARRAY_SIZE(sw_ring.slots));
+	if (res)
+		return res;
+
+	return drvcrypt_register_job_queue(CRYPTO_CIPHER, &sw_queue);
+}
+
+driver_init(drvcrypt_job_sw_init);
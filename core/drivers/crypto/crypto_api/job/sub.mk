@@ -0,0 +1,2 @@
+srcs-y += job.c
+srcs-$(CFG_CRYPTO_DRV_JOB_SW) += job_sw.c
@@ -8,3 +8,4 @@ subdirs-$(CFG_CRYPTO_DRV_ACIPHER) += oid
 subdirs-$(CFG_CRYPTO_DRV_CIPHER) += cipher
 subdirs-$(CFG_CRYPTO_DRV_MAC) += mac
 subdirs-$(CFG_CRYPTO_DRV_AUTHENC) += authenc
+subdirs-$(CFG_CRYPTO_DRV_JOB) += job
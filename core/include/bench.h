@@ -6,10 +6,13 @@
 #ifndef BENCH_H
 #define BENCH_H
 
+#include <compiler.h>
 #include <inttypes.h>
 #include <mm/core_memprot.h>
 #include <mm/core_mmu.h>
 #include <optee_msg.h>
+#include <optee_rpc_cmd.h>
+#include <pta_benchmark.h>
 
 /*
  * Cycle count divider is enabled (in PMCR),
@@ -51,10 +54,35 @@ struct tee_ts_global {
 	struct tee_ts_cpu_buf cpu_buf[];
 };
 
+/*
+ * Latency tracepoints: a traced path starts with
+ *	uint64_t begin = bm_tp_begin();
+ * and ends with bm_tp_end(BENCHMARK_TP_xxx, begin). The duration is added
+ * to the histogram of the tracepoint and recorded as an event attributed
+ * to the current TA session, or to @session with bm_tp_end_session().
+ */
+/* Returns the tracepoint ID of an RPC with command @cmd */
+static inline unsigned int bm_tp_rpc_id(uint32_t cmd)
+{
+	if (cmd == OPTEE_RPC_CMD_FS || cmd == OPTEE_RPC_CMD_RPMB)
+		return BENCHMARK_TP_STORAGE_RPC;
+	return BENCHMARK_TP_RPC;
+}
+
 #ifdef CFG_TEE_BENCHMARK
 void bm_timestamp(void);
+/* Returns the start time stamp of a path, 0 if tracepoints are disabled */
+uint64_t bm_tp_begin(void);
+void bm_tp_end(unsigned int tp, uint64_t begin);
+void bm_tp_end_session(unsigned int tp, uint64_t begin, uint32_t session);
 #else
 static inline void bm_timestamp(void) {}
+static inline uint64_t bm_tp_begin(void) { return 0; }
+static inline void bm_tp_end(unsigned int tp __unused,
+			     uint64_t begin __unused) {}
+static inline void bm_tp_end_session(unsigned int tp __unused,
+				     uint64_t begin __unused,
+				     uint32_t session __unused) {}
 #endif /* CFG_TEE_BENCHMARK */
 
 #endif /* BENCH_H */
@@ -37,4 +37,16 @@
 void udelay(uint32_t us);
 void mdelay(uint32_t ms);
 
+/*
+ * timer_cnt_read() returns the free running counter of the architecture,
+ * ticking at timer_cnt_freq() Hz. timer_cnt_to_ns() converts a number of
+ * ticks into nanoseconds.
+ */
+static inline uint64_t timer_cnt_to_ns(uint64_t cnt)
+{
+	uint64_t freq = timer_cnt_freq();
+
+	return (cnt / freq) * 1000000000 + (cnt % freq) * 1000000000 / freq;
+}
+
 #endif
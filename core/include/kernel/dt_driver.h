@@ -70,6 +70,30 @@ struct dt_driver {
 	     drv < SCATTERED_ARRAY_END(dt_drivers, struct dt_driver); \
 	     drv++)
 
+/*
+ * struct dt_driver_match - Compatible string matching a DT driver
+ *
+ * @drv: Matching driver
+ * @dm: Entry of @drv match table holding the compatible string
+ */
+struct dt_driver_match {
+	const struct dt_driver *drv;
+	const struct dt_device_match *dm;
+};
+
+/*
+ * dt_driver_find_matches - Find the DT drivers matching a compatible string
+ *
+ * @compat: Compatible string to look for
+ * @matches: Output reference to the first match found
+ *
+ * Return the number of matches stored from @matches, in the order of the
+ * drivers in the scattered array and of the entries in their match tables.
+ * The lookup uses an index of all the match tables built on first call.
+ */
+size_t dt_driver_find_matches(const char *compat,
+			      const struct dt_driver_match **matches);
+
 /* Opaque reference to DT driver device provider instance */
 struct dt_driver_provider;
 
@@ -12,11 +12,26 @@
 #include <tee_api_types.h>
 #include <util.h>
 
+/* Compression formats of an embedded TS */
+#define EMB_TS_COMPRESS_DEFLATE	0
+#define EMB_TS_COMPRESS_LZ4	1
+
+/*
+ * An LZ4 compressed TS is a sequence of chunks each decompressing to
+ * EMB_TS_LZ4_CHUNK_SIZE bytes, except the last one. A chunk is a 32-bit
+ * little endian header followed by the chunk data: bits 0-30 of the header
+ * are the size of the data, if bit 31 is set the data is stored
+ * uncompressed else it's an LZ4 block. Must match scripts/ts_bin_to_c.py.
+ */
+#define EMB_TS_LZ4_CHUNK_SIZE	(32 * 1024)
+#define EMB_TS_LZ4_CHUNK_RAW	BIT32(31)
+
 struct embedded_ts {
 	uint32_t flags;
 	TEE_UUID uuid;
 	uint32_t size;
 	uint32_t uncompressed_size; /* 0: not compressed */
+	uint32_t compression; /* EMB_TS_COMPRESS_*, if compressed */
 	const uint8_t *ts; /* @size bytes */
 };
 
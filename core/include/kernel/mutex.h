@@ -14,6 +14,7 @@ struct mutex {
 	unsigned spin_lock;	/* used when operating on this struct */
 	struct wait_queue wq;
 	short state;		/* -1: write, 0: unlocked, > 0: readers */
+	short owner;		/* thread holding the write lock */
 };
 
 #define MUTEX_INITIALIZER { .wq = WAIT_QUEUE_INITIALIZER }
@@ -101,5 +102,21 @@ void condvar_broadcast(struct condvar *cv);
 void condvar_wait(struct condvar *cv, struct mutex *m);
 #endif
 
+/*
+ * struct mutex_stats - statistics of the contended mutexes
+ * @contended:		Lock attempts finding the mutex write locked
+ * @spin_acquired:	Locks taken after spinning, without sleeping
+ * @sleeps:		Times a thread slept waiting for a mutex
+ *
+ * Counted for all mutexes since the last reset.
+ */
+struct mutex_stats {
+	uint32_t contended;
+	uint32_t spin_acquired;
+	uint32_t sleeps;
+};
+
+void mutex_get_stats(struct mutex_stats *stats, bool reset);
+
 #endif /*KERNEL_MUTEX_H*/
 
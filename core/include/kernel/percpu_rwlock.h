@@ -0,0 +1,49 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+#ifndef __KERNEL_PERCPU_RWLOCK_H
+#define __KERNEL_PERCPU_RWLOCK_H
+
+#include <kernel/mutex.h>
+#include <types_ext.h>
+
+/*
+ * Reader-writer lock for read-mostly data such as registries looked up
+ * on every request and seldom updated.
+ *
+ * A reader only increments a counter in a cache line of its own CPU, so
+ * readers on different CPUs don't bounce a shared cache line the way
+ * mutex_read_lock() does. A writer is serialized by @mu, raises @writer
+ * and waits for the sum of the reader counters to drop to zero. Readers
+ * finding @writer raised wait on @mu for the writer to be done.
+ *
+ * A thread may migrate to another CPU while holding the read lock, it
+ * then decrements the counter of that CPU: only the sum of the counters
+ * is meaningful.
+ *
+ * The writer busy waits for the readers, read sections must be short and
+ * must not sleep: no mutex may be taken and no RPC may be done while
+ * holding the read lock. Write sections may sleep.
+ */
+struct percpu_rwlock_count {
+	unsigned int readers;
+} __aligned(1 << CFG_MAX_CACHE_LINE_SHIFT);
+
+struct percpu_rwlock {
+	struct mutex mu;
+	unsigned int writer;
+	struct percpu_rwlock_count count[CFG_TEE_CORE_NB_CORE];
+};
+
+#define PERCPU_RWLOCK_INITIALIZER { .mu = MUTEX_INITIALIZER }
+
+void percpu_rwlock_init(struct percpu_rwlock *rw);
+
+void percpu_rwlock_read_lock(struct percpu_rwlock *rw);
+void percpu_rwlock_read_unlock(struct percpu_rwlock *rw);
+
+void percpu_rwlock_write_lock(struct percpu_rwlock *rw);
+void percpu_rwlock_write_unlock(struct percpu_rwlock *rw);
+
+#endif /*__KERNEL_PERCPU_RWLOCK_H*/
@@ -0,0 +1,65 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#ifndef __KERNEL_SAMPLE_PROF_H
+#define __KERNEL_SAMPLE_PROF_H
+
+#include <compiler.h>
+#include <tee_api_types.h>
+#include <types_ext.h>
+
+/*
+ * System-wide sampling profiler
+ *
+ * Each time a thread is suspended by a foreign interrupt, the interrupted
+ * PC and call stack are recorded in a per-CPU buffer. The samples are read
+ * back by the gprof pseudo TA as a stream of perf records (struct
+ * perf_event_header followed by the PERF_SAMPLE_IP | PERF_SAMPLE_TID |
+ * PERF_SAMPLE_TIME | PERF_SAMPLE_CPU | PERF_SAMPLE_CALLCHAIN fields), see
+ * PTA_GPROF_READ_SYS_SAMPLES.
+ */
+
+/* Maximum number of entries of a recorded call stack, including the PC */
+#define SAMPLE_PROF_MAX_DEPTH	16
+
+#ifdef CFG_CORE_SAMPLING_PROFILER
+/*
+ * Starts sampling, discarding any sample not read yet. @max_depth limits the
+ * number of entries recorded per call stack, 1 means only the PC.
+ */
+TEE_Result sample_prof_start(unsigned int max_depth);
+void sample_prof_stop(void);
+
+/*
+ * Moves as many samples as fit in @buf to @buf in the perf record format
+ * and updates @len with the number of bytes written. Returns
+ * TEE_ERROR_SHORT_BUFFER with the needed size in @len if a sample is
+ * pending but @buf can't hold it.
+ */
+TEE_Result sample_prof_read(void *buf, size_t *len);
+
+/* Returns the current maximum call stack depth, 0 if sampling is stopped */
+unsigned int sample_prof_max_depth(void);
+
+/*
+ * Records a sample of the current thread. @ips[0] is the interrupted PC and
+ * @ips[1..@num_ips - 1] the return addresses of the call stack.
+ * Called with exceptions masked.
+ */
+void sample_prof_add(bool user, const vaddr_t *ips, size_t num_ips);
+#else
+static inline unsigned int sample_prof_max_depth(void)
+{
+	return 0;
+}
+
+static inline void sample_prof_add(bool user __unused,
+				   const vaddr_t *ips __unused,
+				   size_t num_ips __unused)
+{
+}
+#endif
+
+#endif /*__KERNEL_SAMPLE_PROF_H*/
@@ -78,6 +78,8 @@ struct tee_ta_ctx {
 
 struct tee_ta_session {
 	TAILQ_ENTRY(tee_ta_session) link;
+	LIST_ENTRY(tee_ta_session) hash_link;	/* Link in the ID index */
+	struct tee_ta_session_head *open_sessions; /* List holding @link */
 	struct ts_session ts_sess;
 	uint32_t id;		/* Session handle (0 is invalid) */
 	TEE_Identity clnt_id;	/* Identify of client */
@@ -105,6 +105,13 @@ short int thread_get_id(void);
  */
 short int thread_get_id_may_fail(void);
 
+/*
+ * Returns true if thread @thread_id is executing on a core, that is, not
+ * free nor suspended in normal world. The result may be outdated as soon
+ * as it's returned.
+ */
+bool thread_is_active(short int thread_id);
+
 /* Returns Thread Specific Data (TSD) pointer. */
 struct thread_specific_data *thread_get_tsd(void);
 
@@ -380,13 +387,60 @@ enum thread_shm_cache_user {
 
 /*
  * Returns a pointer to the cached RPC memory. Each thread and @user tuple
- * has a unique cache. The pointer is guaranteed to point to a large enough
- * area or to be NULL.
+ * has a unique cache of up to CFG_THREAD_SHM_CACHE_SLOTS buffers of
+ * different sizes. The pointer is guaranteed to point to a large enough
+ * area or to be NULL, it stays valid until the end of the standard call
+ * unless the same @user needs a buffer that isn't cached.
  */
 void *thread_rpc_shm_cache_alloc(enum thread_shm_cache_user user,
 				 enum thread_shm_type shm_type,
 				 size_t size, struct mobj **mobj);
 
+/*
+ * struct thread_shm_cache_stats - statistics of the RPC shared memory cache
+ * @hits:	Allocations served by a buffer cached by the thread
+ * @pool_hits:	Allocations served by a buffer kept from a previous call
+ * @rpc_allocs:	Buffers allocated with an RPC to normal world
+ * @rpc_frees:	Buffers freed with an RPC to normal world
+ * @pooled:	Buffers currently kept between calls
+ */
+struct thread_shm_cache_stats {
+	uint32_t hits;
+	uint32_t pool_hits;
+	uint32_t rpc_allocs;
+	uint32_t rpc_frees;
+	uint32_t pooled;
+};
+
+void thread_rpc_shm_cache_get_stats(struct thread_shm_cache_stats *stats);
+
+/*
+ * struct thread_pool_stats - statistics of the thread pool
+ * @allocs:		Standard calls given a thread
+ * @limit_hits:		Standard calls refused for lack of a free thread or
+ *			of memory for its stack
+ * @stack_allocs:	Thread stacks allocated from the heap
+ * @stack_frees:	Thread stacks given back to the heap
+ * @stack_alloc_fails:	Thread stacks which couldn't be allocated
+ * @max_active:		Most threads in use at the same time
+ * @stacks:		Threads currently having a stack
+ * @threads:		Maximum number of threads
+ *
+ * All but @stacks and @threads are counted since the last reset.
+ */
+struct thread_pool_stats {
+	uint64_t allocs;
+	uint64_t limit_hits;
+	uint32_t stack_allocs;
+	uint32_t stack_frees;
+	uint32_t stack_alloc_fails;
+	uint32_t max_active;
+	uint32_t stacks;
+	uint32_t threads;
+};
+
+void thread_get_pool_stats(struct thread_pool_stats *stats, bool reset);
+
 #endif /*__ASSEMBLER__*/
 
 #endif /*KERNEL_THREAD_H*/
@@ -87,7 +87,36 @@ void thread_check_canaries(void);
 void thread_lock_global(void);
 void thread_unlock_global(void);
 
-/* Frees the cache of allocated FS RPC memory */
-void thread_rpc_shm_cache_clear(struct thread_shm_cache *cache);
+/*
+ * Marks a free thread as active and returns its ID, or THREAD_ID_INVALID
+ * if all threads are in use. With CFG_CORE_THREAD_POOL a stack is
+ * allocated for the thread if it doesn't have one.
+ */
+int thread_state_alloc(void);
+
+/*
+ * Gives back the heap stack of a free thread if enough threads with a
+ * stack are idle. Called on the temporary stack once a thread is freed.
+ */
+#ifdef CFG_CORE_THREAD_POOL
+void thread_pool_shrink(void);
+#else
+static inline void thread_pool_shrink(void)
+{
+}
+#endif
+
+/*
+ * Frees the cache of allocated RPC memory. With @keep, kernel private
+ * buffers are kept registered in a pool shared by the threads, as long as
+ * the pool has room for them.
+ */
+void thread_rpc_shm_cache_clear(struct thread_shm_cache *cache, bool keep);
+
+/*
+ * Removes a buffer from the pool of kept buffers and returns its cookie,
+ * for normal world to free it. Returns false if the pool is empty.
+ */
+bool thread_rpc_shm_cache_pop_pool(uint64_t *cookie);
 #endif /*__ASSEMBLER__*/
 #endif /*__KERNEL_THREAD_PRIVATE_H*/
@@ -0,0 +1,31 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#ifndef __KERNEL_TRACE_EXT_H
+#define __KERNEL_TRACE_EXT_H
+
+#ifdef CFG_CORE_ASYNC_TRACE
+/*
+ * Called when a standard call returns to normal world, requests a bottom
+ * half to print the messages buffered by all CPUs, if any.
+ */
+void trace_ext_request_drain(void);
+
+/*
+ * Prints all the buffered messages and writes the following messages
+ * directly to the console. Used before a panic.
+ */
+void trace_ext_sync(void);
+#else
+static inline void trace_ext_request_drain(void)
+{
+}
+
+static inline void trace_ext_sync(void)
+{
+}
+#endif
+
+#endif /*__KERNEL_TRACE_EXT_H*/
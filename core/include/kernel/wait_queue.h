@@ -6,20 +6,28 @@
 #define KERNEL_WAIT_QUEUE_H
 
 #include <types_ext.h>
-#include <sys/queue.h>
 
-struct wait_queue_elem;
-SLIST_HEAD(wait_queue, wait_queue_elem);
+/*
+ * A FIFO of waiters, doubly linked to append and remove in constant time.
+ * @lock protects only this wait queue.
+ */
+struct wait_queue {
+	unsigned int lock;
+	struct wait_queue_elem *first;
+	struct wait_queue_elem *last;
+};
 
-#define WAIT_QUEUE_INITIALIZER { .slh_first = NULL }
+#define WAIT_QUEUE_INITIALIZER { .first = NULL }
 
 struct condvar;
 struct wait_queue_elem {
 	short handle;
 	bool done;
 	bool wait_read;
+	bool handoff;	/* Woken up as the new owner of the sync object */
 	struct condvar *cv;
-	SLIST_ENTRY(wait_queue_elem) link;
+	struct wait_queue_elem *next;
+	struct wait_queue_elem *prev;
 };
 
 /*
@@ -52,6 +60,28 @@ void wq_wait_final(struct wait_queue *wq, struct wait_queue_elem *wqe,
 void wq_wake_next(struct wait_queue *wq, const void *sync_obj,
 		const char *fname, int lineno);
 
+/*
+ * Selects the first waiter to wake up, if it's a writer it's marked as
+ * the new owner of the sync object (wqe->handoff) and its handle is
+ * returned, else -1 is returned and nothing is changed. Called with the
+ * lock of the sync object held, the caller must then wake the returned
+ * waiter with wq_wake_handle() once it has released that lock.
+ *
+ * Handing over the sync object avoids waking a waiter which could find it
+ * taken again and would have to go back to sleep.
+ */
+int wq_handoff_next(struct wait_queue *wq);
+
+/* Wakes up the waiter returned by wq_handoff_next() */
+void wq_wake_handle(int handle, const void *sync_obj, const char *fname,
+		    int lineno);
+
+/*
+ * Returns true if a writer is waiting to be woken up. Called with the lock
+ * of the sync object held.
+ */
+bool wq_have_writer(struct wait_queue *wq);
+
 /* Returns true if the wait queue doesn't contain any elements */
 bool wq_is_empty(struct wait_queue *wq);
 
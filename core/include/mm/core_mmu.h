@@ -451,6 +451,40 @@ static inline vaddr_t core_mmu_idx2va(struct core_mmu_table_info *tbl_info,
 	return (idx << tbl_info->shift) + tbl_info->va_base;
 }
 
+/*
+ * core_mmu_user_contig_attr() - Attributes of an entry mapping user memory
+ * @tbl_info:	Translation table properties
+ * @idx:	Index of the entry
+ * @first:	Index of the first entry of a range mapping physically
+ *		contiguous memory with the same attributes
+ * @end:	Index following the last entry of the range
+ * @pa:		Physical address mapped by entry @idx
+ * @attr:	Attributes of the range
+ *
+ * With CFG_CORE_MMU_USER_CONTIG_HINT=y, TEE_MATTR_CONTIGUOUS is added if
+ * the aligned group of CORE_MMU_CONTIG_ENTRIES entries holding @idx is
+ * entirely inside the range and @pa is aligned like the virtual address.
+ * The table must be aligned on the size mapped by such a group.
+ * @returns the attributes to write in entry @idx
+ */
+static inline uint32_t
+core_mmu_user_contig_attr(struct core_mmu_table_info *tbl_info __maybe_unused,
+			  unsigned int idx __maybe_unused,
+			  unsigned int first __maybe_unused,
+			  unsigned int end __maybe_unused,
+			  paddr_t pa __maybe_unused, uint32_t attr)
+{
+#ifdef CFG_CORE_MMU_USER_CONTIG_HINT
+	unsigned int group = ROUNDDOWN(idx, CORE_MMU_CONTIG_ENTRIES);
+	unsigned int mask = CORE_MMU_CONTIG_ENTRIES - 1;
+
+	if (group >= first && group + CORE_MMU_CONTIG_ENTRIES <= end &&
+	    ((pa >> tbl_info->shift) & mask) == (idx & mask))
+		return attr | TEE_MATTR_CONTIGUOUS;
+#endif
+	return attr;
+}
+
 /*
  * core_mmu_get_block_offset() - Get offset inside a block/page
  * @tbl_info:	Translation table properties
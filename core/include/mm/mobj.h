@@ -232,7 +232,47 @@ struct mobj *mobj_mm_alloc(struct mobj *mobj_parent, size_t size,
 struct mobj *mobj_phys_alloc(paddr_t pa, size_t size, uint32_t cattr,
 			     enum buf_is_attr battr);
 
+/*
+ * struct mobj_cookie_stats - statistics of the lookups of shared memory
+ * objects by cookie
+ * @lookups:	Number of lookups since the last reset
+ * @probes:	Number of objects compared with the cookie by these lookups
+ * @entries:	Number of objects currently indexed
+ * @max_chain:	Number of objects in the most loaded hash bucket
+ * @buckets:	Number of hash buckets
+ */
+struct mobj_cookie_stats {
+	uint64_t lookups;
+	uint64_t probes;
+	uint32_t entries;
+	uint32_t max_chain;
+	uint32_t buckets;
+};
+
+/*
+ * mobj_cookie_hash() - hash a shared memory cookie
+ * @cookie:	Cookie supplied by normal world or the SPMC
+ * @bits:	Number of bits of the returned hash
+ *
+ * Cookies are either kernel addresses of the normal world driver or small
+ * handles with a few high bits set, both are folded and mixed with a
+ * multiplicative hash.
+ */
+static inline size_t mobj_cookie_hash(uint64_t cookie, unsigned int bits)
+{
+	uint32_t h = (uint32_t)cookie ^ (uint32_t)(cookie >> 32);
+
+	return (uint32_t)(h * 0x9e3779b1U) >> (32 - bits);
+}
+
 #if defined(CFG_CORE_FFA)
+/**
+ * mobj_ffa_get_cookie_stats() - get the statistics of the FF-A cookie index
+ * @stats:	[out] Statistics
+ * @reset:	Clear the lookup counters once read
+ */
+void mobj_ffa_get_cookie_stats(struct mobj_cookie_stats *stats, bool reset);
+
 struct mobj *mobj_ffa_get_by_cookie(uint64_t cookie,
 				    unsigned int internal_offs);
 
@@ -240,11 +280,13 @@ TEE_Result mobj_ffa_unregister_by_cookie(uint64_t cookie);
 
 /* Functions for SPMC */
 #ifdef CFG_CORE_SEL1_SPMC
-struct mobj_ffa *mobj_ffa_sel1_spmc_new(unsigned int num_pages);
+struct mobj_ffa *mobj_ffa_sel1_spmc_new(unsigned int num_pages,
+					unsigned int num_ranges);
 void mobj_ffa_sel1_spmc_delete(struct mobj_ffa *mobj);
 TEE_Result mobj_ffa_sel1_spmc_reclaim(uint64_t cookie);
 #else
-struct mobj_ffa *mobj_ffa_spmc_new(uint64_t cookie, unsigned int num_pages);
+struct mobj_ffa *mobj_ffa_spmc_new(uint64_t cookie, unsigned int num_pages,
+				   unsigned int num_ranges);
 void mobj_ffa_spmc_delete(struct mobj_ffa *mobj);
 #endif
 
@@ -272,6 +314,15 @@ struct mobj *mobj_reg_shm_get_by_cookie(uint64_t cookie);
 
 TEE_Result mobj_reg_shm_release_by_cookie(uint64_t cookie);
 
+/**
+ * mobj_reg_shm_get_cookie_stats() - get the statistics of the registered
+ *				     shared memory cookie index
+ * @stats:	[out] Statistics
+ * @reset:	Clear the lookup counters once read
+ */
+void mobj_reg_shm_get_cookie_stats(struct mobj_cookie_stats *stats,
+				   bool reset);
+
 /**
  * mobj_reg_shm_unguard() - unguards a reg_shm
  * @mobj:	pointer to a registered shared memory mobj
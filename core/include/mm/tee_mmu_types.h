@@ -51,6 +51,12 @@
 #define TEE_MATTR_MEM_TYPE_TAGGED	U(3)
 
 #define TEE_MATTR_GUARDED		BIT(15)
+/*
+ * The entry is part of a group of CORE_MMU_CONTIG_ENTRIES entries mapping
+ * contiguous physical memory with the same attributes, the group may be
+ * cached in a single TLB entry. Only set when writing translation tables.
+ */
+#define TEE_MATTR_CONTIGUOUS		BIT(16)
 
 /*
  * Tags TA mappings which are only used during a single call (open session
@@ -355,6 +355,28 @@
  */
 #define OPTEE_RPC_SOCKET_IOCTL	U(5)
 
+/*
+ * Run a batch of send and receive operations
+ *
+ * [in]     value[0].a	    OPTEE_RPC_SOCKET_BATCH
+ * [in]     value[0].b	    TA instance id
+ * [in/out] memref[1]	    Operations
+ * [in]     value[2].a	    Timeout ms or OPTEE_RPC_SOCKET_TIMEOUT_*
+ * [in]     value[2].b	    Number of operations
+ *
+ * Each operation is a header of four 32-bit words followed by a payload
+ * padded to a multiple of 8 bytes:
+ * word 0   [in]    OPTEE_RPC_SOCKET_SEND or OPTEE_RPC_SOCKET_RECV
+ * word 1   [in]    Socket handle
+ * word 2   [in/out] Size of the payload, on return the number of bytes
+ *		    transmitted or received
+ * word 3   [out]   Result of the operation, TEE_Result
+ *
+ * The operations are processed in order, a failed operation doesn't stop
+ * the processing of the following ones.
+ */
+#define OPTEE_RPC_SOCKET_BATCH	U(6)
+
 /* End of definition of protocol for command OPTEE_RPC_CMD_SOCKET */
 
 /*
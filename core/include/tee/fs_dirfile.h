@@ -128,6 +128,25 @@ TEE_Result tee_fs_dirfile_rename(struct tee_fs_dirfile_dirh *dirh,
 TEE_Result tee_fs_dirfile_remove(struct tee_fs_dirfile_dirh *dirh,
 				 const struct tee_fs_dirfile_fileh *dfh);
 
+/**
+ * tee_fs_dirfile_hold_file_number() - keep a file number allocated
+ * @dirh:		dirfile handle
+ * @file_number:	file number
+ *
+ * Used when a file removed from the directory is only deleted later, to
+ * prevent the file number from being reused in the meantime.
+ */
+TEE_Result tee_fs_dirfile_hold_file_number(struct tee_fs_dirfile_dirh *dirh,
+					   uint32_t file_number);
+
+/**
+ * tee_fs_dirfile_release_file_number() - release a held file number
+ * @dirh:		dirfile handle
+ * @file_number:	file number
+ */
+void tee_fs_dirfile_release_file_number(struct tee_fs_dirfile_dirh *dirh,
+					uint32_t file_number);
+
 /**
  * tee_fs_dirfile_update_hash() - update hash of file handle
  * @dirh:	filefile handle
@@ -136,6 +155,20 @@ TEE_Result tee_fs_dirfile_remove(struct tee_fs_dirfile_dirh *dirh,
 TEE_Result tee_fs_dirfile_update_hash(struct tee_fs_dirfile_dirh *dirh,
 				      const struct tee_fs_dirfile_fileh *dfh);
 
+/**
+ * tee_fs_dirfile_get_fileh() - get file handle of the file at an index
+ * @dirh:	dirfile handle
+ * @uuid:	uuid of requesting TA
+ * @idx:	index of the file, as returned by tee_fs_dirfile_get_next()
+ * @dfh:	returned file handle
+ *
+ * Returns TEE_ERROR_ITEM_NOT_FOUND if the entry at @idx is free or belongs
+ * to another TA.
+ */
+TEE_Result tee_fs_dirfile_get_fileh(struct tee_fs_dirfile_dirh *dirh,
+				   const TEE_UUID *uuid, int idx,
+				   struct tee_fs_dirfile_fileh *dfh);
+
 /**
  * tee_fs_dirfile_get_next() - get object id of next file
  * @dirh:	dirfile handle
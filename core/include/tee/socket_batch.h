@@ -0,0 +1,52 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+/*
+ * Batches of socket operations, see PTA_SOCKET_BATCH
+ */
+
+#ifndef __TEE_SOCKET_BATCH_H
+#define __TEE_SOCKET_BATCH_H
+
+#include <mm/mobj.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <tee_api_types.h>
+
+/*
+ * Transfers a serialized batch to the party processing it, normally
+ * tee-supplicant with OPTEE_RPC_SOCKET_BATCH.
+ *
+ * @instance_id	TA instance id
+ * @timeout	Timeout ms or OPTEE_RPC_SOCKET_TIMEOUT_*
+ * @num_ops	Number of operations
+ * @mobj	Shared memory holding the operations, may be NULL in tests
+ * @va		Virtual address of the operations
+ * @size	Size of the operations
+ */
+typedef TEE_Result (*socket_batch_xfer_fn)(uint32_t instance_id,
+					   uint32_t timeout, uint32_t num_ops,
+					   struct mobj *mobj, void *va,
+					   size_t size);
+
+/*
+ * Runs a batch of operations laid out as described for PTA_SOCKET_BATCH.
+ *
+ * @instance_id	TA instance id
+ * @timeout	Timeout ms or OPTEE_RPC_SOCKET_TIMEOUT_*
+ * @ops		Operations, updated with the results
+ * @size	Size of @ops
+ * @mobj	Shared memory used to transfer the operations
+ * @va		Virtual address of @mobj, at least @size bytes
+ * @xfer	Transfer function
+ *
+ * Only the headers and the data to transmit are copied to @va, the data
+ * received is copied back within the bounds of each receive operation.
+ */
+TEE_Result socket_batch_run(uint32_t instance_id, uint32_t timeout,
+			    void *ops, size_t size, struct mobj *mobj,
+			    void *va, socket_batch_xfer_fn xfer);
+
+#endif /*__TEE_SOCKET_BATCH_H*/
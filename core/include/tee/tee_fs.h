@@ -16,11 +16,25 @@
 typedef int64_t tee_fs_off_t;
 typedef uint32_t tee_fs_mode_t;
 
+struct ts_ctx;
+
 struct tee_fs_dirent {
 	uint8_t oid[TEE_OBJECT_ID_MAX_LEN];
 	size_t oidlen;
 };
 
+/*
+ * Information about a persistent object which a file system may cache
+ * along with the directory entry, see get_dirent_info() below.
+ */
+struct tee_fs_obj_info {
+	uint32_t obj_type;
+	uint32_t obj_size;
+	uint32_t max_obj_size;
+	uint32_t obj_usage;
+	uint32_t data_size;
+};
+
 struct tee_fs_dir;
 struct tee_file_handle;
 struct tee_pobj;
@@ -49,6 +63,27 @@ struct tee_file_operations {
 	TEE_Result (*opendir)(const TEE_UUID *uuid, struct tee_fs_dir **d);
 	TEE_Result (*readdir)(struct tee_fs_dir *d, struct tee_fs_dirent **ent);
 	void (*closedir)(struct tee_fs_dir *d);
+
+	/*
+	 * Optional cache of object information used by the enumeration.
+	 * get_dirent_info() returns the cached information of the entry
+	 * last returned by readdir(), or an error if there is none or it's
+	 * stale. set_dirent_info() records the information of that entry
+	 * once it has been read from the object itself.
+	 */
+	TEE_Result (*get_dirent_info)(struct tee_fs_dir *d,
+				      struct tee_fs_obj_info *info);
+	void (*set_dirent_info)(struct tee_fs_dir *d,
+				const struct tee_fs_obj_info *info);
+
+	/*
+	 * Optional transactions. Between begin_transaction() and
+	 * end_transaction() the updates made by the TA instance @ctx are
+	 * held back and are committed all at once, or dropped, by
+	 * end_transaction().
+	 */
+	TEE_Result (*begin_transaction)(struct ts_ctx *ctx);
+	TEE_Result (*end_transaction)(struct ts_ctx *ctx, bool commit);
 };
 
 #ifdef CFG_REE_FS
@@ -12,14 +12,14 @@
 #include <tee/tee_fs.h>
 
 struct tee_pobj {
-	TAILQ_ENTRY(tee_pobj) link;
+	LIST_ENTRY(tee_pobj) link;
 	uint32_t refcnt;
 	TEE_UUID uuid;
 	void *obj_id;
 	uint32_t obj_id_len;
 	uint32_t flags;
 	bool temporary;	/* can be changed while creating == true */
-	bool creating;	/* can only be changed with mutex held */
+	bool creating;	/* can only be changed with bucket mutex held */
 	/* Filesystem handling this object */
 	const struct tee_file_operations *fops;
 };
@@ -43,4 +43,28 @@ TEE_Result tee_pobj_release(struct tee_pobj *obj);
 TEE_Result tee_pobj_rename(struct tee_pobj *obj, void *obj_id,
 			   uint32_t obj_id_len);
 
+/*
+ * struct tee_pobj_stats - statistics of the registry of open persistent
+ * objects
+ * @locks:	Number of times a hash bucket was locked since the last reset
+ * @contended:	Number of these times the bucket was held by another thread
+ * @objects:	Number of persistent objects currently open
+ * @max_chain:	Number of objects in the most loaded hash bucket
+ * @buckets:	Number of hash buckets
+ */
+struct tee_pobj_stats {
+	uint64_t locks;
+	uint64_t contended;
+	uint32_t objects;
+	uint32_t max_chain;
+	uint32_t buckets;
+};
+
+/*
+ * tee_pobj_get_stats() - get the statistics of the registry
+ * @stats:	[out] Statistics
+ * @reset:	Clear the lock counters once read
+ */
+void tee_pobj_get_stats(struct tee_pobj_stats *stats, bool reset);
+
 #endif
@@ -57,8 +57,18 @@ TEE_Result syscall_storage_obj_trunc(unsigned long obj, size_t len);
 TEE_Result syscall_storage_obj_seek(unsigned long obj, int32_t offset,
 				    unsigned long whence);
 
+/*
+ * Storage transactions
+ */
+TEE_Result syscall_storage_trans_begin(unsigned long storage_id);
+
+TEE_Result syscall_storage_trans_end(unsigned long commit);
+
 void tee_svc_storage_close_all_enum(struct user_ta_ctx *utc);
 
+/* Aborts the storage transaction of a TA being torn down, if any */
+void tee_svc_storage_abort_trans(struct user_ta_ctx *utc);
+
 void tee_svc_storage_init(void);
 
 #endif /* TEE_SVC_STORAGE_H */
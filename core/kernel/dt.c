@@ -16,22 +16,26 @@
 
 const struct dt_driver *dt_find_compatible_driver(const void *fdt, int offs)
 {
-	const struct dt_device_match *dm;
-	const struct dt_driver *drv;
-
-	for_each_dt_driver(drv) {
-		for (dm = drv->match_table; dm; dm++) {
-			if (!dm->compatible) {
-				break;
-			}
-			if (!fdt_node_check_compatible(fdt, offs,
-						       dm->compatible)) {
-				return drv;
-			}
-		}
+	const struct dt_driver_match *matches = NULL;
+	const struct dt_driver *drv = NULL;
+	const char *compat = NULL;
+	int count = 0;
+	int idx = 0;
+
+	count = fdt_stringlist_count(fdt, offs, "compatible");
+
+	/* First driver in the scattered array matching any compatible */
+	for (idx = 0; idx < count; idx++) {
+		compat = fdt_stringlist_get(fdt, offs, "compatible", idx, NULL);
+		if (!compat)
+			break;
+
+		if (dt_driver_find_matches(compat, &matches) &&
+		    (!drv || matches->drv < drv))
+			drv = matches->drv;
 	}
 
-	return NULL;
+	return drv;
 }
 
 bool dt_have_prop(const void *fdt, int offs, const char *propname)
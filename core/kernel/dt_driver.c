@@ -14,6 +14,8 @@
 #include <kernel/dt_driver.h>
 #include <libfdt.h>
 #include <malloc.h>
+#include <stdlib.h>
+#include <string.h>
 #include <sys/queue.h>
 #include <tee_api_defines_extensions.h>
 #include <tee_api_types.h>
@@ -58,8 +60,27 @@ struct dt_driver_provider {
 	get_of_device_func get_of_device;
 	void *priv_data;
 	SLIST_ENTRY(dt_driver_provider) link;
+	SLIST_ENTRY(dt_driver_provider) node_link;
+	SLIST_ENTRY(dt_driver_provider) phandle_link;
 };
 
+/* Number of buckets of the provider lookup tables, a power of 2 */
+#define PROVIDER_BUCKETS	32
+
+SLIST_HEAD(dt_driver_provider_head, dt_driver_provider);
+
+/* Providers hashed on their node offset and on their phandle */
+static struct dt_driver_provider_head provider_by_node[PROVIDER_BUCKETS];
+static struct dt_driver_provider_head provider_by_phandle[PROVIDER_BUCKETS];
+
+/*
+ * Match entries of all the DT drivers sorted by compatible string, then
+ * in the order of the drivers and of their match tables. The index is
+ * first needed in nexus context to find the console driver.
+ */
+static struct dt_driver_match *compat_index __nex_bss;
+static size_t compat_index_count __nex_bss;
+
 /*
  * Device driver providers are able to provide a driver specific instance
  * related to device phandle arguments found in the secure embedded FDT.
@@ -113,6 +134,12 @@ static void assert_type_is_valid(enum dt_driver_type type)
 	}
 }
 
+static size_t provider_hash(uint32_t key)
+{
+	/* Node offsets are multiples of 4, phandles are mostly sequential */
+	return (key ^ (key >> 2) ^ (key >> 7)) & (PROVIDER_BUCKETS - 1);
+}
+
 /*
  * Driver provider registering API functions
  */
@@ -151,6 +178,10 @@ TEE_Result dt_driver_register_provider(const void *fdt, int nodeoffset,
 	prv->priv_data = priv;
 
 	SLIST_INSERT_HEAD(&dt_driver_provider_list, prv, link);
+	SLIST_INSERT_HEAD(provider_by_node + provider_hash(nodeoffset), prv,
+			  node_link);
+	SLIST_INSERT_HEAD(provider_by_phandle + provider_hash(phandle), prv,
+			  phandle_link);
 
 	return TEE_SUCCESS;
 }
@@ -199,7 +230,8 @@ dt_driver_get_provider_by_node(int nodeoffset, enum dt_driver_type type)
 {
 	struct dt_driver_provider *prv = NULL;
 
-	SLIST_FOREACH(prv, &dt_driver_provider_list, link)
+	SLIST_FOREACH(prv, provider_by_node + provider_hash(nodeoffset),
+		      node_link)
 		if (prv->nodeoffset == nodeoffset && prv->type == type)
 			return prv;
 
@@ -211,7 +243,8 @@ dt_driver_get_provider_by_phandle(uint32_t phandle, enum dt_driver_type type)
 {
 	struct dt_driver_provider *prv = NULL;
 
-	SLIST_FOREACH(prv, &dt_driver_provider_list, link)
+	SLIST_FOREACH(prv, provider_by_phandle + provider_hash(phandle),
+		      phandle_link)
 		if (prv->phandle == phandle && prv->type == type)
 			return prv;
 
@@ -326,6 +359,79 @@ void *dt_driver_device_from_node_idx_prop(const char *prop_name,
 	return NULL;
 }
 
+static int cmp_match(const void *a, const void *b)
+{
+	const struct dt_driver_match *ma = a;
+	const struct dt_driver_match *mb = b;
+	int rc = strcmp(ma->dm->compatible, mb->dm->compatible);
+
+	if (rc)
+		return rc;
+	/* Keep the order of the scattered array and of the match tables */
+	if (ma->drv != mb->drv)
+		return ma->drv < mb->drv ? -1 : 1;
+	if (ma->dm != mb->dm)
+		return ma->dm < mb->dm ? -1 : 1;
+	return 0;
+}
+
+static void build_compat_index(void)
+{
+	const struct dt_device_match *dm = NULL;
+	const struct dt_driver *drv = NULL;
+	size_t count = 0;
+
+	for_each_dt_driver(drv)
+		for (dm = drv->match_table; dm && dm->compatible; dm++)
+			count++;
+
+	compat_index = nex_calloc(count, sizeof(*compat_index));
+	if (count && !compat_index) {
+		EMSG("Can't allocate the index of %zu DT driver matches",
+		     count);
+		panic();
+	}
+
+	for_each_dt_driver(drv) {
+		for (dm = drv->match_table; dm && dm->compatible; dm++) {
+			compat_index[compat_index_count].drv = drv;
+			compat_index[compat_index_count].dm = dm;
+			compat_index_count++;
+		}
+	}
+
+	qsort(compat_index, compat_index_count, sizeof(*compat_index),
+	      cmp_match);
+}
+
+size_t dt_driver_find_matches(const char *compat,
+			      const struct dt_driver_match **matches)
+{
+	size_t lo = 0;
+	size_t hi = 0;
+	size_t n = 0;
+
+	if (!compat_index)
+		build_compat_index();
+
+	/* Find the first entry not lower than @compat */
+	hi = compat_index_count;
+	while (lo < hi) {
+		n = (lo + hi) / 2;
+		if (strcmp(compat_index[n].dm->compatible, compat) < 0)
+			lo = n + 1;
+		else
+			hi = n;
+	}
+
+	*matches = compat_index + lo;
+	for (n = lo; n < compat_index_count; n++)
+		if (strcmp(compat_index[n].dm->compatible, compat))
+			break;
+
+	return n - lo;
+}
+
 static void __maybe_unused print_probe_list(const void *fdt __maybe_unused)
 {
 	struct dt_driver_probe *elt = NULL;
@@ -427,17 +533,15 @@ static TEE_Result probe_device_by_compat(const void *fdt, int node,
 					 const char *compat,
 					 enum dt_driver_type type)
 {
-	const struct dt_driver *drv = NULL;
-	const struct dt_device_match *dm = NULL;
+	const struct dt_driver_match *matches = NULL;
+	size_t count = 0;
+	size_t n = 0;
 
-	for_each_dt_driver(drv) {
-		if (drv->type != type)
-			continue;
-
-		for (dm = drv->match_table; dm && dm->compatible; dm++)
-			if (strcmp(dm->compatible, compat) == 0)
-				return alloc_elt_and_probe(fdt, node, drv, dm);
-	}
+	count = dt_driver_find_matches(compat, &matches);
+	for (n = 0; n < count; n++)
+		if (matches[n].drv->type == type)
+			return alloc_elt_and_probe(fdt, node, matches[n].drv,
+						   matches[n].dm);
 
 	return TEE_ERROR_ITEM_NOT_FOUND;
 }
@@ -607,30 +711,30 @@ static TEE_Result add_probe_node_by_compat(const void *fdt, int node,
 					   const char *compat)
 {
 	TEE_Result res = TEE_ERROR_ITEM_NOT_FOUND;
+	const struct dt_driver_match *matches = NULL;
 	const struct dt_driver *dt_drv = NULL;
-	const struct dt_device_match *dm = NULL;
 	uint32_t found_types = 0;
+	size_t count = 0;
+	size_t n = 0;
 
-	for_each_dt_driver(dt_drv) {
-		for (dm = dt_drv->match_table; dm && dm->compatible; dm++) {
-			if (strcmp(dm->compatible, compat) == 0) {
-				assert(dt_drv->type < 32);
-
-				res = add_node_to_probe(fdt, node, dt_drv, dm);
-				if (res)
-					return res;
+	count = dt_driver_find_matches(compat, &matches);
+	for (n = 0; n < count; n++) {
+		/* Only the first matching entry of a driver is used */
+		if (matches[n].drv == dt_drv)
+			continue;
+		dt_drv = matches[n].drv;
+		assert(dt_drv->type < 32);
 
-				if (found_types & BIT(dt_drv->type)) {
-					EMSG("Driver %s multi hit on type %u",
-					     dt_drv->name, dt_drv->type);
-					panic();
-				}
-				found_types |= BIT(dt_drv->type);
+		res = add_node_to_probe(fdt, node, dt_drv, matches[n].dm);
+		if (res)
+			return res;
 
-				/* Matching found for this driver, try next */
-				break;
-			}
+		if (found_types & BIT(dt_drv->type)) {
+			EMSG("Driver %s multi hit on type %u",
+			     dt_drv->name, dt_drv->type);
+			panic();
 		}
+		found_types |= BIT(dt_drv->type);
 	}
 
 	return res;
@@ -767,6 +871,16 @@ static TEE_Result release_probe_lists(void)
 	SLIST_FOREACH_SAFE(prov, &dt_driver_provider_list, link, next_prov)
 	       free(prov);
 
+	/*
+	 * Rebuilt if needed after boot. With virtualization the index is
+	 * shared by all the guests and is kept.
+	 */
+	if (!IS_ENABLED(CFG_NS_VIRTUALIZATION)) {
+		nex_free(compat_index);
+		compat_index = NULL;
+		compat_index_count = 0;
+	}
+
 	return TEE_SUCCESS;
 }
 
@@ -5,8 +5,13 @@
  */
 #include <crypto/crypto.h>
 #include <initcall.h>
+#include <inttypes.h>
+#include <io.h>
 #include <kernel/embedded_ts.h>
 #include <kernel/ts_store.h>
+#ifdef CFG_LZ4
+#include <lz4.h>
+#endif
 #include <mempool.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -14,14 +19,32 @@
 #include <trace.h>
 #include <utee_defines.h>
 #include <util.h>
+#ifdef CFG_ZLIB
 #include <zlib.h>
+#endif
 
+/*
+ * @offs: Offset of the next byte to read in the uncompressed TS, or of the
+ *	  next chunk in an LZ4 compressed TS
+ * @strm: Decompression state of a DEFLATE compressed TS
+ * @chunk: Last decompressed chunk of an LZ4 compressed TS
+ * @chunk_len: Number of bytes in @chunk
+ * @chunk_pos: Offset of the next byte to read in @chunk
+ */
 struct ts_store_handle {
 	const struct embedded_ts *ts;
 	size_t offs;
+#ifdef CFG_ZLIB
 	z_stream strm;
+#endif
+#ifdef CFG_LZ4
+	uint8_t *chunk;
+	size_t chunk_len;
+	size_t chunk_pos;
+#endif
 };
 
+#ifdef CFG_ZLIB
 static void *zalloc(void *opaque __unused, unsigned int items,
 		    unsigned int size)
 {
@@ -33,8 +56,7 @@ static void zfree(void *opaque __unused, void *address)
 	mempool_free(mempool_default, address);
 }
 
-static bool decompression_init(z_stream *strm,
-			       const struct embedded_ts *ts)
+static bool inflate_init(z_stream *strm, const struct embedded_ts *ts)
 {
 	int st = Z_OK;
 
@@ -50,6 +72,32 @@ static bool decompression_init(z_stream *strm,
 
 	return true;
 }
+#endif /*CFG_ZLIB*/
+
+static bool decompression_init(struct ts_store_handle *h,
+			       const struct embedded_ts *ts)
+{
+	switch (ts->compression) {
+#ifdef CFG_ZLIB
+	case EMB_TS_COMPRESS_DEFLATE:
+		return inflate_init(&h->strm, ts);
+#endif
+#ifdef CFG_LZ4
+	case EMB_TS_COMPRESS_LZ4:
+		h->chunk = mempool_alloc(mempool_default,
+					 EMB_TS_LZ4_CHUNK_SIZE);
+		if (!h->chunk) {
+			EMSG("Out of memory");
+			return false;
+		}
+		return true;
+#endif
+	default:
+		EMSG("Unsupported compression format %"PRIu32,
+		     ts->compression);
+		return false;
+	}
+}
 
 TEE_Result emb_ts_open(const TEE_UUID *uuid,
 		       struct ts_store_handle **h,
@@ -68,7 +116,7 @@ TEE_Result emb_ts_open(const TEE_UUID *uuid,
 		return TEE_ERROR_OUT_OF_MEMORY;
 
 	if (ts->uncompressed_size) {
-		if (!decompression_init(&handle->strm, ts)) {
+		if (!decompression_init(handle, ts)) {
 			free(handle);
 			return TEE_ERROR_BAD_FORMAT;
 		}
@@ -134,8 +182,9 @@ static TEE_Result read_uncompressed(struct ts_store_handle *h, void *data,
 	return TEE_SUCCESS;
 }
 
-static TEE_Result read_compressed(struct ts_store_handle *h, void *data,
-				  size_t len)
+#ifdef CFG_ZLIB
+static TEE_Result read_deflate(struct ts_store_handle *h, void *data,
+			       size_t len)
 {
 	z_stream *strm = &h->strm;
 	size_t total = 0;
@@ -198,6 +247,89 @@ out:
 
 	return ret;
 }
+#endif /*CFG_ZLIB*/
+
+#ifdef CFG_LZ4
+static TEE_Result lz4_next_chunk(struct ts_store_handle *h)
+{
+	const uint8_t *src = h->ts->ts + h->offs;
+	size_t avail = h->ts->size - h->offs;
+	uint32_t hdr = 0;
+	size_t len = 0;
+	int rc = 0;
+
+	if (avail < sizeof(hdr))
+		return TEE_ERROR_BAD_FORMAT;
+	hdr = get_le32(src);
+	len = hdr & ~EMB_TS_LZ4_CHUNK_RAW;
+	if (len > avail - sizeof(hdr))
+		return TEE_ERROR_BAD_FORMAT;
+	src += sizeof(hdr);
+
+	if (hdr & EMB_TS_LZ4_CHUNK_RAW) {
+		if (len > EMB_TS_LZ4_CHUNK_SIZE)
+			return TEE_ERROR_BAD_FORMAT;
+		memcpy(h->chunk, src, len);
+	} else {
+		rc = lz4_decompress(src, len, h->chunk,
+				    EMB_TS_LZ4_CHUNK_SIZE);
+		if (rc < 0) {
+			EMSG("Decompression error at offset %zu", h->offs);
+			return TEE_ERROR_BAD_FORMAT;
+		}
+		len = rc;
+	}
+
+	h->offs += sizeof(hdr) + (hdr & ~EMB_TS_LZ4_CHUNK_RAW);
+	h->chunk_len = len;
+	h->chunk_pos = 0;
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result read_lz4(struct ts_store_handle *h, void *data, size_t len)
+{
+	TEE_Result res = TEE_SUCCESS;
+	size_t n = 0;
+
+	while (len) {
+		if (h->chunk_pos == h->chunk_len) {
+			if (h->offs == h->ts->size)
+				return TEE_ERROR_BAD_PARAMETERS;
+			res = lz4_next_chunk(h);
+			if (res)
+				return res;
+		}
+
+		n = MIN(len, h->chunk_len - h->chunk_pos);
+		if (data) {
+			memcpy(data, h->chunk + h->chunk_pos, n);
+			data = (uint8_t *)data + n;
+		}
+		h->chunk_pos += n;
+		len -= n;
+	}
+
+	return TEE_SUCCESS;
+}
+#endif /*CFG_LZ4*/
+
+static TEE_Result read_compressed(struct ts_store_handle *h, void *data,
+				  size_t len)
+{
+	switch (h->ts->compression) {
+#ifdef CFG_ZLIB
+	case EMB_TS_COMPRESS_DEFLATE:
+		return read_deflate(h, data, len);
+#endif
+#ifdef CFG_LZ4
+	case EMB_TS_COMPRESS_LZ4:
+		return read_lz4(h, data, len);
+#endif
+	default:
+		return TEE_ERROR_BAD_FORMAT;
+	}
+}
 
 TEE_Result emb_ts_read(struct ts_store_handle *h, void *data, size_t len)
 {
@@ -209,8 +341,16 @@ TEE_Result emb_ts_read(struct ts_store_handle *h, void *data, size_t len)
 
 void emb_ts_close(struct ts_store_handle *h)
 {
-	if (h->ts->uncompressed_size)
-		inflateEnd(&h->strm);
+	if (h->ts->uncompressed_size) {
+#ifdef CFG_ZLIB
+		if (h->ts->compression == EMB_TS_COMPRESS_DEFLATE)
+			inflateEnd(&h->strm);
+#endif
+#ifdef CFG_LZ4
+		if (h->ts->compression == EMB_TS_COMPRESS_LZ4)
+			mempool_free(mempool_default, h->chunk);
+#endif
+	}
 	free(h);
 }
 
@@ -3,6 +3,7 @@
  * Copyright (c) 2015-2017, Linaro Limited
  */
 
+#include <atomic.h>
 #include <kernel/mutex.h>
 #include <kernel/panic.h>
 #include <kernel/refcount.h>
@@ -12,6 +13,8 @@
 
 #include "mutex_lockdep.h"
 
+static struct mutex_stats mutex_stats;
+
 void mutex_init(struct mutex *m)
 {
 	*m = (struct mutex)MUTEX_INITIALIZER;
@@ -22,8 +25,30 @@ void mutex_init_recursive(struct recursive_mutex *m)
 	*m = (struct recursive_mutex)RECURSIVE_MUTEX_INITIALIZER;
 }
 
+/*
+ * Busy waits for @m to be unlocked as long as the thread holding it is
+ * executing on another core: releasing the mutex soon is then likely,
+ * sleeping costs a round trip to normal world. Returns true if @m was
+ * unlocked before the thread holding it was suspended or @budget ran out.
+ */
+static bool spin_on_owner(struct mutex *m, unsigned int *budget)
+{
+	while (*budget) {
+		(*budget)--;
+		if (atomic_load_short(&m->state) != -1)
+			return true;
+		if (!thread_is_active(atomic_load_short(&m->owner)))
+			return false;
+	}
+
+	return false;
+}
+
 static void __mutex_lock(struct mutex *m, const char *fname, int lineno)
 {
+	unsigned int spin_budget = CFG_CORE_MUTEX_SPIN_LOOPS;
+	bool spun = false;
+
 	assert_have_no_spinlock();
 	assert(thread_get_id_may_fail() != THREAD_ID_INVALID);
 	assert(thread_is_in_normal_mode());
@@ -33,6 +58,7 @@ static void __mutex_lock(struct mutex *m, const char *fname, int lineno)
 	while (true) {
 		uint32_t old_itr_status;
 		bool can_lock;
+		bool can_spin = false;
 		struct wait_queue_elem wqe;
 
 		/*
@@ -48,20 +74,40 @@ static void __mutex_lock(struct mutex *m, const char *fname, int lineno)
 
 		can_lock = !m->state;
 		if (!can_lock) {
-			wq_wait_init(&m->wq, &wqe, false /* wait_read */);
+			if (!spun)
+				atomic_inc32(&mutex_stats.contended);
+			can_spin = spin_budget && m->state == -1 &&
+				   thread_is_active(m->owner);
+			if (!can_spin)
+				wq_wait_init(&m->wq, &wqe,
+					     false /* wait_read */);
 		} else {
 			m->state = -1; /* write locked */
+			m->owner = thread_get_id();
 		}
 
 		cpu_spin_unlock_xrestore(&m->spin_lock, old_itr_status);
 
-		if (!can_lock) {
-			/*
-			 * Someone else is holding the lock, wait in normal
-			 * world for the lock to become available.
-			 */
-			wq_wait_final(&m->wq, &wqe, m, fname, lineno);
-		} else
+		if (can_lock) {
+			if (spun)
+				atomic_inc32(&mutex_stats.spin_acquired);
+			return;
+		}
+
+		if (can_spin) {
+			spun = true;
+			spin_on_owner(m, &spin_budget);
+			continue;
+		}
+
+		/*
+		 * Someone else is holding the lock, wait in normal world
+		 * for the lock to become available.
+		 */
+		atomic_inc32(&mutex_stats.sleeps);
+		wq_wait_final(&m->wq, &wqe, m, fname, lineno);
+		/* The unlocking thread handed the mutex over */
+		if (wqe.handoff)
 			return;
 	}
 }
@@ -90,6 +136,7 @@ static void __mutex_lock_recursive(struct recursive_mutex *m, const char *fname,
 static void __mutex_unlock(struct mutex *m, const char *fname, int lineno)
 {
 	uint32_t old_itr_status;
+	int handle = -1;
 
 	assert_have_no_spinlock();
 	assert(thread_get_id_may_fail() != THREAD_ID_INVALID);
@@ -101,11 +148,19 @@ static void __mutex_unlock(struct mutex *m, const char *fname, int lineno)
 	if (!m->state)
 		panic();
 
-	m->state = 0;
+	/* A waiting writer gets the mutex still write locked */
+	handle = wq_handoff_next(&m->wq);
+	if (handle < 0)
+		m->state = 0;
+	else
+		m->owner = handle;
 
 	cpu_spin_unlock_xrestore(&m->spin_lock, old_itr_status);
 
-	wq_wake_next(&m->wq, m, fname, lineno);
+	if (handle >= 0)
+		wq_wake_handle(handle, m, fname, lineno);
+	else
+		wq_wake_next(&m->wq, m, fname, lineno);
 }
 
 static void __mutex_unlock_recursive(struct recursive_mutex *m,
@@ -136,8 +191,10 @@ static bool __mutex_trylock(struct mutex *m, const char *fname __unused,
 	old_itr_status = cpu_spin_lock_xsave(&m->spin_lock);
 
 	can_lock_write = !m->state;
-	if (can_lock_write)
+	if (can_lock_write) {
 		m->state = -1;
+		m->owner = thread_get_id();
+	}
 
 	cpu_spin_unlock_xrestore(&m->spin_lock, old_itr_status);
 
@@ -151,6 +208,7 @@ static void __mutex_read_unlock(struct mutex *m, const char *fname, int lineno)
 {
 	uint32_t old_itr_status;
 	short new_state;
+	int handle = -1;
 
 	assert_have_no_spinlock();
 	assert(thread_get_id_may_fail() != THREAD_ID_INVALID);
@@ -160,17 +218,48 @@ static void __mutex_read_unlock(struct mutex *m, const char *fname, int lineno)
 	if (m->state <= 0)
 		panic();
 	m->state--;
+	if (!m->state) {
+		/* The last reader hands the mutex over to a waiting writer */
+		handle = wq_handoff_next(&m->wq);
+		if (handle >= 0) {
+			m->state = -1;
+			m->owner = handle;
+		}
+	}
 	new_state = m->state;
 
 	cpu_spin_unlock_xrestore(&m->spin_lock, old_itr_status);
 
 	/* Wake eventual waiters if the mutex was unlocked */
-	if (!new_state)
+	if (handle >= 0)
+		wq_wake_handle(handle, m, fname, lineno);
+	else if (!new_state)
 		wq_wake_next(&m->wq, m, fname, lineno);
 }
 
+/*
+ * New readers don't join the readers holding @m while a writer is
+ * waiting, or a steady flow of readers would starve the writer. Called
+ * with m->spin_lock held.
+ */
+static bool can_read_lock(struct mutex *m, bool waited)
+{
+	if (!m->state)
+		return true;
+	if (m->state == -1)
+		return false;
+
+	/*
+	 * A reader woken up by the last writer joins the other woken up
+	 * readers even if another writer is queued behind them.
+	 */
+	return waited || !wq_have_writer(&m->wq);
+}
+
 static void __mutex_read_lock(struct mutex *m, const char *fname, int lineno)
 {
+	bool waited = false;
+
 	assert_have_no_spinlock();
 	assert(thread_get_id_may_fail() != THREAD_ID_INVALID);
 	assert(thread_is_in_normal_mode());
@@ -191,7 +280,7 @@ static void __mutex_read_lock(struct mutex *m, const char *fname, int lineno)
 
 		old_itr_status = cpu_spin_lock_xsave(&m->spin_lock);
 
-		can_lock = m->state != -1;
+		can_lock = can_read_lock(m, waited);
 		if (!can_lock) {
 			wq_wait_init(&m->wq, &wqe, true /* wait_read */);
 		} else {
@@ -206,6 +295,7 @@ static void __mutex_read_lock(struct mutex *m, const char *fname, int lineno)
 			 * world for the lock to become available.
 			 */
 			wq_wait_final(&m->wq, &wqe, m, fname, lineno);
+			waited = true;
 		} else
 			return;
 	}
@@ -223,7 +313,7 @@ static bool __mutex_read_trylock(struct mutex *m, const char *fname __unused,
 
 	old_itr_status = cpu_spin_lock_xsave(&m->spin_lock);
 
-	can_lock = m->state != -1;
+	can_lock = can_read_lock(m, false);
 	if (can_lock)
 		m->state++;
 
@@ -342,6 +432,19 @@ unsigned int mutex_get_recursive_lock_depth(struct recursive_mutex *m)
 	return refcount_val(&m->lock_depth);
 }
 
+void mutex_get_stats(struct mutex_stats *stats, bool reset)
+{
+	stats->contended = atomic_load_u32(&mutex_stats.contended);
+	stats->spin_acquired = atomic_load_u32(&mutex_stats.spin_acquired);
+	stats->sleeps = atomic_load_u32(&mutex_stats.sleeps);
+
+	if (reset) {
+		atomic_store_u32(&mutex_stats.contended, 0);
+		atomic_store_u32(&mutex_stats.spin_acquired, 0);
+		atomic_store_u32(&mutex_stats.sleeps, 0);
+	}
+}
+
 void condvar_init(struct condvar *cv)
 {
 	*cv = (struct condvar)CONDVAR_INITIALIZER;
@@ -400,6 +503,7 @@ static void __condvar_wait(struct condvar *cv, struct mutex *m,
 	struct wait_queue_elem wqe;
 	short old_state;
 	short new_state;
+	int handle = -1;
 
 	mutex_unlock_check(m);
 
@@ -423,19 +527,33 @@ static void __condvar_wait(struct condvar *cv, struct mutex *m,
 		/* Multiple read locks, remove one */
 		m->state--;
 	} else {
-		/* Only one lock (read or write), unlock the mutex */
-		m->state = 0;
+		/* Only one lock (read or write), hand it over or unlock it */
+		handle = wq_handoff_next(&m->wq);
+		if (handle >= 0) {
+			m->state = -1;
+			m->owner = handle;
+		} else {
+			m->state = 0;
+		}
 	}
 	new_state = m->state;
 
 	cpu_spin_unlock_xrestore(&m->spin_lock, old_itr_status);
 
 	/* Wake eventual waiters if the mutex was unlocked */
-	if (!new_state)
+	if (handle >= 0)
+		wq_wake_handle(handle, m, fname, lineno);
+	else if (!new_state)
 		wq_wake_next(&m->wq, m, fname, lineno);
 
 	wq_wait_final(&m->wq, &wqe, m, fname, lineno);
 
+	if (wqe.handoff) {
+		/* Signaled and then handed the mutex over, write locked */
+		mutex_lock_check(m);
+		return;
+	}
+
 	if (old_state > 0)
 		mutex_read_lock(m);
 	else
@@ -6,6 +6,7 @@
 
 #include <kernel/panic.h>
 #include <kernel/thread.h>
+#include <kernel/trace_ext.h>
 #include <kernel/unwind.h>
 #include <trace.h>
 
@@ -16,6 +17,8 @@ void __do_panic(const char *file __maybe_unused,
 {
 	/* disable prehemption */
 	(void)thread_mask_exceptions(THREAD_EXCP_ALL);
+	/* Print what was logged before the panic message */
+	trace_ext_sync();
 
 	/* TODO: notify other cores */
 
@@ -0,0 +1,104 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#include <assert.h>
+#include <kernel/misc.h>
+#include <kernel/percpu_rwlock.h>
+#include <kernel/spinlock.h>
+#include <kernel/thread.h>
+#include <util.h>
+
+void percpu_rwlock_init(struct percpu_rwlock *rw)
+{
+	*rw = (struct percpu_rwlock)PERCPU_RWLOCK_INITIALIZER;
+}
+
+/*
+ * Increments the reader counter of the current CPU. Returns true if no
+ * writer was seen once the counter is updated.
+ *
+ * Both the increment here and the store of rw->writer in
+ * percpu_rwlock_write_lock() are followed by a sequentially consistent
+ * load of what the other side wrote: either the reader sees the writer or
+ * the writer sees the reader.
+ */
+static bool inc_readers(struct percpu_rwlock *rw)
+{
+	uint32_t exceptions = thread_mask_exceptions(THREAD_EXCP_FOREIGN_INTR);
+	unsigned int *readers = &rw->count[get_core_pos()].readers;
+
+	__atomic_add_fetch(readers, 1, __ATOMIC_SEQ_CST);
+	thread_unmask_exceptions(exceptions);
+
+	return !__atomic_load_n(&rw->writer, __ATOMIC_SEQ_CST);
+}
+
+/*
+ * The thread may have moved to another CPU since it incremented a
+ * counter, the counters can wrap but their sum is right.
+ */
+static void dec_readers(struct percpu_rwlock *rw)
+{
+	uint32_t exceptions = thread_mask_exceptions(THREAD_EXCP_FOREIGN_INTR);
+
+	__atomic_sub_fetch(&rw->count[get_core_pos()].readers, 1,
+			   __ATOMIC_RELEASE);
+	thread_unmask_exceptions(exceptions);
+}
+
+void percpu_rwlock_read_lock(struct percpu_rwlock *rw)
+{
+	assert_have_no_spinlock();
+
+	if (inc_readers(rw))
+		return;
+
+	/*
+	 * A writer is active or waiting for the readers to leave. Back off
+	 * and wait for it on the mutex, no other writer can get in as long
+	 * as we're holding the mutex read locked.
+	 */
+	dec_readers(rw);
+	mutex_read_lock(&rw->mu);
+	inc_readers(rw);
+	mutex_read_unlock(&rw->mu);
+}
+
+void percpu_rwlock_read_unlock(struct percpu_rwlock *rw)
+{
+	dec_readers(rw);
+}
+
+static unsigned int sum_readers(struct percpu_rwlock *rw)
+{
+	unsigned int sum = 0;
+	size_t n = 0;
+
+	/* Wraps around if readers migrated, the sum is still correct */
+	for (n = 0; n < ARRAY_SIZE(rw->count); n++)
+		sum += __atomic_load_n(&rw->count[n].readers,
+				       __ATOMIC_SEQ_CST);
+
+	return sum;
+}
+
+void percpu_rwlock_write_lock(struct percpu_rwlock *rw)
+{
+	mutex_lock(&rw->mu);
+
+	__atomic_store_n(&rw->writer, 1, __ATOMIC_SEQ_CST);
+	/*
+	 * Readers in their read section can't sleep, but may be
+	 * preempted: wait with interrupts unmasked.
+	 */
+	while (sum_readers(rw))
+		;
+}
+
+void percpu_rwlock_write_unlock(struct percpu_rwlock *rw)
+{
+	__atomic_store_n(&rw->writer, 0, __ATOMIC_RELEASE);
+	mutex_unlock(&rw->mu);
+}
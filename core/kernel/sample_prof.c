@@ -0,0 +1,248 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#include <assert.h>
+#include <atomic.h>
+#include <kernel/delay.h>
+#include <kernel/misc.h>
+#include <kernel/sample_prof.h>
+#include <kernel/spinlock.h>
+#include <kernel/thread.h>
+#include <kernel/ts_manager.h>
+#include <kernel/user_ta.h>
+#include <string.h>
+#include <util.h>
+
+/* From the Linux include/uapi/linux/perf_event.h ABI */
+#define PERF_RECORD_LOST	2
+#define PERF_RECORD_SAMPLE	9
+#define PERF_RECORD_MISC_KERNEL	1
+#define PERF_RECORD_MISC_USER	2
+#define PERF_CONTEXT_KERNEL	((uint64_t)-128)
+#define PERF_CONTEXT_USER	((uint64_t)-512)
+
+struct perf_event_header {
+	uint32_t type;
+	uint16_t misc;
+	uint16_t size;
+};
+
+/*
+ * PERF_RECORD_SAMPLE with sample_type PERF_SAMPLE_IP | PERF_SAMPLE_TID |
+ * PERF_SAMPLE_TIME | PERF_SAMPLE_CPU | PERF_SAMPLE_CALLCHAIN, followed by
+ * @nr callchain entries.
+ */
+struct perf_sample_rec {
+	struct perf_event_header header;
+	uint64_t ip;
+	uint32_t pid;
+	uint32_t tid;
+	uint64_t time;
+	uint32_t cpu;
+	uint32_t res;
+	uint64_t nr;
+};
+
+struct perf_lost_rec {
+	struct perf_event_header header;
+	uint64_t id;
+	uint64_t lost;
+};
+
+struct sample {
+	uint64_t time;
+	uint32_t pid;
+	uint32_t tid;
+	bool user;
+	uint8_t num_ips;
+	vaddr_t ips[SAMPLE_PROF_MAX_DEPTH];
+};
+
+struct sample_ring {
+	unsigned int lock;
+	size_t head;
+	size_t count;
+	uint64_t lost;
+	struct sample samples[CFG_CORE_SAMPLING_PROFILER_NUM_SAMPLES];
+};
+
+static struct sample_ring rings[CFG_TEE_CORE_NB_CORE];
+static unsigned int max_depth;
+
+static uint32_t current_pid(void)
+{
+	struct ts_session *s = ts_get_current_session_may_fail();
+
+	/*
+	 * User TAs are identified by the first field of their UUID, which is
+	 * also the first part of the file name of the TA ELF.
+	 */
+	if (s && is_user_ta_ctx(s->ctx))
+		return s->ctx->uuid.timeLow;
+	return 0;
+}
+
+unsigned int sample_prof_max_depth(void)
+{
+	return atomic_load_uint(&max_depth);
+}
+
+void sample_prof_add(bool user, const vaddr_t *ips, size_t num_ips)
+{
+	struct sample_ring *ring = rings + get_core_pos();
+	struct sample *smp = NULL;
+
+	assert(thread_get_exceptions() & THREAD_EXCP_FOREIGN_INTR);
+	assert(num_ips && num_ips <= SAMPLE_PROF_MAX_DEPTH);
+
+	cpu_spin_lock(&ring->lock);
+
+	if (ring->count == ARRAY_SIZE(ring->samples)) {
+		ring->lost++;
+		goto out;
+	}
+
+	smp = ring->samples + (ring->head + ring->count) %
+	      ARRAY_SIZE(ring->samples);
+	smp->time = timer_cnt_to_ns(timer_cnt_read());
+	smp->pid = current_pid();
+	smp->tid = thread_get_id();
+	smp->user = user;
+	smp->num_ips = num_ips;
+	memcpy(smp->ips, ips, num_ips * sizeof(*ips));
+	ring->count++;
+out:
+	cpu_spin_unlock(&ring->lock);
+}
+
+TEE_Result sample_prof_start(unsigned int depth)
+{
+	uint32_t exceptions = 0;
+	size_t n = 0;
+
+	if (!depth || depth > SAMPLE_PROF_MAX_DEPTH)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	for (n = 0; n < ARRAY_SIZE(rings); n++) {
+		exceptions = cpu_spin_lock_xsave(&rings[n].lock);
+		rings[n].head = 0;
+		rings[n].count = 0;
+		rings[n].lost = 0;
+		cpu_spin_unlock_xrestore(&rings[n].lock, exceptions);
+	}
+
+	atomic_store_uint(&max_depth, depth);
+
+	return TEE_SUCCESS;
+}
+
+void sample_prof_stop(void)
+{
+	atomic_store_uint(&max_depth, 0);
+}
+
+static size_t sample_rec_size(struct sample *smp)
+{
+	/* The callchain starts with a context marker followed by the PC */
+	return sizeof(struct perf_sample_rec) +
+	       (smp->num_ips + 1) * sizeof(uint64_t);
+}
+
+static void write_sample_rec(uint8_t *buf, size_t cpu, struct sample *smp)
+{
+	struct perf_sample_rec rec = {
+		.header = {
+			.type = PERF_RECORD_SAMPLE,
+			.size = sample_rec_size(smp),
+		},
+		.ip = smp->ips[0],
+		.pid = smp->pid,
+		.tid = smp->tid,
+		.time = smp->time,
+		.cpu = cpu,
+		.nr = smp->num_ips + 1,
+	};
+	uint64_t ip = 0;
+	size_t n = 0;
+
+	if (smp->user) {
+		rec.header.misc = PERF_RECORD_MISC_USER;
+		ip = PERF_CONTEXT_USER;
+	} else {
+		rec.header.misc = PERF_RECORD_MISC_KERNEL;
+		ip = PERF_CONTEXT_KERNEL;
+	}
+
+	memcpy(buf, &rec, sizeof(rec));
+	buf += sizeof(rec);
+	memcpy(buf, &ip, sizeof(ip));
+	for (n = 0; n < smp->num_ips; n++) {
+		buf += sizeof(ip);
+		ip = smp->ips[n];
+		memcpy(buf, &ip, sizeof(ip));
+	}
+}
+
+static size_t read_ring(size_t cpu, uint8_t *buf, size_t len, size_t *needed)
+{
+	struct sample_ring *ring = rings + cpu;
+	struct perf_lost_rec lost = {
+		.header = {
+			.type = PERF_RECORD_LOST,
+			.size = sizeof(lost),
+		},
+	};
+	uint32_t exceptions = cpu_spin_lock_xsave(&ring->lock);
+	struct sample *smp = NULL;
+	size_t pos = 0;
+	size_t sz = 0;
+
+	if (ring->lost) {
+		if (len < sizeof(lost)) {
+			*needed = sizeof(lost);
+			goto out;
+		}
+		lost.lost = ring->lost;
+		memcpy(buf, &lost, sizeof(lost));
+		pos += sizeof(lost);
+		ring->lost = 0;
+	}
+
+	while (ring->count) {
+		smp = ring->samples + ring->head;
+		sz = sample_rec_size(smp);
+		if (len - pos < sz) {
+			if (!pos)
+				*needed = sz;
+			break;
+		}
+		write_sample_rec(buf + pos, cpu, smp);
+		pos += sz;
+		ring->head = (ring->head + 1) % ARRAY_SIZE(ring->samples);
+		ring->count--;
+	}
+out:
+	cpu_spin_unlock_xrestore(&ring->lock, exceptions);
+
+	return pos;
+}
+
+TEE_Result sample_prof_read(void *buf, size_t *len)
+{
+	size_t needed = 0;
+	size_t pos = 0;
+	size_t n = 0;
+
+	for (n = 0; n < ARRAY_SIZE(rings); n++)
+		pos += read_ring(n, (uint8_t *)buf + pos, *len - pos, &needed);
+
+	if (!pos && needed) {
+		*len = needed;
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+
+	*len = pos;
+	return TEE_SUCCESS;
+}
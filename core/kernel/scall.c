@@ -5,6 +5,7 @@
  */
 
 #include <assert.h>
+#include <bench.h>
 #include <kernel/abort.h>
 #include <kernel/arch_scall.h>
 #include <kernel/ldelf_syscalls.h>
@@ -119,6 +120,8 @@ static const struct syscall_entry tee_syscall_table[] = {
 	SYSCALL_ENTRY(syscall_not_supported),
 	SYSCALL_ENTRY(syscall_not_supported),
 	SYSCALL_ENTRY(syscall_cache_operation),
+	SYSCALL_ENTRY(syscall_storage_trans_begin),
+	SYSCALL_ENTRY(syscall_storage_trans_end),
 };
 
 /*
@@ -205,11 +208,37 @@ static syscall_t get_tee_syscall_func(size_t num)
 				 &sc_table[TEE_SCN_MAX].fn + 1);
 }
 
+/* Syscalls processing data or keys, traced with BENCHMARK_TP_CRYPTO_OP */
+static bool is_crypto_op_scn(size_t scn)
+{
+	if (!IS_ENABLED(CFG_TEE_BENCHMARK))
+		return false;
+
+	switch (scn) {
+	case TEE_SCN_HASH_UPDATE:
+	case TEE_SCN_HASH_FINAL:
+	case TEE_SCN_CIPHER_UPDATE:
+	case TEE_SCN_CIPHER_FINAL:
+	case TEE_SCN_CRYP_DERIVE_KEY:
+	case TEE_SCN_AUTHENC_UPDATE_AAD:
+	case TEE_SCN_AUTHENC_UPDATE_PAYLOAD:
+	case TEE_SCN_AUTHENC_ENC_FINAL:
+	case TEE_SCN_AUTHENC_DEC_FINAL:
+	case TEE_SCN_ASYMM_OPERATE:
+	case TEE_SCN_ASYMM_VERIFY:
+	case TEE_SCN_CRYP_OBJ_GENERATE_KEY:
+		return true;
+	default:
+		return false;
+	}
+}
+
 bool scall_handle_user_ta(struct thread_scall_regs *regs)
 {
 	size_t scn = 0;
 	size_t max_args = 0;
 	syscall_t scf = NULL;
+	uint64_t bm_begin = 0;
 
 	scall_get_max_args(regs, &scn, &max_args);
 
@@ -225,8 +254,13 @@ bool scall_handle_user_ta(struct thread_scall_regs *regs)
 
 	ftrace_syscall_enter(scn);
 
+	if (is_crypto_op_scn(scn))
+		bm_begin = bm_tp_begin();
+
 	scall_set_retval(regs, scall_do_call(regs, scf));
 
+	bm_tp_end(BENCHMARK_TP_CRYPTO_OP, bm_begin);
+
 	ftrace_syscall_leave();
 
 	/*
@@ -21,6 +21,7 @@ endif
 srcs-y += panic.c
 srcs-y += trace_ext.c
 srcs-y += refcount.c
+srcs-$(CFG_CORE_SAMPLING_PROFILER) += sample_prof.c
 srcs-y += delay.c
 srcs-y += tee_time.c
 srcs-$(CFG_SECURE_TIME_SOURCE_REE) += tee_time_ree.c
@@ -37,6 +38,7 @@ srcs-$(CFG_CORE_TPM_EVENT_LOG) += tpm.c
 srcs-y += initcall.c
 srcs-$(CFG_WITH_USER_TA) += user_access.c
 srcs-y += mutex.c
+srcs-y += percpu_rwlock.c
 srcs-$(CFG_LOCKDEP) += mutex_lockdep.c
 srcs-y += wait_queue.c
 srcs-y += notif.c
@@ -5,6 +5,7 @@
  */
 
 #include <assert.h>
+#include <bench.h>
 #include <kernel/mutex.h>
 #include <kernel/panic.h>
 #include <kernel/pseudo_ta.h>
@@ -59,6 +60,21 @@ struct mutex tee_ta_mutex = MUTEX_INITIALIZER;
 struct condvar tee_ta_init_cv = CONDVAR_INITIALIZER;
 struct tee_ta_ctx_head tee_ctxes = TAILQ_HEAD_INITIALIZER(tee_ctxes);
 
+/*
+ * Index of the open sessions of all session lists by session ID, protected
+ * by tee_ta_mutex. Session IDs are allocated in sequence from
+ * next_session_id, so the low bits of an ID select the bucket. The number
+ * of buckets doubles when there are more sessions than buckets.
+ */
+#define SESSION_HASH_INITIAL_BUCKETS	16
+
+LIST_HEAD(session_bucket, tee_ta_session);
+
+static struct session_bucket *session_buckets;
+static size_t session_num_buckets;
+static size_t session_count;
+static uint32_t next_session_id = 1;
+
 #ifndef CFG_CONCURRENT_SINGLE_INSTANCE_TA
 static struct condvar tee_ta_cv = CONDVAR_INITIALIZER;
 static short int tee_ta_single_instance_thread = THREAD_ID_INVALID;
@@ -214,20 +230,87 @@ void tee_ta_put_session(struct tee_ta_session *s)
 	mutex_unlock(&tee_ta_mutex);
 }
 
-static struct tee_ta_session *tee_ta_find_session_nolock(uint32_t id,
-			struct tee_ta_session_head *open_sessions)
+static struct session_bucket *session_bucket(uint32_t id)
+{
+	return session_buckets + (id & (session_num_buckets - 1));
+}
+
+static struct tee_ta_session *session_hash_find(uint32_t id)
 {
 	struct tee_ta_session *s = NULL;
-	struct tee_ta_session *found = NULL;
 
-	TAILQ_FOREACH(s, open_sessions, link) {
-		if (s->id == id) {
-			found = s;
-			break;
+	if (!session_num_buckets)
+		return NULL;
+
+	LIST_FOREACH(s, session_bucket(id), hash_link)
+		if (s->id == id)
+			return s;
+
+	return NULL;
+}
+
+/*
+ * Doubles the number of buckets. If memory is short the index keeps its
+ * size, lookups are then only slower.
+ */
+static void session_hash_grow(void)
+{
+	size_t num_buckets = SESSION_HASH_INITIAL_BUCKETS;
+	struct session_bucket *buckets = NULL;
+	struct tee_ta_session *s = NULL;
+	size_t n = 0;
+
+	if (session_num_buckets &&
+	    MUL_OVERFLOW(session_num_buckets, 2, &num_buckets))
+		return;
+
+	buckets = calloc(num_buckets, sizeof(*buckets));
+	if (!buckets)
+		return;
+
+	for (n = 0; n < session_num_buckets; n++) {
+		while (!LIST_EMPTY(session_buckets + n)) {
+			s = LIST_FIRST(session_buckets + n);
+			LIST_REMOVE(s, hash_link);
+			LIST_INSERT_HEAD(buckets + (s->id & (num_buckets - 1)),
+					 s, hash_link);
 		}
 	}
 
-	return found;
+	free(session_buckets);
+	session_buckets = buckets;
+	session_num_buckets = num_buckets;
+}
+
+static TEE_Result session_hash_add(struct tee_ta_session *s)
+{
+	if (session_count >= session_num_buckets)
+		session_hash_grow();
+	if (!session_num_buckets)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	LIST_INSERT_HEAD(session_bucket(s->id), s, hash_link);
+	session_count++;
+
+	return TEE_SUCCESS;
+}
+
+static void session_hash_del(struct tee_ta_session *s)
+{
+	assert(session_count);
+	LIST_REMOVE(s, hash_link);
+	session_count--;
+}
+
+static struct tee_ta_session *tee_ta_find_session_nolock(uint32_t id,
+			struct tee_ta_session_head *open_sessions)
+{
+	struct tee_ta_session *s = session_hash_find(id);
+
+	if (s && s->open_sessions == open_sessions)
+		return s;
+
+	return NULL;
 }
 
 struct tee_ta_session *tee_ta_find_session(uint32_t id,
@@ -298,6 +381,7 @@ static void tee_ta_unlink_session(struct tee_ta_session *s,
 		condvar_wait(&s->refc_cv, &tee_ta_mutex);
 
 	TAILQ_REMOVE(open_sessions, s, link);
+	session_hash_del(s);
 
 	mutex_unlock(&tee_ta_mutex);
 }
@@ -629,30 +713,22 @@ static TEE_Result tee_ta_init_session_with_context(struct tee_ta_session *s,
 	return TEE_SUCCESS;
 }
 
-static uint32_t new_session_id(struct tee_ta_session_head *open_sessions)
+/*
+ * Session IDs are unique among all session lists and allocated in
+ * sequence, an ID is only reused once the 32-bit counter wraps around.
+ * Only an ID still in use after a wrap around needs another try.
+ */
+static uint32_t new_session_id(void)
 {
-	struct tee_ta_session *last = NULL;
-	uint32_t saved = 0;
-	uint32_t id = 1;
-
-	last = TAILQ_LAST(open_sessions, tee_ta_session_head);
-	if (last) {
-		/* This value is less likely to be already used */
-		id = last->id + 1;
-		if (!id)
-			id++; /* 0 is not valid */
-	}
+	uint32_t id = 0;
 
-	saved = id;
 	do {
-		if (!tee_ta_find_session_nolock(id, open_sessions))
-			return id;
-		id++;
-		if (!id)
-			id++;
-	} while (id != saved);
-
-	return 0;
+		id = next_session_id++;
+		if (!next_session_id)
+			next_session_id++; /* 0 is not valid */
+	} while (session_hash_find(id));
+
+	return id;
 }
 
 static TEE_Result tee_ta_init_session(TEE_ErrorOrigin *err,
@@ -674,11 +750,11 @@ static TEE_Result tee_ta_init_session(TEE_ErrorOrigin *err,
 	s->ref_count = 1;
 
 	mutex_lock(&tee_ta_mutex);
-	s->id = new_session_id(open_sessions);
-	if (!s->id) {
-		res = TEE_ERROR_OVERFLOW;
+	s->id = new_session_id();
+	s->open_sessions = open_sessions;
+	res = session_hash_add(s);
+	if (res)
 		goto err_mutex_unlock;
-	}
 
 	TAILQ_INSERT_TAIL(open_sessions, s, link);
 
@@ -709,6 +785,7 @@ out:
 
 	mutex_lock(&tee_ta_mutex);
 	TAILQ_REMOVE(open_sessions, s, link);
+	session_hash_del(s);
 err_mutex_unlock:
 	mutex_unlock(&tee_ta_mutex);
 	free(s);
@@ -729,6 +806,7 @@ TEE_Result tee_ta_open_session(TEE_ErrorOrigin *err,
 	struct ts_ctx *ts_ctx = NULL;
 	bool panicked = false;
 	bool was_busy = false;
+	uint64_t bm_begin = 0;
 
 	res = tee_ta_init_session(err, open_sessions, uuid, &s);
 	if (res != TEE_SUCCESS) {
@@ -757,7 +835,9 @@ TEE_Result tee_ta_open_session(TEE_ErrorOrigin *err,
 	if (tee_ta_try_set_busy(ctx)) {
 		s->param = param;
 		set_invoke_timeout(s, cancel_req_to);
+		bm_begin = bm_tp_begin();
 		res = ts_ctx->ops->enter_open_session(&s->ts_sess);
+		bm_tp_end_session(BENCHMARK_TP_TA_ENTRY, bm_begin, s->id);
 		tee_ta_clear_busy(ctx);
 	} else {
 		/* Deadlock avoided */
@@ -796,6 +876,7 @@ TEE_Result tee_ta_invoke_command(TEE_ErrorOrigin *err,
 	struct tee_ta_ctx *ta_ctx = NULL;
 	struct ts_ctx *ts_ctx = NULL;
 	TEE_Result res = TEE_SUCCESS;
+	uint64_t bm_begin = 0;
 
 	if (check_client(sess, clnt_id) != TEE_SUCCESS)
 		return TEE_ERROR_BAD_PARAMETERS; /* intentional generic error */
@@ -822,7 +903,9 @@ TEE_Result tee_ta_invoke_command(TEE_ErrorOrigin *err,
 
 	sess->param = param;
 	set_invoke_timeout(sess, cancel_req_to);
+	bm_begin = bm_tp_begin();
 	res = ts_ctx->ops->enter_invoke_cmd(&sess->ts_sess, cmd);
+	bm_tp_end_session(BENCHMARK_TP_TA_ENTRY, bm_begin, sess->id);
 
 	sess->param = NULL;
 	tee_ta_clear_busy(ta_ctx);
@@ -1142,7 +1225,6 @@ static void ftrace_update_times(bool suspend)
 	struct ts_session *s = ts_get_current_session_may_fail();
 	struct ftrace_buf *fbuf = NULL;
 	uint64_t now = 0;
-	uint32_t i = 0;
 
 	if (!s)
 		return;
@@ -1153,12 +1235,11 @@ static void ftrace_update_times(bool suspend)
 	if (!fbuf)
 		return;
 
-	if (suspend) {
+	/* Keep the time spent suspended out of the next record delta */
+	if (suspend)
 		fbuf->suspend_time = now;
-	} else {
-		for (i = 0; i <= fbuf->ret_idx; i++)
-			fbuf->begin_time[i] += now - fbuf->suspend_time;
-	}
+	else if (fbuf->last_time)
+		fbuf->last_time += now - fbuf->suspend_time;
 }
 
 void tee_ta_ftrace_update_times_suspend(void)
@@ -5,6 +5,7 @@
  * Copyright (c) 2020-2021, Arm Limited
  */
 
+#include <atomic.h>
 #include <config.h>
 #include <crypto/crypto.h>
 #include <kernel/asan.h>
@@ -14,6 +15,7 @@
 #include <kernel/spinlock.h>
 #include <kernel/thread.h>
 #include <kernel/thread_private.h>
+#include <malloc.h>
 #include <mm/mobj.h>
 
 struct thread_ctx threads[CFG_NUM_THREADS];
@@ -51,8 +53,17 @@ DECLARE_STACK(stack_tmp, CFG_TEE_CORE_NB_CORE, STACK_TMP_SIZE,
 	      /* global linkage */);
 DECLARE_STACK(stack_abt, CFG_TEE_CORE_NB_CORE, STACK_ABT_SIZE, static);
 #ifndef CFG_WITH_PAGER
+#ifdef CFG_CORE_THREAD_POOL
+#if CFG_CORE_THREAD_POOL_MIN < 1 || CFG_CORE_THREAD_POOL_MIN > CFG_NUM_THREADS
+#error CFG_CORE_THREAD_POOL_MIN must be in the range [1, CFG_NUM_THREADS]
+#endif
+/* The other threads get a stack from the heap when they are needed */
+DECLARE_STACK(stack_thread, CFG_CORE_THREAD_POOL_MIN, STACK_THREAD_SIZE,
+	      static);
+#else
 DECLARE_STACK(stack_thread, CFG_NUM_THREADS, STACK_THREAD_SIZE, static);
 #endif
+#endif
 
 #define GET_STACK_TOP_HARD(stack, n) \
 	((vaddr_t)&(stack)[n] + STACK_CANARY_SIZE / 2)
@@ -186,6 +197,8 @@ static void print_stack_limits(void)
 	}
 	for (n = 0; n < CFG_NUM_THREADS; n++) {
 		end = threads[n].stack_va_end;
+		if (!end)
+			continue;
 		start = end - STACK_THREAD_SIZE + STACK_CHECK_EXTRA;
 		DMSG("thr [%zu] 0x%" PRIxVA "..0x%" PRIxVA, n, start, end);
 	}
@@ -379,6 +392,15 @@ short int __noprof thread_get_id_may_fail(void)
 	return ct;
 }
 
+bool thread_is_active(short int thread_id)
+{
+	if (thread_id < 0 || thread_id >= CFG_NUM_THREADS)
+		return false;
+
+	return __compiler_atomic_load(&threads[thread_id].state) ==
+	       THREAD_STATE_ACTIVE;
+}
+
 short int __noprof thread_get_id(void)
 {
 	short int ct = thread_get_id_may_fail();
@@ -433,7 +455,7 @@ static void init_thread_stacks(void)
 	size_t n;
 
 	/* Assign the thread stacks */
-	for (n = 0; n < CFG_NUM_THREADS; n++) {
+	for (n = 0; n < ARRAY_SIZE(stack_thread); n++) {
 		if (!thread_init_stack(n, GET_STACK_BOTTOM(stack_thread, n)))
 			panic("thread_init_stack failed");
 	}
@@ -454,6 +476,174 @@ void thread_init_threads(void)
 		TAILQ_INIT(&threads[n].tsd.sess_stack);
 }
 
+/* Protected by thread_global_lock */
+static struct thread_pool_stats pool_stats;
+
+#ifdef CFG_CORE_THREAD_POOL
+#define DYN_STACK_SIZE	ROUNDUP(STACK_THREAD_SIZE + STACK_CANARY_SIZE + \
+				STACK_CHECK_EXTRA, STACK_ALIGNMENT)
+
+/* Heap stacks of the threads above CFG_CORE_THREAD_POOL_MIN */
+static uint32_t *dyn_stacks[CFG_NUM_THREADS];
+
+static bool has_stack(size_t n)
+{
+	return n < ARRAY_SIZE(stack_thread) || dyn_stacks[n];
+}
+
+static bool alloc_dyn_stack(size_t n)
+{
+	uint32_t *stack = memalign(STACK_ALIGNMENT, DYN_STACK_SIZE);
+
+	if (!stack)
+		return false;
+
+#ifdef CFG_WITH_STACK_CANARIES
+	stack[0] = START_CANARY_VALUE;
+	stack[DYN_STACK_SIZE / sizeof(uint32_t) - 1] = END_CANARY_VALUE;
+#endif
+	dyn_stacks[n] = stack;
+	threads[n].stack_va_end = (vaddr_t)stack + DYN_STACK_SIZE -
+				  STACK_CANARY_SIZE / 2;
+
+	return true;
+}
+
+static void free_dyn_stack(size_t n, uint32_t *stack)
+{
+#ifdef CFG_WITH_STACK_CANARIES
+	uint32_t *canary = stack;
+
+	if (*canary != START_CANARY_VALUE)
+		CANARY_DIED(dyn_stack, start, n, canary);
+	canary = stack + DYN_STACK_SIZE / sizeof(uint32_t) - 1;
+	if (*canary != END_CANARY_VALUE)
+		CANARY_DIED(dyn_stack, end, n, canary);
+#endif
+	free(stack);
+}
+
+void thread_pool_shrink(void)
+{
+	uint32_t *stack = NULL;
+	size_t idle = 0;
+	size_t n = 0;
+
+	thread_lock_global();
+
+	for (n = 0; n < CFG_NUM_THREADS; n++)
+		if (threads[n].state == THREAD_STATE_FREE && has_stack(n))
+			idle++;
+
+	for (n = ARRAY_SIZE(stack_thread);
+	     idle > CFG_CORE_THREAD_POOL_MIN && n < CFG_NUM_THREADS; n++) {
+		if (threads[n].state == THREAD_STATE_FREE && dyn_stacks[n]) {
+			stack = dyn_stacks[n];
+			dyn_stacks[n] = NULL;
+			threads[n].stack_va_end = 0;
+			pool_stats.stacks--;
+			pool_stats.stack_frees++;
+			break;
+		}
+	}
+
+	thread_unlock_global();
+
+	if (stack)
+		free_dyn_stack(n, stack);
+}
+#else
+static bool has_stack(size_t n __unused)
+{
+	return true;
+}
+
+static bool alloc_dyn_stack(size_t n __unused)
+{
+	return false;
+}
+#endif /*CFG_CORE_THREAD_POOL*/
+
+int thread_state_alloc(void)
+{
+	int ct = THREAD_ID_INVALID;
+	size_t active = 1;
+	bool stack_ok = false;
+	size_t n = 0;
+
+	thread_lock_global();
+
+	/* Prefer a free thread which still has a stack */
+	for (n = 0; n < CFG_NUM_THREADS; n++) {
+		if (threads[n].state != THREAD_STATE_FREE)
+			active++;
+		else if (ct == THREAD_ID_INVALID ||
+			 (has_stack(n) && !has_stack(ct)))
+			ct = n;
+	}
+
+	if (ct == THREAD_ID_INVALID) {
+		pool_stats.limit_hits++;
+		thread_unlock_global();
+		return THREAD_ID_INVALID;
+	}
+
+	threads[ct].state = THREAD_STATE_ACTIVE;
+	if (has_stack(ct)) {
+		pool_stats.allocs++;
+		pool_stats.max_active = MAX(pool_stats.max_active, active);
+		thread_unlock_global();
+		return ct;
+	}
+
+	thread_unlock_global();
+
+	/* The thread is active, nothing else changes its stack */
+	stack_ok = alloc_dyn_stack(ct);
+
+	thread_lock_global();
+	if (stack_ok) {
+		pool_stats.allocs++;
+		pool_stats.max_active = MAX(pool_stats.max_active, active);
+		pool_stats.stacks++;
+		pool_stats.stack_allocs++;
+	} else {
+		threads[ct].state = THREAD_STATE_FREE;
+		pool_stats.limit_hits++;
+		pool_stats.stack_alloc_fails++;
+		ct = THREAD_ID_INVALID;
+	}
+	thread_unlock_global();
+
+	return ct;
+}
+
+void thread_get_pool_stats(struct thread_pool_stats *stats, bool reset)
+{
+	uint32_t exceptions = thread_mask_exceptions(THREAD_EXCP_ALL);
+
+	thread_lock_global();
+
+	*stats = pool_stats;
+	stats->threads = CFG_NUM_THREADS;
+	if (IS_ENABLED(CFG_CORE_THREAD_POOL))
+		stats->stacks += CFG_CORE_THREAD_POOL_MIN;
+	else
+		stats->stacks = CFG_NUM_THREADS;
+
+	if (reset) {
+		pool_stats.allocs = 0;
+		pool_stats.limit_hits = 0;
+		pool_stats.stack_allocs = 0;
+		pool_stats.stack_frees = 0;
+		pool_stats.stack_alloc_fails = 0;
+		pool_stats.max_active = 0;
+	}
+
+	thread_unlock_global();
+	thread_unmask_exceptions(exceptions);
+}
+
 void __nostackcheck thread_init_thread_core_local(void)
 {
 	size_t n = 0;
@@ -564,6 +754,18 @@ static struct mobj *alloc_shm(enum thread_shm_type shm_type, size_t size)
 	}
 }
 
+/*
+ * Idle kernel private RPC buffers kept registered with normal world across
+ * standard calls, shared by all threads. Normal world gets them back one
+ * by one with thread_rpc_shm_cache_pop_pool() when it disables the cache.
+ */
+static struct thread_shm_cache shm_cache_pool =
+	SLIST_HEAD_INITIALIZER(shm_cache_pool);
+static size_t shm_cache_pool_count;
+static unsigned int shm_cache_pool_lock = SPINLOCK_UNLOCK;
+
+static struct thread_shm_cache_stats shm_cache_stats;
+
 static void clear_shm_cache_entry(struct thread_shm_cache_entry *ce)
 {
 	if (ce->mobj) {
@@ -581,20 +783,72 @@ static void clear_shm_cache_entry(struct thread_shm_cache_entry *ce)
 			assert(0); /* "can't happen" */
 			break;
 		}
+		atomic_inc32(&shm_cache_stats.rpc_frees);
 	}
 	ce->mobj = NULL;
 	ce->size = 0;
 }
 
+/*
+ * Buffers are allocated in power of two numbers of pages, normal world
+ * allocates payload memory as complete pages anyway and requests of
+ * slightly different sizes share the same buffer.
+ */
+static size_t shm_cache_size_class(size_t size)
+{
+	size_t sz = SMALL_PAGE_SIZE;
+
+	while (sz < size)
+		if (MUL_OVERFLOW(sz, 2, &sz))
+			return 0;
+
+	return sz;
+}
+
+/* Returns the smallest buffer of @user large enough for @size */
 static struct thread_shm_cache_entry *
-get_shm_cache_entry(enum thread_shm_cache_user user)
+find_shm_cache_entry(struct thread_shm_cache *cache,
+		     enum thread_shm_cache_user user,
+		     enum thread_shm_type shm_type, size_t size)
 {
-	struct thread_shm_cache *cache = &threads[thread_get_id()].shm_cache;
+	struct thread_shm_cache_entry *best = NULL;
 	struct thread_shm_cache_entry *ce = NULL;
 
 	SLIST_FOREACH(ce, cache, link)
-		if (ce->user == user)
+		if (ce->user == user && ce->mobj && ce->type == shm_type &&
+		    ce->size >= size && (!best || ce->size < best->size))
+			best = ce;
+
+	return best;
+}
+
+/*
+ * Returns an entry of @user without buffer, a new one if @user has less
+ * than CFG_THREAD_SHM_CACHE_SLOTS entries or else the entry with the
+ * smallest buffer once released.
+ */
+static struct thread_shm_cache_entry *
+get_free_shm_cache_entry(struct thread_shm_cache *cache,
+			 enum thread_shm_cache_user user)
+{
+	struct thread_shm_cache_entry *victim = NULL;
+	struct thread_shm_cache_entry *ce = NULL;
+	size_t count = 0;
+
+	SLIST_FOREACH(ce, cache, link) {
+		if (ce->user != user)
+			continue;
+		if (!ce->mobj)
 			return ce;
+		count++;
+		if (!victim || ce->size < victim->size)
+			victim = ce;
+	}
+
+	if (count >= CFG_THREAD_SHM_CACHE_SLOTS) {
+		clear_shm_cache_entry(victim);
+		return victim;
+	}
 
 	ce = calloc(1, sizeof(*ce));
 	if (ce) {
@@ -605,61 +859,136 @@ get_shm_cache_entry(enum thread_shm_cache_user user)
 	return ce;
 }
 
+static bool shm_cache_pool_enabled(void)
+{
+	/* The pool is shared by all threads, guests must not share buffers */
+	return IS_ENABLED(CFG_PREALLOC_RPC_CACHE) &&
+	       !IS_ENABLED(CFG_NS_VIRTUALIZATION);
+}
+
+/* Moves a buffer of at least @size bytes from the pool to @ce */
+static bool take_from_shm_cache_pool(struct thread_shm_cache_entry *ce,
+				     size_t size)
+{
+	struct thread_shm_cache_entry *prev = NULL;
+	struct thread_shm_cache_entry *pe = NULL;
+	uint32_t exceptions = 0;
+
+	if (!shm_cache_pool_enabled())
+		return false;
+
+	exceptions = cpu_spin_lock_xsave(&shm_cache_pool_lock);
+	SLIST_FOREACH(pe, &shm_cache_pool, link) {
+		if (pe->size >= size) {
+			if (prev)
+				SLIST_REMOVE_AFTER(prev, link);
+			else
+				SLIST_REMOVE_HEAD(&shm_cache_pool, link);
+			shm_cache_pool_count--;
+			break;
+		}
+		prev = pe;
+	}
+	cpu_spin_unlock_xrestore(&shm_cache_pool_lock, exceptions);
+
+	if (!pe)
+		return false;
+
+	ce->mobj = pe->mobj;
+	ce->size = pe->size;
+	ce->type = pe->type;
+	free(pe);
+	atomic_inc32(&shm_cache_stats.pool_hits);
+
+	return true;
+}
+
+static bool put_in_shm_cache_pool(struct thread_shm_cache_entry *ce)
+{
+	uint32_t exceptions = 0;
+	bool added = false;
+
+	if (!shm_cache_pool_enabled() || !ce->mobj ||
+	    ce->type != THREAD_SHM_TYPE_KERNEL_PRIVATE)
+		return false;
+
+	exceptions = cpu_spin_lock_xsave(&shm_cache_pool_lock);
+	if (shm_cache_pool_count < CFG_THREAD_SHM_CACHE_POOL_SIZE) {
+		SLIST_INSERT_HEAD(&shm_cache_pool, ce, link);
+		shm_cache_pool_count++;
+		added = true;
+	}
+	cpu_spin_unlock_xrestore(&shm_cache_pool_lock, exceptions);
+
+	return added;
+}
+
+static TEE_Result fill_shm_cache_entry(struct thread_shm_cache_entry *ce,
+				       enum thread_shm_type shm_type,
+				       size_t size)
+{
+	paddr_t p = 0;
+
+	if (shm_type == THREAD_SHM_TYPE_KERNEL_PRIVATE &&
+	    take_from_shm_cache_pool(ce, size))
+		return TEE_SUCCESS;
+
+	ce->mobj = alloc_shm(shm_type, size);
+	if (!ce->mobj)
+		return TEE_ERROR_OUT_OF_MEMORY;
+	ce->size = size;
+	ce->type = shm_type;
+	atomic_inc32(&shm_cache_stats.rpc_allocs);
+
+	if (mobj_get_pa(ce->mobj, 0, 0, &p) ||
+	    !IS_ALIGNED_WITH_TYPE(p, uint64_t) ||
+	    !mobj_get_va(ce->mobj, 0, size)) {
+		clear_shm_cache_entry(ce);
+		return TEE_ERROR_GENERIC;
+	}
+
+	return TEE_SUCCESS;
+}
+
 void *thread_rpc_shm_cache_alloc(enum thread_shm_cache_user user,
 				 enum thread_shm_type shm_type,
 				 size_t size, struct mobj **mobj)
 {
+	struct thread_shm_cache *cache = &threads[thread_get_id()].shm_cache;
 	struct thread_shm_cache_entry *ce = NULL;
-	size_t sz = size;
-	paddr_t p = 0;
+	size_t sz = 0;
 	void *va = NULL;
 
 	if (!size)
 		return NULL;
 
-	ce = get_shm_cache_entry(user);
-	if (!ce)
-		return NULL;
-
-	/*
-	 * Always allocate in page chunks as normal world allocates payload
-	 * memory as complete pages.
-	 */
-	sz = ROUNDUP(size, SMALL_PAGE_SIZE);
-
-	if (ce->type != shm_type || sz > ce->size) {
-		clear_shm_cache_entry(ce);
-
-		ce->mobj = alloc_shm(shm_type, sz);
-		if (!ce->mobj)
+	ce = find_shm_cache_entry(cache, user, shm_type, size);
+	if (ce) {
+		atomic_inc32(&shm_cache_stats.hits);
+	} else {
+		sz = shm_cache_size_class(size);
+		if (!sz)
 			return NULL;
 
-		if (mobj_get_pa(ce->mobj, 0, 0, &p))
-			goto err;
-
-		if (!IS_ALIGNED_WITH_TYPE(p, uint64_t))
-			goto err;
+		ce = get_free_shm_cache_entry(cache, user);
+		if (!ce)
+			return NULL;
 
-		va = mobj_get_va(ce->mobj, 0, sz);
-		if (!va)
-			goto err;
+		if (fill_shm_cache_entry(ce, shm_type, sz))
+			return NULL;
+	}
 
-		ce->size = sz;
-		ce->type = shm_type;
-	} else {
-		va = mobj_get_va(ce->mobj, 0, sz);
-		if (!va)
-			goto err;
+	va = mobj_get_va(ce->mobj, 0, size);
+	if (!va) {
+		clear_shm_cache_entry(ce);
+		return NULL;
 	}
 	*mobj = ce->mobj;
 
 	return va;
-err:
-	clear_shm_cache_entry(ce);
-	return NULL;
 }
 
-void thread_rpc_shm_cache_clear(struct thread_shm_cache *cache)
+void thread_rpc_shm_cache_clear(struct thread_shm_cache *cache, bool keep)
 {
 	while (true) {
 		struct thread_shm_cache_entry *ce = SLIST_FIRST(cache);
@@ -667,7 +996,44 @@ void thread_rpc_shm_cache_clear(struct thread_shm_cache *cache)
 		if (!ce)
 			break;
 		SLIST_REMOVE_HEAD(cache, link);
+		if (keep && put_in_shm_cache_pool(ce))
+			continue;
 		clear_shm_cache_entry(ce);
 		free(ce);
 	}
 }
+
+bool thread_rpc_shm_cache_pop_pool(uint64_t *cookie)
+{
+	struct thread_shm_cache_entry *ce = NULL;
+	uint32_t exceptions = 0;
+
+	exceptions = cpu_spin_lock_xsave(&shm_cache_pool_lock);
+	ce = SLIST_FIRST(&shm_cache_pool);
+	if (ce) {
+		SLIST_REMOVE_HEAD(&shm_cache_pool, link);
+		shm_cache_pool_count--;
+	}
+	cpu_spin_unlock_xrestore(&shm_cache_pool_lock, exceptions);
+
+	if (!ce)
+		return false;
+
+	*cookie = mobj_get_cookie(ce->mobj);
+	mobj_put(ce->mobj);
+	free(ce);
+
+	return true;
+}
+
+void thread_rpc_shm_cache_get_stats(struct thread_shm_cache_stats *stats)
+{
+	uint32_t exceptions = cpu_spin_lock_xsave(&shm_cache_pool_lock);
+
+	stats->hits = atomic_load_u32(&shm_cache_stats.hits);
+	stats->pool_hits = atomic_load_u32(&shm_cache_stats.pool_hits);
+	stats->rpc_allocs = atomic_load_u32(&shm_cache_stats.rpc_allocs);
+	stats->rpc_frees = atomic_load_u32(&shm_cache_stats.rpc_frees);
+	stats->pooled = shm_cache_pool_count;
+	cpu_spin_unlock_xrestore(&shm_cache_pool_lock, exceptions);
+}
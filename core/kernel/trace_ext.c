@@ -2,13 +2,23 @@
 /*
  * Copyright (c) 2014, Linaro Limited
  */
+#include <inttypes.h>
 #include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
 #include <trace.h>
 #include <console.h>
+#include <initcall.h>
 #include <kernel/misc.h>
 #include <kernel/spinlock.h>
 #include <kernel/thread.h>
+#include <kernel/trace_ext.h>
 #include <mm/core_mmu.h>
+#include <util.h>
+#ifdef CFG_CORE_ASYNC_TRACE
+#include <kernel/delay.h>
+#include <kernel/notif.h>
+#endif
 
 const char trace_ext_prefix[] = "TC";
 int trace_level __nex_data = TRACE_LEVEL;
@@ -18,6 +28,259 @@ void __weak plat_trace_ext_puts(const char *str __unused)
 {
 }
 
+#ifdef CFG_CORE_ASYNC_TRACE
+#define RING_SIZE	CFG_CORE_ASYNC_TRACE_RING_SIZE
+
+static_assert(IS_POWER_OF_TWO(RING_SIZE));
+
+/*
+ * Once normal world has started the asynchronous notifications, each CPU
+ * appends its messages to its own ring, as a struct trace_rec followed by
+ * the characters of the message. The CPU owning a ring is the only one
+ * updating @head and @dropped, @tail and @reported are updated by the CPU
+ * printing the messages with puts_lock held, so no lock is needed to
+ * buffer a message.
+ *
+ * The messages are printed in the bottom half, requested when a standard
+ * call returns. Messages logged by the bottom half itself are left for
+ * the next request, otherwise each bottom half would request another one.
+ */
+struct trace_ring {
+	uint32_t head;
+	uint32_t tail;
+	uint32_t dropped;
+	uint32_t reported;
+	char buf[RING_SIZE];
+};
+
+struct trace_rec {
+	uint64_t stamp;
+	uint32_t len;
+};
+
+static struct trace_ring trace_rings[CFG_TEE_CORE_NB_CORE] __nex_bss;
+static bool trace_async __nex_bss;
+static bool drain_pending __nex_bss;
+static int drain_thread __nex_data = THREAD_ID_INVALID;
+
+static void ring_write(struct trace_ring *r, uint32_t pos, const void *data,
+		       size_t len)
+{
+	size_t offs = pos & (RING_SIZE - 1);
+	size_t l = MIN(len, RING_SIZE - offs);
+
+	memcpy(r->buf + offs, data, l);
+	memcpy(r->buf, (const char *)data + l, len - l);
+}
+
+static void ring_read(struct trace_ring *r, uint32_t pos, void *data,
+		      size_t len)
+{
+	size_t offs = pos & (RING_SIZE - 1);
+	size_t l = MIN(len, RING_SIZE - offs);
+
+	memcpy(data, r->buf + offs, l);
+	memcpy((char *)data + l, r->buf, len - l);
+}
+
+/* Called with all exceptions masked */
+static void ring_puts(const char *str)
+{
+	struct trace_ring *r = trace_rings + get_core_pos();
+	struct trace_rec rec = {
+		.stamp = timer_cnt_read(),
+		.len = strlen(str),
+	};
+	uint32_t head = r->head;
+	uint32_t tail = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+
+	if (sizeof(rec) + rec.len > RING_SIZE - (head - tail)) {
+		__atomic_store_n(&r->dropped, r->dropped + 1,
+				 __ATOMIC_RELAXED);
+		return;
+	}
+
+	ring_write(r, head, &rec, sizeof(rec));
+	ring_write(r, head + sizeof(rec), str, rec.len);
+	__atomic_store_n(&r->head, head + sizeof(rec) + rec.len,
+			 __ATOMIC_RELEASE);
+}
+
+static void console_puts(const char *str)
+{
+	for (; *str; str++)
+		console_putc(*str);
+}
+
+/*
+ * Prints the oldest buffered message of all CPUs, or reports the
+ * messages a CPU dropped. Called with puts_lock held, returns the number
+ * of bytes consumed from the rings.
+ */
+static size_t print_oldest(void)
+{
+	struct trace_rec rec = { };
+	struct trace_ring *r = NULL;
+	uint64_t stamp = UINT64_MAX;
+	size_t oldest = 0;
+	uint32_t dropped = 0;
+	char buf[48] = { };
+	uint32_t head = 0;
+	size_t n = 0;
+
+	for (n = 0; n < CFG_TEE_CORE_NB_CORE; n++) {
+		r = trace_rings + n;
+		dropped = __atomic_load_n(&r->dropped, __ATOMIC_RELAXED);
+		if (dropped != r->reported) {
+			snprintf(buf, sizeof(buf), "[%zu messages dropped]\n",
+				 (size_t)(dropped - r->reported));
+			console_puts(buf);
+			r->reported = dropped;
+		}
+
+		head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+		if (head == r->tail)
+			continue;
+		ring_read(r, r->tail, &rec, sizeof(rec));
+		if (rec.stamp < stamp) {
+			stamp = rec.stamp;
+			oldest = n;
+		}
+	}
+
+	if (stamp == UINT64_MAX)
+		return 0;
+
+	r = trace_rings + oldest;
+	ring_read(r, r->tail, &rec, sizeof(rec));
+	snprintf(buf, sizeof(buf), "[%"PRIu64"] ", rec.stamp);
+	console_puts(buf);
+	for (n = 0; n < rec.len; n++)
+		console_putc(r->buf[(r->tail + sizeof(rec) + n) &
+				    (RING_SIZE - 1)]);
+	console_flush();
+
+	__atomic_store_n(&r->tail, r->tail + sizeof(rec) + rec.len,
+			 __ATOMIC_RELEASE);
+
+	return sizeof(rec) + rec.len;
+}
+
+static size_t buffered_bytes(void)
+{
+	size_t len = 0;
+	size_t n = 0;
+
+	for (n = 0; n < CFG_TEE_CORE_NB_CORE; n++)
+		len += __atomic_load_n(&trace_rings[n].head,
+				       __ATOMIC_ACQUIRE) -
+		       __atomic_load_n(&trace_rings[n].tail,
+				       __ATOMIC_RELAXED);
+
+	return len;
+}
+
+static void trace_ext_drain(void)
+{
+	uint32_t exceptions = 0;
+	size_t budget = 0;
+	size_t len = 0;
+
+	if (!__atomic_load_n(&trace_async, __ATOMIC_ACQUIRE))
+		return;
+
+	/* Messages buffered while draining are left for the next time */
+	budget = buffered_bytes();
+
+	/* One message at a time to keep exceptions masked briefly */
+	while (budget) {
+		exceptions = thread_mask_exceptions(THREAD_EXCP_ALL);
+		cpu_spin_lock_no_dldetect(&puts_lock);
+		len = print_oldest();
+		cpu_spin_unlock(&puts_lock);
+		thread_unmask_exceptions(exceptions);
+
+		if (!len)
+			break;
+		budget -= MIN(len, budget);
+	}
+}
+
+void trace_ext_request_drain(void)
+{
+	int thread_id = thread_get_id_may_fail();
+
+	if (!__atomic_load_n(&trace_async, __ATOMIC_ACQUIRE))
+		return;
+
+	if (thread_id == __atomic_load_n(&drain_thread, __ATOMIC_RELAXED)) {
+		__atomic_store_n(&drain_thread, THREAD_ID_INVALID,
+				 __ATOMIC_RELAXED);
+		return;
+	}
+
+	if (buffered_bytes() &&
+	    !__atomic_exchange_n(&drain_pending, true, __ATOMIC_ACQ_REL))
+		notif_send_async(NOTIF_VALUE_DO_BOTTOM_HALF);
+}
+
+void trace_ext_sync(void)
+{
+	__atomic_store_n(&trace_async, false, __ATOMIC_RELEASE);
+	while (true) {
+		uint32_t exceptions = thread_mask_exceptions(THREAD_EXCP_ALL);
+		size_t len = 0;
+
+		cpu_spin_lock_no_dldetect(&puts_lock);
+		len = print_oldest();
+		cpu_spin_unlock(&puts_lock);
+		thread_unmask_exceptions(exceptions);
+
+		if (!len)
+			break;
+	}
+}
+
+static void atomic_trace_notif(struct notif_driver *ndrv __unused,
+			       enum notif_event ev)
+{
+	if (ev == NOTIF_EVENT_STARTED)
+		__atomic_store_n(&trace_async, true, __ATOMIC_RELEASE);
+}
+
+static void yielding_trace_notif(struct notif_driver *ndrv __unused,
+				 enum notif_event ev)
+{
+	switch (ev) {
+	case NOTIF_EVENT_DO_BOTTOM_HALF:
+		__atomic_store_n(&drain_pending, false, __ATOMIC_RELEASE);
+		trace_ext_drain();
+		__atomic_store_n(&drain_thread, thread_get_id(),
+				 __ATOMIC_RELAXED);
+		break;
+	case NOTIF_EVENT_STOPPED:
+		/* Nothing would print the buffered messages any longer */
+		trace_ext_sync();
+		break;
+	default:
+		break;
+	}
+}
+
+static struct notif_driver trace_notif = {
+	.atomic_cb = atomic_trace_notif,
+	.yielding_cb = yielding_trace_notif,
+};
+
+static TEE_Result trace_ext_async_init(void)
+{
+	notif_register_driver(&trace_notif);
+
+	return TEE_SUCCESS;
+}
+boot_final(trace_ext_async_init);
+#endif /*CFG_CORE_ASYNC_TRACE*/
+
 void trace_ext_puts(const char *str)
 {
 	uint32_t itr_status = thread_mask_exceptions(THREAD_EXCP_ALL);
@@ -25,6 +288,18 @@ void trace_ext_puts(const char *str)
 	bool was_contended = false;
 	const char *p;
 
+#ifdef CFG_CORE_ASYNC_TRACE
+	if (__atomic_load_n(&trace_async, __ATOMIC_ACQUIRE) && mmu_enabled) {
+		/* plat_trace_ext_puts() is serialized by puts_lock */
+		cpu_spin_lock_no_dldetect(&puts_lock);
+		plat_trace_ext_puts(str);
+		cpu_spin_unlock(&puts_lock);
+		ring_puts(str);
+		thread_unmask_exceptions(itr_status);
+		return;
+	}
+#endif
+
 	if (mmu_enabled && !cpu_spin_trylock(&puts_lock)) {
 		was_contended = true;
 		cpu_spin_lock_no_dldetect(&puts_lock);
@@ -361,6 +361,8 @@ static void free_utc(struct user_ta_ctx *utc)
 	tee_svc_cryp_free_states(utc);
 	/* Close cryp objects opened by this TA */
 	tee_obj_close_all(utc);
+	/* Drop the changes of an unfinished storage transaction */
+	tee_svc_storage_abort_trans(utc);
 	/* Free emums created by this TA */
 	tee_svc_storage_close_all_enum(utc);
 	free(utc);
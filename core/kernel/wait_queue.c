@@ -14,9 +14,6 @@
 #include <trace.h>
 #include <types_ext.h>
 
-static unsigned wq_spin_lock;
-
-
 void wq_init(struct wait_queue *wq)
 {
 	*wq = (struct wait_queue)WAIT_QUEUE_INITIALIZER;
@@ -40,18 +37,48 @@ static void do_notif(TEE_Result (*fn)(uint32_t), int id,
 		DMSG("%s thread %d res %#"PRIx32, cmd_str, id, res);
 }
 
-static void slist_add_tail(struct wait_queue *wq, struct wait_queue_elem *wqe)
+static void wq_add_tail(struct wait_queue *wq, struct wait_queue_elem *wqe)
+{
+	wqe->next = NULL;
+	wqe->prev = wq->last;
+	if (wq->last)
+		wq->last->next = wqe;
+	else
+		wq->first = wqe;
+	wq->last = wqe;
+}
+
+static void wq_remove(struct wait_queue *wq, struct wait_queue_elem *wqe)
+{
+	if (wqe->prev)
+		wqe->prev->next = wqe->next;
+	else
+		wq->first = wqe->next;
+	if (wqe->next)
+		wqe->next->prev = wqe->prev;
+	else
+		wq->last = wqe->prev;
+}
+
+/*
+ * Returns the first waiter to wake up, skipping condvar waiters and
+ * waiters already woken up. If @wait_read is not NULL only a waiter of
+ * the same type is returned.
+ */
+static struct wait_queue_elem *wq_find_next(struct wait_queue *wq,
+					    bool *wait_read)
 {
-	struct wait_queue_elem *wqe_iter;
-
-	/* Add elem to end of wait queue */
-	wqe_iter = SLIST_FIRST(wq);
-	if (wqe_iter) {
-		while (SLIST_NEXT(wqe_iter, link))
-			wqe_iter = SLIST_NEXT(wqe_iter, link);
-		SLIST_INSERT_AFTER(wqe_iter, wqe, link);
-	} else
-		SLIST_INSERT_HEAD(wq, wqe, link);
+	struct wait_queue_elem *wqe = NULL;
+
+	for (wqe = wq->first; wqe; wqe = wqe->next) {
+		if (wqe->cv || wqe->done)
+			continue;
+		if (wait_read && wqe->wait_read != *wait_read)
+			continue;
+		return wqe;
+	}
+
+	return NULL;
 }
 
 void wq_wait_init_condvar(struct wait_queue *wq, struct wait_queue_elem *wqe,
@@ -62,13 +89,14 @@ void wq_wait_init_condvar(struct wait_queue *wq, struct wait_queue_elem *wqe,
 	wqe->handle = thread_get_id();
 	wqe->done = false;
 	wqe->wait_read = wait_read;
+	wqe->handoff = false;
 	wqe->cv = cv;
 
-	old_itr_status = cpu_spin_lock_xsave(&wq_spin_lock);
+	old_itr_status = cpu_spin_lock_xsave(&wq->lock);
 
-	slist_add_tail(wq, wqe);
+	wq_add_tail(wq, wqe);
 
-	cpu_spin_unlock_xrestore(&wq_spin_lock, old_itr_status);
+	cpu_spin_unlock_xrestore(&wq->lock, old_itr_status);
 }
 
 void wq_wait_final(struct wait_queue *wq, struct wait_queue_elem *wqe,
@@ -81,13 +109,13 @@ void wq_wait_final(struct wait_queue *wq, struct wait_queue_elem *wqe,
 		do_notif(notif_wait, wqe->handle,
 			 "sleep", sync_obj, fname, lineno);
 
-		old_itr_status = cpu_spin_lock_xsave(&wq_spin_lock);
+		old_itr_status = cpu_spin_lock_xsave(&wq->lock);
 
 		done = wqe->done;
 		if (done)
-			SLIST_REMOVE(wq, wqe, wait_queue_elem, link);
+			wq_remove(wq, wqe);
 
-		cpu_spin_unlock_xrestore(&wq_spin_lock, old_itr_status);
+		cpu_spin_unlock_xrestore(&wq->lock, old_itr_status);
 	} while (!done);
 }
 
@@ -108,28 +136,24 @@ void wq_wake_next(struct wait_queue *wq, const void *sync_obj,
 	 */
 
 	while (true) {
-		old_itr_status = cpu_spin_lock_xsave(&wq_spin_lock);
-
-		SLIST_FOREACH(wqe, wq, link) {
-			if (wqe->cv)
-				continue;
-			if (wqe->done)
-				continue;
-			if (!wake_type_assigned) {
+		old_itr_status = cpu_spin_lock_xsave(&wq->lock);
+
+		if (wake_type_assigned) {
+			wqe = wq_find_next(wq, &wake_read);
+		} else {
+			wqe = wq_find_next(wq, NULL);
+			if (wqe) {
 				wake_read = wqe->wait_read;
 				wake_type_assigned = true;
 			}
-
-			if (wqe->wait_read != wake_read)
-				continue;
-
+		}
+		if (wqe) {
 			wqe->done = true;
 			handle = wqe->handle;
 			do_wakeup = true;
-			break;
 		}
 
-		cpu_spin_unlock_xrestore(&wq_spin_lock, old_itr_status);
+		cpu_spin_unlock_xrestore(&wq->lock, old_itr_status);
 
 		if (do_wakeup)
 			do_notif(notif_send_sync, handle,
@@ -141,6 +165,43 @@ void wq_wake_next(struct wait_queue *wq, const void *sync_obj,
 	}
 }
 
+int wq_handoff_next(struct wait_queue *wq)
+{
+	struct wait_queue_elem *wqe = NULL;
+	int handle = -1;
+
+	cpu_spin_lock(&wq->lock);
+
+	wqe = wq_find_next(wq, NULL);
+	if (wqe && !wqe->wait_read) {
+		wqe->done = true;
+		wqe->handoff = true;
+		handle = wqe->handle;
+	}
+
+	cpu_spin_unlock(&wq->lock);
+
+	return handle;
+}
+
+bool wq_have_writer(struct wait_queue *wq)
+{
+	bool wait_read = false;
+	bool rc = false;
+
+	cpu_spin_lock(&wq->lock);
+	rc = wq_find_next(wq, &wait_read);
+	cpu_spin_unlock(&wq->lock);
+
+	return rc;
+}
+
+void wq_wake_handle(int handle, const void *sync_obj, const char *fname,
+		    int lineno)
+{
+	do_notif(notif_send_sync, handle, "wake ", sync_obj, fname, lineno);
+}
+
 void wq_promote_condvar(struct wait_queue *wq, struct condvar *cv,
 			bool only_one, const void *sync_obj __unused,
 			const char *fname, int lineno __maybe_unused)
@@ -151,7 +212,7 @@ void wq_promote_condvar(struct wait_queue *wq, struct condvar *cv,
 	if (!cv)
 		return;
 
-	old_itr_status = cpu_spin_lock_xsave(&wq_spin_lock);
+	old_itr_status = cpu_spin_lock_xsave(&wq->lock);
 
 	/*
 	 * Find condvar waiter(s) and promote each to an active waiter.
@@ -159,7 +220,7 @@ void wq_promote_condvar(struct wait_queue *wq, struct condvar *cv,
 	 * condvar waiter is added to the queue when waiting for the
 	 * condvar.
 	 */
-	SLIST_FOREACH(wqe, wq, link) {
+	for (wqe = wq->first; wqe; wqe = wqe->next) {
 		if (wqe->cv == cv) {
 			if (fname)
 				FMSG("promote thread %u %p %s:%d",
@@ -174,7 +235,7 @@ void wq_promote_condvar(struct wait_queue *wq, struct condvar *cv,
 		}
 	}
 
-	cpu_spin_unlock_xrestore(&wq_spin_lock, old_itr_status);
+	cpu_spin_unlock_xrestore(&wq->lock, old_itr_status);
 }
 
 bool wq_have_condvar(struct wait_queue *wq, struct condvar *cv)
@@ -183,16 +244,16 @@ bool wq_have_condvar(struct wait_queue *wq, struct condvar *cv)
 	struct wait_queue_elem *wqe;
 	bool rc = false;
 
-	old_itr_status = cpu_spin_lock_xsave(&wq_spin_lock);
+	old_itr_status = cpu_spin_lock_xsave(&wq->lock);
 
-	SLIST_FOREACH(wqe, wq, link) {
+	for (wqe = wq->first; wqe; wqe = wqe->next) {
 		if (wqe->cv == cv) {
 			rc = true;
 			break;
 		}
 	}
 
-	cpu_spin_unlock_xrestore(&wq_spin_lock, old_itr_status);
+	cpu_spin_unlock_xrestore(&wq->lock, old_itr_status);
 
 	return rc;
 }
@@ -202,11 +263,11 @@ bool wq_is_empty(struct wait_queue *wq)
 	uint32_t old_itr_status;
 	bool ret;
 
-	old_itr_status = cpu_spin_lock_xsave(&wq_spin_lock);
+	old_itr_status = cpu_spin_lock_xsave(&wq->lock);
 
-	ret = SLIST_EMPTY(wq);
+	ret = !wq->first;
 
-	cpu_spin_unlock_xrestore(&wq_spin_lock, old_itr_status);
+	cpu_spin_unlock_xrestore(&wq->lock, old_itr_status);
 
 	return ret;
 }
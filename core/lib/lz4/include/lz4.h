@@ -0,0 +1,48 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+#ifndef __LZ4_H
+#define __LZ4_H
+
+#include <stddef.h>
+
+/*
+ * lz4_decompress() - Decompress an LZ4 block
+ * @src:	Compressed data, a single block in the LZ4 block format
+ * @src_len:	Size of @src in bytes
+ * @dst:	Output buffer
+ * @dst_size:	Size of @dst in bytes
+ *
+ * Only the block format is supported, not the LZ4 frame format. Matches
+ * may only reference data decompressed by the same call.
+ *
+ * Returns the number of bytes written to @dst or -1 if @src is malformed
+ * or doesn't fit in @dst.
+ */
+int lz4_decompress(const void *src, size_t src_len, void *dst,
+		   size_t dst_size);
+
+/* Size of the work memory of lz4_compress() */
+#define LZ4_COMPRESS_WRKMEM_SIZE	2048
+/* Maximum size of the input of lz4_compress() */
+#define LZ4_COMPRESS_MAX_INPUT		0xffff
+
+/*
+ * lz4_compress() - Compress data into an LZ4 block
+ * @src:	Data to compress, at most LZ4_COMPRESS_MAX_INPUT bytes
+ * @src_len:	Size of @src in bytes
+ * @dst:	Output buffer
+ * @dst_size:	Size of @dst in bytes
+ * @wrkmem:	Work memory of LZ4_COMPRESS_WRKMEM_SIZE bytes, 16-bit aligned
+ *
+ * The compression is greedy, it favors speed over compression ratio. The
+ * output can be decompressed with lz4_decompress().
+ *
+ * Returns the number of bytes written to @dst or -1 if the compressed data
+ * doesn't fit in @dst.
+ */
+int lz4_compress(const void *src, size_t src_len, void *dst, size_t dst_size,
+		 void *wrkmem);
+
+#endif /*__LZ4_H*/
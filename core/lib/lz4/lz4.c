@@ -0,0 +1,231 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#include <assert.h>
+#include <lz4.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+/* Size of the match offset following the literals of a sequence */
+#define LZ4_OFFSET_SIZE		2
+#define LZ4_MIN_MATCH		4
+#define LZ4_RUN_MASK		0xf
+/* The last bytes of a block are always literals */
+#define LZ4_LAST_LITERALS	5
+/* The last match starts at least this many bytes before the end */
+#define LZ4_MF_LIMIT		12
+#define LZ4_HASH_LOG		10
+
+/*
+ * Adds the extra length bytes following a token nibble set to
+ * LZ4_RUN_MASK: a sequence of bytes ended by one that isn't 255.
+ */
+static bool read_length(const uint8_t **ip, const uint8_t *iend, size_t *len)
+{
+	uint8_t b = 0;
+
+	do {
+		if (*ip >= iend)
+			return false;
+		b = *(*ip)++;
+		*len += b;
+	} while (b == 255);
+
+	return true;
+}
+
+int lz4_decompress(const void *src, size_t src_len, void *dst,
+		   size_t dst_size)
+{
+	const uint8_t *ip = src;
+	const uint8_t *iend = ip + src_len;
+	uint8_t *op = dst;
+	uint8_t *oend = op + dst_size;
+	const uint8_t *match = NULL;
+	size_t offset = 0;
+	uint8_t token = 0;
+	size_t len = 0;
+
+	while (ip < iend) {
+		token = *ip++;
+
+		/* Literals */
+		len = token >> 4;
+		if (len == LZ4_RUN_MASK && !read_length(&ip, iend, &len))
+			return -1;
+		if (len > (size_t)(iend - ip) || len > (size_t)(oend - op))
+			return -1;
+		memcpy(op, ip, len);
+		ip += len;
+		op += len;
+
+		/* The last sequence has no match */
+		if (ip == iend)
+			break;
+
+		/* Match */
+		if (iend - ip < LZ4_OFFSET_SIZE)
+			return -1;
+		offset = ip[0] | (ip[1] << 8);
+		ip += LZ4_OFFSET_SIZE;
+		if (!offset || offset > (size_t)(op - (uint8_t *)dst))
+			return -1;
+		match = op - offset;
+
+		len = token & LZ4_RUN_MASK;
+		if (len == LZ4_RUN_MASK && !read_length(&ip, iend, &len))
+			return -1;
+		len += LZ4_MIN_MATCH;
+		if (len > (size_t)(oend - op))
+			return -1;
+
+		if (offset >= len) {
+			memcpy(op, match, len);
+			op += len;
+		} else {
+			/* Overlapping copy repeating the last @offset bytes */
+			while (len--)
+				*op++ = *match++;
+		}
+	}
+
+	return op - (uint8_t *)dst;
+}
+
+static uint32_t read32(const uint8_t *p)
+{
+	uint32_t v = 0;
+
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static unsigned int hash32(uint32_t v)
+{
+	return (v * 2654435761U) >> (32 - LZ4_HASH_LOG);
+}
+
+static bool put_byte(uint8_t **op, uint8_t *oend, uint8_t b)
+{
+	if (*op >= oend)
+		return false;
+	*(*op)++ = b;
+	return true;
+}
+
+/* Writes the extra length bytes of a token nibble set to LZ4_RUN_MASK */
+static bool put_length(uint8_t **op, uint8_t *oend, size_t len)
+{
+	len -= LZ4_RUN_MASK;
+	while (len >= 255) {
+		if (!put_byte(op, oend, 255))
+			return false;
+		len -= 255;
+	}
+
+	return put_byte(op, oend, len);
+}
+
+/*
+ * Writes a sequence of @lit_len literals followed by a match of
+ * @match_len bytes at @offset, the last sequence has no match and
+ * @match_len 0.
+ */
+static bool put_sequence(uint8_t **op, uint8_t *oend, const uint8_t *lit,
+			 size_t lit_len, size_t offset, size_t match_len)
+{
+	uint8_t *token = *op;
+	uint8_t t = 0;
+
+	if (!put_byte(op, oend, 0))
+		return false;
+
+	if (lit_len >= LZ4_RUN_MASK) {
+		t = LZ4_RUN_MASK << 4;
+		if (!put_length(op, oend, lit_len))
+			return false;
+	} else {
+		t = lit_len << 4;
+	}
+	if (lit_len > (size_t)(oend - *op))
+		return false;
+	memcpy(*op, lit, lit_len);
+	*op += lit_len;
+
+	if (match_len) {
+		if (!put_byte(op, oend, offset) ||
+		    !put_byte(op, oend, offset >> 8))
+			return false;
+		match_len -= LZ4_MIN_MATCH;
+		if (match_len >= LZ4_RUN_MASK) {
+			t |= LZ4_RUN_MASK;
+			if (!put_length(op, oend, match_len))
+				return false;
+		} else {
+			t |= match_len;
+		}
+	}
+
+	*token = t;
+	return true;
+}
+
+int lz4_compress(const void *src, size_t src_len, void *dst, size_t dst_size,
+		 void *wrkmem)
+{
+	const uint8_t *base = src;
+	const uint8_t *iend = base + src_len;
+	const uint8_t *anchor = base;
+	const uint8_t *ip = base;
+	const uint8_t *match = NULL;
+	uint8_t *op = dst;
+	uint8_t *oend = op + dst_size;
+	uint16_t *table = wrkmem;
+	unsigned int h = 0;
+	size_t len = 0;
+
+	COMPILE_TIME_ASSERT(LZ4_COMPRESS_WRKMEM_SIZE ==
+			    sizeof(*table) << LZ4_HASH_LOG);
+
+	if (src_len > LZ4_COMPRESS_MAX_INPUT)
+		return -1;
+
+	/* Zeroed entries point at the start, candidates are all verified */
+	memset(table, 0, LZ4_COMPRESS_WRKMEM_SIZE);
+
+	if (src_len > LZ4_MF_LIMIT) {
+		for (ip = base + 1; ip <= iend - LZ4_MF_LIMIT; ) {
+			h = hash32(read32(ip));
+			match = base + table[h];
+			table[h] = ip - base;
+			if (read32(match) != read32(ip)) {
+				ip++;
+				continue;
+			}
+
+			while (ip > anchor && match > base &&
+			       ip[-1] == match[-1]) {
+				ip--;
+				match--;
+			}
+			len = LZ4_MIN_MATCH;
+			while (ip + len < iend - LZ4_LAST_LITERALS &&
+			       ip[len] == match[len])
+				len++;
+
+			if (!put_sequence(&op, oend, anchor, ip - anchor,
+					  ip - match, len))
+				return -1;
+			ip += len;
+			anchor = ip;
+		}
+	}
+
+	if (!put_sequence(&op, oend, anchor, iend - anchor, 0, 0))
+		return -1;
+
+	return op - (uint8_t *)dst;
+}
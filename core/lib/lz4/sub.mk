@@ -0,0 +1,2 @@
+global-incdirs-y += include
+srcs-y += lz4.c
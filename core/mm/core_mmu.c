@@ -1584,6 +1584,26 @@ static void set_region(struct core_mmu_table_info *tbl_info,
 	}
 }
 
+/* Like set_region(), with the contiguous hint where possible */
+static void set_user_region(struct core_mmu_table_info *tbl_info,
+			    struct tee_mmap_region *region)
+{
+	unsigned int first = core_mmu_va2idx(tbl_info, region->va);
+	unsigned int end = core_mmu_va2idx(tbl_info,
+					   region->va + region->size);
+	unsigned int idx = first;
+	paddr_t pa = region->pa;
+
+	while (idx < end) {
+		core_mmu_set_entry(tbl_info, idx, pa,
+				   core_mmu_user_contig_attr(tbl_info, idx,
+							     first, end, pa,
+							     region->attr));
+		idx++;
+		pa += BIT64(tbl_info->shift);
+	}
+}
+
 static void set_pg_region(struct core_mmu_table_info *dir_info,
 			  struct vm_region *region, struct pgt **pgt,
 			  struct core_mmu_table_info *pg_info)
@@ -1642,7 +1662,7 @@ static void set_pg_region(struct core_mmu_table_info *dir_info,
 			if (mobj_get_pa(region->mobj, offset, granule,
 					&r.pa) != TEE_SUCCESS)
 				panic("Failed to get PA of unpaged mobj");
-			set_region(pg_info, &r);
+			set_user_region(pg_info, &r);
 		}
 		r.va += r.size;
 	}
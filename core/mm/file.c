@@ -4,6 +4,7 @@
  */
 
 #include <kernel/panic.h>
+#include <kernel/percpu_rwlock.h>
 #include <kernel/refcount.h>
 #include <mm/file.h>
 #include <mm/fobj.h>
@@ -40,7 +41,8 @@ struct file {
 	SLIST_HEAD(, file_slice_elem) slice_head;
 };
 
-static struct mutex file_mu = MUTEX_INITIALIZER;
+/* Read locked by lookups, write locked to add or remove files */
+static struct percpu_rwlock file_list_lock = PERCPU_RWLOCK_INITIALIZER;
 static TAILQ_HEAD(, file) file_head = TAILQ_HEAD_INITIALIZER(file_head);
 
 static int file_tag_cmp(const struct file *f, const uint8_t *tag,
@@ -121,7 +123,16 @@ struct file *file_get_by_tag(const uint8_t *tag, unsigned int taglen)
 	if (taglen > sizeof(f->tag))
 		return NULL;
 
-	mutex_lock(&file_mu);
+	/* Files are usually shared, most lookups find the file */
+	percpu_rwlock_read_lock(&file_list_lock);
+	f = file_find_tag_unlocked(tag, taglen);
+	if (f && !refcount_inc(&f->refc))
+		f = NULL;
+	percpu_rwlock_read_unlock(&file_list_lock);
+	if (f)
+		return f;
+
+	percpu_rwlock_write_lock(&file_list_lock);
 
 	/*
 	 * If file is found and reference counter can be increased, we're done.
@@ -129,13 +140,13 @@ struct file *file_get_by_tag(const uint8_t *tag, unsigned int taglen)
 	 * If it's found but reference counter is 0, the situation is
 	 * a bit complicated:
 	 * - file_put() is about to free the file as soon as it can obtain the
-	 *   mutex.
+	 *   lock.
 	 * - Unless there's a mismatch between file_get() and file_put() only
 	 *   one thread calling file_put() is about to free the file.
 	 *
 	 * There's a window of opportunity where file_put() is called
-	 * (without a mutex being held, which is quite OK) while we're
-	 * holding the mutex here and are searching for the file and it's
+	 * (without a lock being held, which is quite OK) while we're
+	 * holding the lock here and are searching for the file and it's
 	 * found, but just after file_put() has decreased the reference
 	 * counter.
 	 *
@@ -159,7 +170,7 @@ struct file *file_get_by_tag(const uint8_t *tag, unsigned int taglen)
 	TAILQ_INSERT_HEAD(&file_head, f, link);
 
 out:
-	mutex_unlock(&file_mu);
+	percpu_rwlock_write_unlock(&file_list_lock);
 
 	return f;
 }
@@ -167,9 +178,9 @@ out:
 void file_put(struct file *f)
 {
 	if (f && refcount_dec(&f->refc)) {
-		mutex_lock(&file_mu);
+		percpu_rwlock_write_lock(&file_list_lock);
 		TAILQ_REMOVE(&file_head, f, link);
-		mutex_unlock(&file_mu);
+		percpu_rwlock_write_unlock(&file_list_lock);
 
 		file_free(f);
 	}
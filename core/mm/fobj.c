@@ -9,6 +9,9 @@
 #include <initcall.h>
 #include <kernel/boot.h>
 #include <kernel/panic.h>
+#ifdef CFG_CORE_PAGER_RW_COMPRESS
+#include <lz4.h>
+#endif
 #include <memtag.h>
 #include <mm/core_memprot.h>
 #include <mm/core_mmu.h>
@@ -30,19 +33,31 @@ struct rwp_aes_gcm_iv {
 
 #define RWP_AES_GCM_TAG_LEN	16
 
+/* The page was all zeroes when saved, nothing is stored */
+#define RWP_STATE_ZERO		BIT32(0)
+/* The page is stored compressed with LZ4 in @size bytes */
+#define RWP_STATE_LZ4		BIT32(1)
+
+/*
+ * A page is only stored compressed if it saves at least a quarter of the
+ * data to encrypt and decrypt.
+ */
+#define RWP_LZ4_MAX_SIZE	(SMALL_PAGE_SIZE * 3 / 4)
+
 struct rwp_state {
 	uint64_t iv;
 	uint8_t tag[RWP_AES_GCM_TAG_LEN];
+	uint32_t flags;
+	uint32_t size;
 };
 
 /*
- * Note that this struct is padded to a size which is a power of 2, this
- * guarantees that this state will not span two pages. This avoids a corner
- * case in the pager when making the state available.
+ * Note that this struct has a size which is a power of 2, this guarantees
+ * that this state will not span two pages. This avoids a corner case in
+ * the pager when making the state available.
  */
 struct rwp_state_padded {
 	struct rwp_state state;
-	uint64_t pad;
 };
 
 struct fobj_rwp_unpaged_iv {
@@ -64,6 +79,15 @@ static struct internal_aes_gcm_key rwp_ae_key;
 static struct rwp_state_padded *rwp_state_base;
 static uint8_t *rwp_store_base;
 
+#ifdef CFG_CORE_PAGER_RW_COMPRESS
+/*
+ * Compressed page and work memory of LZ4, only used while saving or
+ * loading a page which is serialized by the pager lock.
+ */
+static uint8_t rwp_lz4_buf[RWP_LZ4_MAX_SIZE];
+static uint16_t rwp_lz4_wrkmem[LZ4_COMPRESS_WRKMEM_SIZE / sizeof(uint16_t)];
+#endif
+
 static void fobj_init(struct fobj *fobj, const struct fobj_ops *ops,
 		      unsigned int num_pages)
 {
@@ -80,6 +104,42 @@ static void fobj_uninit(struct fobj *fobj)
 	tee_pager_invalidate_fobj(fobj);
 }
 
+static bool page_is_zero(const void *va)
+{
+	const uint64_t *p = va;
+	size_t n = 0;
+
+	for (n = 0; n < SMALL_PAGE_SIZE / sizeof(*p); n++)
+		if (p[n])
+			return false;
+
+	return true;
+}
+
+#ifdef CFG_CORE_PAGER_RW_COMPRESS
+static TEE_Result rwp_load_lz4_page(void *va, struct rwp_state *state,
+				    struct rwp_aes_gcm_iv *iv,
+				    const uint8_t *src)
+{
+	TEE_Result res = TEE_ERROR_GENERIC;
+
+	if (state->size > sizeof(rwp_lz4_buf))
+		return TEE_ERROR_CORRUPT_OBJECT;
+
+	res = internal_aes_gcm_dec(&rwp_ae_key, iv, sizeof(*iv), NULL, 0,
+				   src, state->size, rwp_lz4_buf,
+				   state->tag, sizeof(state->tag));
+	if (res)
+		return res;
+
+	if (lz4_decompress(rwp_lz4_buf, state->size, va,
+			   SMALL_PAGE_SIZE) != SMALL_PAGE_SIZE)
+		return TEE_ERROR_CORRUPT_OBJECT;
+
+	return TEE_SUCCESS;
+}
+#endif
+
 static TEE_Result rwp_load_page(void *va, struct rwp_state *state,
 				const uint8_t *src)
 {
@@ -87,15 +147,20 @@ static TEE_Result rwp_load_page(void *va, struct rwp_state *state,
 		.iv = { (vaddr_t)state, state->iv >> 32, state->iv }
 	};
 
-	if (!state->iv) {
+	if (!state->iv || (state->flags & RWP_STATE_ZERO)) {
 		/*
 		 * IV still zero which means that this is previously unused
-		 * page.
+		 * page, or the page was saved while all zeroes.
 		 */
 		memset(va, 0, SMALL_PAGE_SIZE);
 		return TEE_SUCCESS;
 	}
 
+#ifdef CFG_CORE_PAGER_RW_COMPRESS
+	if (state->flags & RWP_STATE_LZ4)
+		return rwp_load_lz4_page(va, state, &iv, src);
+#endif
+
 	return internal_aes_gcm_dec(&rwp_ae_key, &iv, sizeof(iv),
 				    NULL, 0, src, SMALL_PAGE_SIZE, va,
 				    state->tag, sizeof(state->tag));
@@ -106,6 +171,27 @@ static TEE_Result rwp_save_page(const void *va, struct rwp_state *state,
 {
 	size_t tag_len = sizeof(state->tag);
 	struct rwp_aes_gcm_iv iv = { };
+	const void *data = va;
+	int size = SMALL_PAGE_SIZE;
+
+	/* Zero pages, typically unused heap, are neither stored nor encrypted */
+	if (page_is_zero(va)) {
+		state->flags = RWP_STATE_ZERO;
+		return TEE_SUCCESS;
+	}
+
+	state->flags = 0;
+#ifdef CFG_CORE_PAGER_RW_COMPRESS
+	size = lz4_compress(va, SMALL_PAGE_SIZE, rwp_lz4_buf,
+			    sizeof(rwp_lz4_buf), rwp_lz4_wrkmem);
+	if (size > 0) {
+		state->flags = RWP_STATE_LZ4;
+		data = rwp_lz4_buf;
+	} else {
+		size = SMALL_PAGE_SIZE;
+	}
+#endif
+	state->size = size;
 
 	assert(state->iv + 1 > state->iv);
 
@@ -122,7 +208,7 @@ static TEE_Result rwp_save_page(const void *va, struct rwp_state *state,
 	iv.iv[2] = state->iv;
 
 	return internal_aes_gcm_enc(&rwp_ae_key, &iv, sizeof(iv),
-				    NULL, 0, va, SMALL_PAGE_SIZE, dst,
+				    NULL, 0, data, size, dst,
 				    state->tag, &tag_len);
 }
 
@@ -45,6 +45,11 @@
 #define TEE_MMU_UCACHE_DEFAULT_ATTR	(TEE_MATTR_MEM_TYPE_CACHED << \
 					 TEE_MATTR_MEM_TYPE_SHIFT)
 
+#ifdef CFG_CORE_MMU_USER_CONTIG_HINT
+/* Size mapped by a group of entries tagged with the contiguous hint */
+#define CONTIG_SIZE	(CORE_MMU_CONTIG_ENTRIES * SMALL_PAGE_SIZE)
+#endif
+
 static vaddr_t select_va_in_range(const struct vm_region *prev_reg,
 				  const struct vm_region *next_reg,
 				  const struct vm_region *reg,
@@ -171,10 +176,13 @@ static void set_pa_range(struct core_mmu_table_info *ti, vaddr_t va,
 			 paddr_t pa, size_t size, uint32_t attr)
 {
 	unsigned int end = core_mmu_va2idx(ti, va + size);
-	unsigned int idx = core_mmu_va2idx(ti, va);
+	unsigned int first = core_mmu_va2idx(ti, va);
+	unsigned int idx = first;
 
 	while (idx < end) {
-		core_mmu_set_entry(ti, idx, pa, attr);
+		core_mmu_set_entry(ti, idx, pa,
+				   core_mmu_user_contig_attr(ti, idx, first, end,
+							     pa, attr));
 		idx++;
 		pa += BIT64(ti->shift);
 	}
@@ -292,6 +300,29 @@ static TEE_Result umap_add_region(struct vm_info *vmi, struct vm_region *reg,
 	return TEE_ERROR_ACCESS_CONFLICT;
 }
 
+/*
+ * Returns the alignment to try first for the virtual address of @reg. If
+ * the physical address is aligned for the contiguous hint the virtual
+ * address should be too, or no group of entries can use the hint.
+ */
+static size_t contig_align(struct vm_region *reg __maybe_unused, size_t align)
+{
+#ifdef CFG_CORE_MMU_USER_CONTIG_HINT
+	paddr_t pa = 0;
+
+	if (reg->va || reg->size < CONTIG_SIZE || mobj_is_paged(reg->mobj) ||
+	    mobj_get_phys_granule(reg->mobj) < CONTIG_SIZE)
+		return align;
+	if (mobj_get_pa(reg->mobj, reg->offset, 0, &pa) ||
+	    !IS_ALIGNED(pa, CONTIG_SIZE))
+		return align;
+
+	return MAX(align, CONTIG_SIZE);
+#else
+	return align;
+#endif
+}
+
 TEE_Result vm_map_pad(struct user_mode_ctx *uctx, vaddr_t *va, size_t len,
 		      uint32_t prot, uint32_t flags, struct mobj *mobj,
 		      size_t offs, size_t pad_begin, size_t pad_end,
@@ -299,6 +330,7 @@ TEE_Result vm_map_pad(struct user_mode_ctx *uctx, vaddr_t *va, size_t len,
 {
 	TEE_Result res = TEE_SUCCESS;
 	struct vm_region *reg = NULL;
+	size_t reg_align = 0;
 	uint32_t attr = 0;
 
 	if (prot & ~TEE_MATTR_PROT_MASK)
@@ -327,7 +359,12 @@ TEE_Result vm_map_pad(struct user_mode_ctx *uctx, vaddr_t *va, size_t len,
 	reg->attr = attr | prot;
 	reg->flags = flags;
 
-	res = umap_add_region(&uctx->vm_info, reg, pad_begin, pad_end, align);
+	reg_align = contig_align(reg, align);
+	res = umap_add_region(&uctx->vm_info, reg, pad_begin, pad_end,
+			      reg_align);
+	if (res == TEE_ERROR_ACCESS_CONFLICT && reg_align != align)
+		res = umap_add_region(&uctx->vm_info, reg, pad_begin, pad_end,
+				      align);
 	if (res)
 		goto err_put_mobj;
 
@@ -410,6 +447,65 @@ static bool va_range_is_contiguous(struct vm_region *r0, vaddr_t va,
 	}
 }
 
+#ifdef CFG_CORE_MMU_USER_CONTIG_HINT
+/*
+ * Returns true if some entries mapping @r may carry the contiguous hint,
+ * that is if an aligned group of entries inside @r maps physically
+ * contiguous memory at an aligned address.
+ */
+static bool region_has_contig(struct vm_region *r)
+{
+	vaddr_t end = r->va + r->size;
+	vaddr_t va = ROUNDUP(r->va, CONTIG_SIZE);
+	paddr_t pa = 0;
+
+	if (mobj_is_paged(r->mobj) ||
+	    mobj_get_phys_granule(r->mobj) < CONTIG_SIZE)
+		return false;
+
+	for (; va < end && end - va >= CONTIG_SIZE; va += CONTIG_SIZE)
+		if (!mobj_get_pa(r->mobj, va - r->va + r->offset, 0, &pa) &&
+		    IS_ALIGNED(pa, CONTIG_SIZE))
+			return true;
+
+	return false;
+}
+
+/*
+ * Called once @r has been split at @va into @r and @r2. A group of
+ * entries tagged with the contiguous hint may now straddle the two
+ * regions. The group is unmapped and the TLB invalidated before it's
+ * mapped again without the hint, changing the hint of a live mapping
+ * requires a break-before-make sequence.
+ */
+static void break_contig_at(struct user_mode_ctx *uctx, struct vm_region *r,
+			    struct vm_region *r2, vaddr_t va)
+{
+	vaddr_t begin = MAX(ROUNDDOWN(va, CONTIG_SIZE), r->va);
+	vaddr_t end = MIN(ROUNDUP(va, CONTIG_SIZE), r2->va + r2->size);
+
+	if (mobj_is_paged(r->mobj) || IS_ALIGNED(va, CONTIG_SIZE))
+		return;
+
+	pgt_clear_range(uctx, begin, end);
+	tlbi_mva_range_asid(begin, end - begin, SMALL_PAGE_SIZE,
+			    uctx->vm_info.asid);
+	set_um_region(uctx, r);
+	set_um_region(uctx, r2);
+}
+#else
+static bool region_has_contig(struct vm_region *r __unused)
+{
+	return false;
+}
+
+static void break_contig_at(struct user_mode_ctx *uctx __unused,
+			    struct vm_region *r __unused,
+			    struct vm_region *r2 __unused, vaddr_t va __unused)
+{
+}
+#endif
+
 static TEE_Result split_vm_region(struct user_mode_ctx *uctx,
 				  struct vm_region *r, vaddr_t va)
 {
@@ -442,6 +538,8 @@ static TEE_Result split_vm_region(struct user_mode_ctx *uctx,
 
 	TAILQ_INSERT_AFTER(&uctx->vm_info.regions, r, r2, link);
 
+	break_contig_at(uctx, r, r2, va);
+
 	return TEE_SUCCESS;
 }
 
@@ -769,6 +867,17 @@ TEE_Result vm_set_prot(struct user_mode_ctx *uctx, vaddr_t va, size_t len,
 
 		if (!mobj_is_paged(r->mobj)) {
 			need_sync = true;
+			if (region_has_contig(r)) {
+				/*
+				 * Entries tagged with the contiguous hint
+				 * need a break-before-make sequence to be
+				 * changed.
+				 */
+				pgt_clear_range(uctx, r->va, r->va + r->size);
+				tlbi_mva_range_asid(r->va, r->size,
+						    SMALL_PAGE_SIZE,
+						    uctx->vm_info.asid);
+			}
 			set_um_region(uctx, r);
 			/*
 			 * Normally when set_um_region() is called we
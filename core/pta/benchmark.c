@@ -3,10 +3,16 @@
  * Copyright (c) 2017, Linaro Limited
  */
 #include <bench.h>
+#include <assert.h>
+#include <atomic.h>
 #include <compiler.h>
+#include <kernel/delay.h>
 #include <kernel/misc.h>
 #include <kernel/mutex.h>
 #include <kernel/pseudo_ta.h>
+#include <kernel/spinlock.h>
+#include <kernel/tee_ta_manager.h>
+#include <kernel/user_ta.h>
 #include <malloc.h>
 #include <mm/core_memprot.h>
 #include <mm/mobj.h>
@@ -29,6 +35,18 @@ static size_t bench_ts_size;
 static struct mutex bench_reg_mu = MUTEX_INITIALIZER;
 static struct mobj *bench_mobj;
 
+struct bench_tp_cpu {
+	unsigned int lock;
+	struct benchmark_tp_hist hist[BENCHMARK_TP_COUNT];
+	size_t head;
+	size_t count;
+	uint64_t lost;
+	struct benchmark_tp_event events[CFG_TEE_BENCHMARK_TP_EVENTS];
+};
+
+static struct bench_tp_cpu bench_tp_cpu[CFG_TEE_CORE_NB_CORE];
+static unsigned int bench_tp_enabled;
+
 static TEE_Result rpc_reg_global_buf(uint64_t type, paddr_t phta, size_t size)
 {
 	struct thread_param tpm = THREAD_PARAM_VALUE(IN, type, phta, size);
@@ -160,6 +178,132 @@ static TEE_Result unregister_benchmark(uint32_t type,
 	return res;
 }
 
+static void reset_tracepoints(void)
+{
+	struct bench_tp_cpu *tpc = NULL;
+	uint32_t exceptions = 0;
+	size_t n = 0;
+
+	for (n = 0; n < ARRAY_SIZE(bench_tp_cpu); n++) {
+		tpc = bench_tp_cpu + n;
+		exceptions = cpu_spin_lock_xsave(&tpc->lock);
+		memset(tpc->hist, 0, sizeof(tpc->hist));
+		tpc->head = 0;
+		tpc->count = 0;
+		tpc->lost = 0;
+		cpu_spin_unlock_xrestore(&tpc->lock, exceptions);
+	}
+}
+
+static TEE_Result enable_tracepoints(uint32_t type,
+				     TEE_Param p[TEE_NUM_PARAMS])
+{
+	if ((TEE_PARAM_TYPE_GET(type, 0) != TEE_PARAM_TYPE_VALUE_INPUT) ||
+		(TEE_PARAM_TYPE_GET(type, 1) != TEE_PARAM_TYPE_NONE) ||
+		(TEE_PARAM_TYPE_GET(type, 2) != TEE_PARAM_TYPE_NONE) ||
+		(TEE_PARAM_TYPE_GET(type, 3) != TEE_PARAM_TYPE_NONE)) {
+		return TEE_ERROR_BAD_PARAMETERS;
+	}
+
+	if (p[0].value.a) {
+		atomic_store_uint(&bench_tp_enabled, 0);
+		reset_tracepoints();
+		atomic_store_uint(&bench_tp_enabled, 1);
+	} else {
+		atomic_store_uint(&bench_tp_enabled, 0);
+	}
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result get_tracepoint_hist(uint32_t type,
+				      TEE_Param p[TEE_NUM_PARAMS])
+{
+	struct benchmark_tp_hist hist[BENCHMARK_TP_COUNT] = { };
+	struct benchmark_tp_hist *h = NULL;
+	struct bench_tp_cpu *tpc = NULL;
+	uint32_t exceptions = 0;
+	size_t n = 0;
+	size_t i = 0;
+	size_t b = 0;
+
+	if ((TEE_PARAM_TYPE_GET(type, 0) != TEE_PARAM_TYPE_MEMREF_OUTPUT) ||
+		(TEE_PARAM_TYPE_GET(type, 1) != TEE_PARAM_TYPE_NONE) ||
+		(TEE_PARAM_TYPE_GET(type, 2) != TEE_PARAM_TYPE_NONE) ||
+		(TEE_PARAM_TYPE_GET(type, 3) != TEE_PARAM_TYPE_NONE)) {
+		return TEE_ERROR_BAD_PARAMETERS;
+	}
+
+	if (p[0].memref.size < sizeof(hist) || !p[0].memref.buffer) {
+		p[0].memref.size = sizeof(hist);
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+
+	for (n = 0; n < ARRAY_SIZE(bench_tp_cpu); n++) {
+		tpc = bench_tp_cpu + n;
+		exceptions = cpu_spin_lock_xsave(&tpc->lock);
+		for (i = 0; i < BENCHMARK_TP_COUNT; i++) {
+			h = tpc->hist + i;
+			if (!h->count)
+				continue;
+			if (!hist[i].count || h->min_ns < hist[i].min_ns)
+				hist[i].min_ns = h->min_ns;
+			hist[i].max_ns = MAX(hist[i].max_ns, h->max_ns);
+			hist[i].count += h->count;
+			hist[i].sum_ns += h->sum_ns;
+			for (b = 0; b < BENCHMARK_TP_HIST_BUCKETS; b++)
+				hist[i].buckets[b] += h->buckets[b];
+		}
+		cpu_spin_unlock_xrestore(&tpc->lock, exceptions);
+	}
+
+	memcpy(p[0].memref.buffer, hist, sizeof(hist));
+	p[0].memref.size = sizeof(hist);
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result read_tracepoint_events(uint32_t type,
+					 TEE_Param p[TEE_NUM_PARAMS])
+{
+	struct benchmark_tp_event *ev = p[0].memref.buffer;
+	size_t max_ev = p[0].memref.size / sizeof(*ev);
+	struct bench_tp_cpu *tpc = NULL;
+	uint32_t exceptions = 0;
+	uint64_t lost = 0;
+	size_t num_ev = 0;
+	size_t n = 0;
+
+	if ((TEE_PARAM_TYPE_GET(type, 0) != TEE_PARAM_TYPE_MEMREF_OUTPUT) ||
+		(TEE_PARAM_TYPE_GET(type, 1) != TEE_PARAM_TYPE_VALUE_OUTPUT) ||
+		(TEE_PARAM_TYPE_GET(type, 2) != TEE_PARAM_TYPE_NONE) ||
+		(TEE_PARAM_TYPE_GET(type, 3) != TEE_PARAM_TYPE_NONE)) {
+		return TEE_ERROR_BAD_PARAMETERS;
+	}
+
+	if (!ev)
+		max_ev = 0;
+
+	for (n = 0; n < ARRAY_SIZE(bench_tp_cpu); n++) {
+		tpc = bench_tp_cpu + n;
+		exceptions = cpu_spin_lock_xsave(&tpc->lock);
+		while (tpc->count && num_ev < max_ev) {
+			ev[num_ev++] = tpc->events[tpc->head];
+			tpc->head = (tpc->head + 1) % ARRAY_SIZE(tpc->events);
+			tpc->count--;
+		}
+		lost += tpc->lost;
+		tpc->lost = 0;
+		cpu_spin_unlock_xrestore(&tpc->lock, exceptions);
+	}
+
+	p[0].memref.size = num_ev * sizeof(*ev);
+	p[1].value.a = MIN(lost, UINT32_MAX);
+	p[1].value.b = 0;
+
+	return TEE_SUCCESS;
+}
+
 static TEE_Result invoke_command(void *session_ctx __unused,
 		uint32_t cmd_id, uint32_t param_types,
 		TEE_Param params[TEE_NUM_PARAMS])
@@ -171,6 +315,12 @@ static TEE_Result invoke_command(void *session_ctx __unused,
 		return get_benchmark_memref(param_types, params);
 	case BENCHMARK_CMD_UNREGISTER:
 		return unregister_benchmark(param_types, params);
+	case BENCHMARK_CMD_TP_ENABLE:
+		return enable_tracepoints(param_types, params);
+	case BENCHMARK_CMD_TP_GET_HIST:
+		return get_tracepoint_hist(param_types, params);
+	case BENCHMARK_CMD_TP_READ_EVENTS:
+		return read_tracepoint_events(param_types, params);
 	default:
 		break;
 	}
@@ -213,3 +363,78 @@ void bm_timestamp(void)
 
 	thread_unmask_exceptions(exceptions);
 }
+
+uint64_t bm_tp_begin(void)
+{
+	if (!atomic_load_uint(&bench_tp_enabled))
+		return 0;
+
+	return timer_cnt_read();
+}
+
+void bm_tp_end_session(unsigned int tp, uint64_t begin, uint32_t session)
+{
+	struct benchmark_tp_event *ev = NULL;
+	struct benchmark_tp_hist *h = NULL;
+	struct bench_tp_cpu *tpc = NULL;
+	uint64_t duration = 0;
+	uint32_t exceptions = 0;
+	size_t cpu = 0;
+	size_t b = 0;
+
+	if (!begin || !atomic_load_uint(&bench_tp_enabled))
+		return;
+	assert(tp < BENCHMARK_TP_COUNT);
+
+	duration = timer_cnt_to_ns(timer_cnt_read() - begin);
+
+	exceptions = thread_mask_exceptions(THREAD_EXCP_ALL);
+	cpu = get_core_pos();
+	tpc = bench_tp_cpu + cpu;
+	cpu_spin_lock(&tpc->lock);
+
+	h = tpc->hist + tp;
+	if (!h->count || duration < h->min_ns)
+		h->min_ns = duration;
+	h->max_ns = MAX(h->max_ns, duration);
+	h->count++;
+	h->sum_ns += duration;
+	if (duration)
+		b = MIN(63 - __builtin_clzll(duration),
+			BENCHMARK_TP_HIST_BUCKETS - 1);
+	h->buckets[b]++;
+
+	/* Overwrite the oldest event when full */
+	if (tpc->count == ARRAY_SIZE(tpc->events)) {
+		tpc->head = (tpc->head + 1) % ARRAY_SIZE(tpc->events);
+		tpc->count--;
+		tpc->lost++;
+	}
+	ev = tpc->events + (tpc->head + tpc->count) % ARRAY_SIZE(tpc->events);
+	ev->begin_ns = timer_cnt_to_ns(begin);
+	ev->duration_ns = duration;
+	ev->session = session;
+	ev->tp = tp;
+	ev->cpu = cpu;
+	tpc->count++;
+
+	cpu_spin_unlock(&tpc->lock);
+	thread_unmask_exceptions(exceptions);
+}
+
+void bm_tp_end(unsigned int tp, uint64_t begin)
+{
+	struct ts_session *s = NULL;
+	uint32_t session = 0;
+
+	if (!begin)
+		return;
+
+	if (thread_get_id_may_fail() != THREAD_ID_INVALID) {
+		s = ts_get_current_session_may_fail();
+		if (s && (is_user_ta_ctx(s->ctx) || is_pseudo_ta_ctx(s->ctx)))
+			session = to_ta_session(s)->id;
+	}
+
+	bm_tp_end_session(tp, begin, session);
+}
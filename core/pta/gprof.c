@@ -3,9 +3,11 @@
  * Copyright (c) 2016, Linaro Limited
  */
 
+#include <config.h>
 #include <kernel/misc.h>
 #include <kernel/msg_param.h>
 #include <kernel/pseudo_ta.h>
+#include <kernel/sample_prof.h>
 #include <kernel/user_ta.h>
 #include <kernel/thread.h>
 #include <mm/core_memprot.h>
@@ -14,6 +16,7 @@
 #include <pta_gprof.h>
 #include <string.h>
 
+#if defined(CFG_TA_GPROF_SUPPORT)
 static TEE_Result gprof_send_rpc(TEE_UUID *uuid, void *buf, size_t len,
 				 uint32_t *id)
 {
@@ -139,6 +142,80 @@ static TEE_Result gprof_stop_pc_sampling(struct ts_session *s,
 
 	return TEE_SUCCESS;
 }
+#endif /*CFG_TA_GPROF_SUPPORT*/
+
+#if defined(CFG_CORE_SAMPLING_PROFILER)
+/* The session that started system-wide sampling, if any */
+static struct ts_session *sys_sampling_sess;
+
+static TEE_Result gprof_start_sys_sampling(uint32_t param_types,
+					   TEE_Param params[TEE_NUM_PARAMS])
+{
+	uint32_t exp_pt = TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+					  TEE_PARAM_TYPE_NONE,
+					  TEE_PARAM_TYPE_NONE,
+					  TEE_PARAM_TYPE_NONE);
+	TEE_Result res = TEE_SUCCESS;
+
+	if (exp_pt != param_types)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	res = sample_prof_start(params[0].value.a);
+	if (!res)
+		sys_sampling_sess = ts_get_current_session();
+
+	return res;
+}
+
+static TEE_Result gprof_stop_sys_sampling(uint32_t param_types)
+{
+	if (param_types != TEE_PARAM_TYPES(TEE_PARAM_TYPE_NONE,
+					   TEE_PARAM_TYPE_NONE,
+					   TEE_PARAM_TYPE_NONE,
+					   TEE_PARAM_TYPE_NONE))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	sample_prof_stop();
+	sys_sampling_sess = NULL;
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result gprof_read_sys_samples(uint32_t param_types,
+					 TEE_Param params[TEE_NUM_PARAMS])
+{
+	uint32_t exp_pt = TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_OUTPUT,
+					  TEE_PARAM_TYPE_NONE,
+					  TEE_PARAM_TYPE_NONE,
+					  TEE_PARAM_TYPE_NONE);
+	TEE_Result res = TEE_SUCCESS;
+	size_t len = 0;
+
+	if (exp_pt != param_types)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	len = params[0].memref.size;
+	if (!params[0].memref.buffer)
+		len = 0;
+	res = sample_prof_read(params[0].memref.buffer, &len);
+	params[0].memref.size = len;
+
+	return res;
+}
+
+static void close_session(void *sess_ctx __unused)
+{
+	/* Don't keep sampling once the controlling client is gone */
+	if (sys_sampling_sess == ts_get_current_session()) {
+		sample_prof_stop();
+		sys_sampling_sess = NULL;
+	}
+}
+#else
+static void close_session(void *sess_ctx __unused)
+{
+}
+#endif /*CFG_CORE_SAMPLING_PROFILER*/
 
 /*
  * Trusted Application Entry Points
@@ -150,10 +227,15 @@ static TEE_Result open_session(uint32_t param_types __unused,
 {
 	struct ts_session *s = ts_get_calling_session();
 
-	/* Check that we're called from a user TA */
-	if (!s)
+	/* Normal world clients may only use the system-wide profiler */
+	if (!s) {
+		if (IS_ENABLED(CFG_CORE_SAMPLING_PROFILER))
+			return TEE_SUCCESS;
 		return TEE_ERROR_ACCESS_DENIED;
-	if (!is_user_ta_ctx(s->ctx))
+	}
+
+	/* Check that we're called from a user TA */
+	if (!IS_ENABLED(CFG_TA_GPROF_SUPPORT) || !is_user_ta_ctx(s->ctx))
 		return TEE_ERROR_ACCESS_DENIED;
 
 	return TEE_SUCCESS;
@@ -165,6 +247,23 @@ static TEE_Result invoke_command(void *sess_ctx __unused, uint32_t cmd_id,
 {
 	struct ts_session *s = ts_get_calling_session();
 
+	if (!s) {
+#if defined(CFG_CORE_SAMPLING_PROFILER)
+		switch (cmd_id) {
+		case PTA_GPROF_START_SYS_SAMPLING:
+			return gprof_start_sys_sampling(param_types, params);
+		case PTA_GPROF_STOP_SYS_SAMPLING:
+			return gprof_stop_sys_sampling(param_types);
+		case PTA_GPROF_READ_SYS_SAMPLES:
+			return gprof_read_sys_samples(param_types, params);
+		default:
+			break;
+		}
+#endif
+		return TEE_ERROR_NOT_IMPLEMENTED;
+	}
+
+#if defined(CFG_TA_GPROF_SUPPORT)
 	switch (cmd_id) {
 	case PTA_GPROF_SEND:
 		return gprof_send(s, param_types, params);
@@ -175,10 +274,12 @@ static TEE_Result invoke_command(void *sess_ctx __unused, uint32_t cmd_id,
 	default:
 		break;
 	}
+#endif
 	return TEE_ERROR_NOT_IMPLEMENTED;
 }
 
 pseudo_ta_register(.uuid = PTA_GPROF_UUID, .name = "gprof",
 		   .flags = PTA_DEFAULT_FLAGS,
 		   .open_session_entry_point = open_session,
+		   .close_session_entry_point = close_session,
 		   .invoke_command_entry_point = invoke_command);
@@ -5,12 +5,16 @@
 #include <compiler.h>
 #include <stdio.h>
 #include <trace.h>
+#include <kernel/mutex.h>
 #include <kernel/pseudo_ta.h>
+#include <kernel/thread.h>
+#include <mm/mobj.h>
 #include <mm/tee_pager.h>
 #include <mm/tee_mm.h>
 #include <string.h>
 #include <string_ext.h>
 #include <malloc.h>
+#include <tee/tee_pobj.h>
 
 #define TA_NAME		"stats.ta"
 
@@ -37,6 +41,69 @@
  * uint32_t    Biggest byte size which allocation succeeded
  */
 #define STATS_CMD_TA_STATS		3
+/*
+ * STATS_CMD_SHM_COOKIE_STATS
+ * [in]     value[0].a       Non zero to reset the lookup counters
+ * [out]    memref[1]        Statistics of the shared memory cookie index
+ *
+ * uint64_t    Number of lookups by cookie since the last reset
+ * uint64_t    Number of objects compared during these lookups
+ * uint32_t    Number of registered shared memory objects
+ * uint32_t    Number of objects in the most loaded hash bucket
+ * uint32_t    Number of hash buckets
+ * uint32_t    Padding
+ */
+#define STATS_CMD_SHM_COOKIE_STATS	4
+/*
+ * STATS_CMD_RPC_SHM_CACHE_STATS
+ * [out]    memref[0]        Statistics of the RPC shared memory cache
+ *
+ * uint32_t    Allocations served by a buffer cached by the thread
+ * uint32_t    Allocations served by a buffer kept from a previous call
+ * uint32_t    Buffers allocated with an RPC to normal world
+ * uint32_t    Buffers freed with an RPC to normal world
+ * uint32_t    Buffers currently kept between calls
+ */
+#define STATS_CMD_RPC_SHM_CACHE_STATS	5
+/*
+ * STATS_CMD_POBJ_STATS
+ * [in]     value[0].a       Non zero to reset the lock counters
+ * [out]    memref[1]        Statistics of the open persistent objects
+ *
+ * uint64_t    Number of times a registry bucket was locked since the last
+ *             reset
+ * uint64_t    Number of these times the bucket was held by another thread
+ * uint32_t    Number of open persistent objects
+ * uint32_t    Number of objects in the most loaded hash bucket
+ * uint32_t    Number of hash buckets
+ * uint32_t    Padding
+ */
+#define STATS_CMD_POBJ_STATS		6
+/*
+ * STATS_CMD_THREAD_POOL_STATS
+ * [in]     value[0].a       Non zero to reset the counters
+ * [out]    memref[1]        Statistics of the thread pool
+ *
+ * uint64_t    Number of standard calls given a thread since the last reset
+ * uint64_t    Number of standard calls refused with a thread limit error
+ * uint32_t    Number of thread stacks allocated from the heap
+ * uint32_t    Number of thread stacks given back to the heap
+ * uint32_t    Number of thread stacks which couldn't be allocated
+ * uint32_t    Most threads in use at the same time
+ * uint32_t    Number of threads currently having a stack
+ * uint32_t    Maximum number of threads
+ */
+#define STATS_CMD_THREAD_POOL_STATS	7
+/*
+ * STATS_CMD_MUTEX_STATS
+ * [in]     value[0].a       Non zero to reset the counters
+ * [out]    memref[1]        Statistics of the contended mutexes
+ *
+ * uint32_t    Number of lock attempts finding a mutex write locked
+ * uint32_t    Number of locks taken after spinning, without sleeping
+ * uint32_t    Number of times a thread slept waiting for a mutex
+ */
+#define STATS_CMD_MUTEX_STATS		8
 
 #define STATS_NB_POOLS			4
 
@@ -175,6 +242,127 @@ static TEE_Result get_user_ta_stats(uint32_t type,
 	return res;
 }
 
+/*
+ * The commands below return a struct of @size bytes in a memref output.
+ * With @reset the memref is preceded by a value input, value.a requests
+ * a reset of the counters once they are read.
+ */
+static TEE_Result check_stats_out(uint32_t type, TEE_Param p[TEE_NUM_PARAMS],
+				  bool reset, size_t size)
+{
+	TEE_Param *out = reset ? p + 1 : p;
+
+	if (reset && TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+				     TEE_PARAM_TYPE_MEMREF_OUTPUT,
+				     TEE_PARAM_TYPE_NONE,
+				     TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+	if (!reset && TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_OUTPUT,
+				      TEE_PARAM_TYPE_NONE,
+				      TEE_PARAM_TYPE_NONE,
+				      TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (out->memref.size < size) {
+		out->memref.size = size;
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result copy_stats_out(TEE_Param *out, const void *stats,
+				 size_t size)
+{
+	memcpy(out->memref.buffer, stats, size);
+	out->memref.size = size;
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result get_shm_cookie_stats(uint32_t type,
+				       TEE_Param p[TEE_NUM_PARAMS])
+{
+	struct mobj_cookie_stats stats = { };
+	TEE_Result res = TEE_SUCCESS;
+
+	res = check_stats_out(type, p, true, sizeof(stats));
+	if (res)
+		return res;
+
+#if defined(CFG_CORE_FFA)
+	mobj_ffa_get_cookie_stats(&stats, p[0].value.a);
+#elif defined(CFG_CORE_DYN_SHM)
+	mobj_reg_shm_get_cookie_stats(&stats, p[0].value.a);
+#else
+	return TEE_ERROR_NOT_SUPPORTED;
+#endif
+
+	return copy_stats_out(p + 1, &stats, sizeof(stats));
+}
+
+static TEE_Result get_rpc_shm_cache_stats(uint32_t type,
+					  TEE_Param p[TEE_NUM_PARAMS])
+{
+	struct thread_shm_cache_stats stats = { };
+	TEE_Result res = TEE_SUCCESS;
+
+	res = check_stats_out(type, p, false, sizeof(stats));
+	if (res)
+		return res;
+
+	thread_rpc_shm_cache_get_stats(&stats);
+
+	return copy_stats_out(p, &stats, sizeof(stats));
+}
+
+static TEE_Result get_pobj_stats(uint32_t type, TEE_Param p[TEE_NUM_PARAMS])
+{
+	struct tee_pobj_stats stats = { };
+	TEE_Result res = TEE_SUCCESS;
+
+	res = check_stats_out(type, p, true, sizeof(stats));
+	if (res)
+		return res;
+
+#if defined(CFG_WITH_USER_TA) || defined(_CFG_WITH_SECURE_STORAGE)
+	tee_pobj_get_stats(&stats, p[0].value.a);
+#else
+	return TEE_ERROR_NOT_SUPPORTED;
+#endif
+
+	return copy_stats_out(p + 1, &stats, sizeof(stats));
+}
+
+static TEE_Result get_thread_pool_stats(uint32_t type,
+					TEE_Param p[TEE_NUM_PARAMS])
+{
+	struct thread_pool_stats stats = { };
+	TEE_Result res = TEE_SUCCESS;
+
+	res = check_stats_out(type, p, true, sizeof(stats));
+	if (res)
+		return res;
+
+	thread_get_pool_stats(&stats, p[0].value.a);
+
+	return copy_stats_out(p + 1, &stats, sizeof(stats));
+}
+
+static TEE_Result get_mutex_stats(uint32_t type, TEE_Param p[TEE_NUM_PARAMS])
+{
+	struct mutex_stats stats = { };
+	TEE_Result res = TEE_SUCCESS;
+
+	res = check_stats_out(type, p, true, sizeof(stats));
+	if (res)
+		return res;
+
+	mutex_get_stats(&stats, p[0].value.a);
+
+	return copy_stats_out(p + 1, &stats, sizeof(stats));
+}
+
 /*
  * Trusted Application Entry Points
  */
@@ -192,6 +380,16 @@ static TEE_Result invoke_command(void *psess __unused,
 		return get_memleak_stats(ptypes, params);
 	case STATS_CMD_TA_STATS:
 		return get_user_ta_stats(ptypes, params);
+	case STATS_CMD_SHM_COOKIE_STATS:
+		return get_shm_cookie_stats(ptypes, params);
+	case STATS_CMD_RPC_SHM_CACHE_STATS:
+		return get_rpc_shm_cache_stats(ptypes, params);
+	case STATS_CMD_POBJ_STATS:
+		return get_pobj_stats(ptypes, params);
+	case STATS_CMD_THREAD_POOL_STATS:
+		return get_thread_pool_stats(ptypes, params);
+	case STATS_CMD_MUTEX_STATS:
+		return get_mutex_stats(ptypes, params);
 	default:
 		break;
 	}
@@ -3,7 +3,9 @@ subdirs-$(CFG_TEE_CORE_EMBED_INTERNAL_TESTS) += tests
 srcs-$(CFG_ATTESTATION_PTA) += attestation.c
 srcs-$(CFG_TEE_BENCHMARK) += benchmark.c
 srcs-$(CFG_DEVICE_ENUM_PTA) += device.c
-srcs-$(CFG_TA_GPROF_SUPPORT) += gprof.c
+ifneq (,$(filter y,$(CFG_TA_GPROF_SUPPORT) $(CFG_CORE_SAMPLING_PROFILER)))
+srcs-y += gprof.c
+endif
 ifeq ($(CFG_WITH_USER_TA),y)
 srcs-$(CFG_SECSTOR_TA_MGMT_PTA) += secstor_ta_mgmt.c
 endif
@@ -0,0 +1,203 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#include <crypto/crypto.h>
+#include <drvcrypt.h>
+#include <drvcrypt_job.h>
+#include <kernel/tee_time.h>
+#include <malloc.h>
+#include <pta_invoke_tests.h>
+#include <string.h>
+#include <tee_api_defines.h>
+#include <trace.h>
+#include <utee_defines.h>
+#include <util.h>
+
+#include "misc.h"
+
+#define JOB_MAX_COUNT	32
+#define JOB_DATA_SIZE	1024
+
+static const uint8_t job_key[] = {
+	0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+	0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F,
+};
+
+struct job_test {
+	struct drvcrypt_job job;
+	struct drvcrypt_job_cipher cjob;
+	void *ctx;
+	uint8_t dst[JOB_DATA_SIZE];
+};
+
+/* Each job uses its own counter block so that all outputs differ */
+static TEE_Result init_ctx(void **ctx, size_t n)
+{
+	uint8_t iv[TEE_AES_BLOCK_SIZE] = { };
+	TEE_Result res = TEE_SUCCESS;
+
+	res = crypto_cipher_alloc_ctx(ctx, TEE_ALG_AES_CTR);
+	if (res)
+		return res;
+
+	iv[0] = n;
+	res = crypto_cipher_init(*ctx, TEE_MODE_ENCRYPT, job_key,
+				 sizeof(job_key), NULL, 0, iv, sizeof(iv));
+	if (res) {
+		crypto_cipher_free_ctx(*ctx);
+		*ctx = NULL;
+	}
+
+	return res;
+}
+
+static uint32_t elapsed_ms(TEE_Time *start)
+{
+	TEE_Time end = { };
+
+	tee_time_get_sys_time(&end);
+
+	return (end.seconds - start->seconds) * 1000 + end.millis -
+	       start->millis;
+}
+
+/*
+ * Encrypts the same data with each job through the queue, then again with
+ * the synchronous cipher API to check the results.
+ */
+static TEE_Result run_jobs(struct drvcrypt_job_queue *queue,
+			   struct job_test *jt, size_t count,
+			   const uint8_t *src,
+			   TEE_Param params[TEE_NUM_PARAMS])
+{
+	uint8_t ref[JOB_DATA_SIZE] = { };
+	TEE_Result res = TEE_SUCCESS;
+	TEE_Result r = TEE_SUCCESS;
+	TEE_Time start = { };
+	void *ctx = NULL;
+	size_t n = 0;
+
+	for (n = 0; n < count; n++) {
+		res = init_ctx(&jt[n].ctx, n);
+		if (res)
+			return res;
+		jt[n].cjob = (struct drvcrypt_job_cipher){
+			.ctx = jt[n].ctx,
+			.encrypt = true,
+			.src = { .data = (uint8_t *)src,
+				 .length = JOB_DATA_SIZE },
+			.dst = { .data = jt[n].dst, .length = JOB_DATA_SIZE },
+		};
+		jt[n].job.data = &jt[n].cjob;
+	}
+
+	tee_time_get_sys_time(&start);
+	for (n = 0; n < count; n++) {
+		res = drvcrypt_job_submit(queue, &jt[n].job);
+		if (res)
+			break;
+	}
+	/* The submitted jobs use the contexts, wait for all of them */
+	count = n;
+	for (n = 0; n < count; n++) {
+		r = drvcrypt_job_wait(&jt[n].job);
+		if (!res)
+			res = r;
+	}
+	if (res)
+		return res;
+	params[1].value.b = elapsed_ms(&start);
+
+	tee_time_get_sys_time(&start);
+	for (n = 0; n < count; n++) {
+		res = init_ctx(&ctx, n);
+		if (!res)
+			res = crypto_cipher_update(ctx, TEE_MODE_ENCRYPT, true,
+						   src, JOB_DATA_SIZE, ref);
+		crypto_cipher_free_ctx(ctx);
+		ctx = NULL;
+		if (res)
+			return res;
+		if (memcmp(ref, jt[n].dst, JOB_DATA_SIZE)) {
+			EMSG("Job %zu: unexpected output", n);
+			return TEE_ERROR_GENERIC;
+		}
+	}
+	params[1].value.a = elapsed_ms(&start);
+
+	return TEE_SUCCESS;
+}
+
+/*
+ * [in]     value[0].a	Number of jobs, at most JOB_MAX_COUNT
+ * [out]    value[1].a	Time in ms with the synchronous cipher API
+ * [out]    value[1].b	Time in ms through the job queue
+ * [out]    value[2].a	Number of batches passed to the backend
+ * [out]    value[2].b	Maximum number of jobs waiting for a slot
+ */
+TEE_Result core_drvcrypt_job_tests(uint32_t param_types,
+				   TEE_Param params[TEE_NUM_PARAMS])
+{
+	uint32_t exp_pt = TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+					  TEE_PARAM_TYPE_VALUE_OUTPUT,
+					  TEE_PARAM_TYPE_VALUE_OUTPUT,
+					  TEE_PARAM_TYPE_NONE);
+	struct drvcrypt_job_stats before = { };
+	struct drvcrypt_job_stats after = { };
+	struct drvcrypt_job_queue *queue = NULL;
+	TEE_Result res = TEE_SUCCESS;
+	struct job_test *jt = NULL;
+	uint8_t *src = NULL;
+	size_t count = 0;
+	size_t n = 0;
+
+	if (param_types != exp_pt)
+		return TEE_ERROR_BAD_PARAMETERS;
+	count = params[0].value.a;
+	if (!count || count > JOB_MAX_COUNT)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	queue = drvcrypt_get_job_queue(CRYPTO_CIPHER);
+	if (!queue)
+		return TEE_ERROR_NOT_SUPPORTED;
+
+	memset(params + 1, 0, 2 * sizeof(*params));
+
+	jt = calloc(count, sizeof(*jt));
+	src = malloc(JOB_DATA_SIZE);
+	if (!jt || !src) {
+		res = TEE_ERROR_OUT_OF_MEMORY;
+		goto out;
+	}
+	for (n = 0; n < JOB_DATA_SIZE; n++)
+		src[n] = n;
+
+	drvcrypt_job_get_stats(queue, &before);
+	res = run_jobs(queue, jt, count, src, params);
+	drvcrypt_job_get_stats(queue, &after);
+	if (res)
+		goto out;
+
+	if (after.submitted - before.submitted != count ||
+	    after.completed - before.completed != count) {
+		EMSG("Unexpected job count");
+		res = TEE_ERROR_GENERIC;
+		goto out;
+	}
+	params[2].value.a = after.batches - before.batches;
+	params[2].value.b = after.max_queued;
+
+	IMSG("%zu jobs: sync %"PRIu32" ms, queued %"PRIu32" ms, %"PRIu32
+	     " batches", count, params[1].value.a, params[1].value.b,
+	     params[2].value.a);
+out:
+	if (jt)
+		for (n = 0; n < count; n++)
+			crypto_cipher_free_ctx(jt[n].ctx);
+	free(jt);
+	free(src);
+
+	return res;
+}
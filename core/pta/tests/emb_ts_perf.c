@@ -0,0 +1,119 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#include <kernel/early_ta.h>
+#include <kernel/embedded_ts.h>
+#include <kernel/tee_time.h>
+#include <pta_invoke_tests.h>
+#include <stdlib.h>
+#include <string.h>
+#include <trace.h>
+#include <util.h>
+
+#include "misc.h"
+
+#define READ_SIZE	4096
+
+/* The early TA emb_ts_open() opens, see find_ta() */
+static const struct embedded_ts *cur_ta;
+
+static const struct embedded_ts *find_ta(const TEE_UUID *uuid __unused)
+{
+	return cur_ta;
+}
+
+static TEE_Result read_ta(uint8_t *buf)
+{
+	struct ts_store_handle *h = NULL;
+	TEE_Result res = TEE_SUCCESS;
+	size_t size = 0;
+	size_t n = 0;
+
+	res = emb_ts_open(&cur_ta->uuid, &h, find_ta);
+	if (res)
+		return res;
+
+	emb_ts_get_size(h, &size);
+	for (n = 0; n < size && !res; n += READ_SIZE)
+		res = emb_ts_read(h, buf, MIN(size - n, (size_t)READ_SIZE));
+
+	emb_ts_close(h);
+
+	return res;
+}
+
+/*
+ * [in]     value[0].a	Number of times each early TA is decompressed
+ * [out]    value[1].a	Total size of the compressed early TAs
+ * [out]    value[1].b	Total size of the early TAs once decompressed
+ * [out]    value[2].a	Decompression throughput in KiB/s of output, 0 if
+ *			too fast to be measured
+ * [out]    value[2].b	Compression format, one of EMB_TS_COMPRESS_*
+ */
+TEE_Result core_emb_ts_perf_tests(uint32_t param_types,
+				  TEE_Param params[TEE_NUM_PARAMS])
+{
+	uint32_t exp_pt = TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+					  TEE_PARAM_TYPE_VALUE_OUTPUT,
+					  TEE_PARAM_TYPE_VALUE_OUTPUT,
+					  TEE_PARAM_TYPE_NONE);
+	const struct embedded_ts *ta = NULL;
+	TEE_Result res = TEE_SUCCESS;
+	uint32_t rep_count = 0;
+	uint64_t total = 0;
+	TEE_Time start = { };
+	TEE_Time end = { };
+	uint8_t *buf = NULL;
+	uint32_t ms = 0;
+	uint32_t n = 0;
+
+	if (param_types != exp_pt || !params[0].value.a)
+		return TEE_ERROR_BAD_PARAMETERS;
+	rep_count = params[0].value.a;
+
+	memset(params + 1, 0, 2 * sizeof(*params));
+
+	buf = malloc(READ_SIZE);
+	if (!buf)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	tee_time_get_sys_time(&start);
+	for_each_early_ta(ta) {
+		if (!ta->uncompressed_size)
+			continue;
+
+		params[1].value.a += ta->size;
+		params[1].value.b += ta->uncompressed_size;
+		params[2].value.b = ta->compression;
+
+		cur_ta = ta;
+		for (n = 0; n < rep_count; n++) {
+			res = read_ta(buf);
+			if (res)
+				goto out;
+			total += ta->uncompressed_size;
+		}
+	}
+	tee_time_get_sys_time(&end);
+
+	if (!total) {
+		res = TEE_ERROR_ITEM_NOT_FOUND;
+		goto out;
+	}
+
+	ms = (end.seconds - start.seconds) * 1000 + end.millis - start.millis;
+	if (ms)
+		params[2].value.a = total / 1024 * 1000 / ms;
+
+	IMSG("early TAs: %"PRIu32" -> %"PRIu32" bytes, %s, %"PRIu32" KiB/s",
+	     params[1].value.a, params[1].value.b,
+	     params[2].value.b == EMB_TS_COMPRESS_LZ4 ? "LZ4" : "DEFLATE",
+	     params[2].value.a);
+out:
+	cur_ta = NULL;
+	free(buf);
+
+	return res;
+}
@@ -0,0 +1,210 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#include <kernel/ts_manager.h>
+#include <string.h>
+#include <tee/tee_fs.h>
+#include <tee/tee_pobj.h>
+#include <trace.h>
+#include <types_ext.h>
+
+#include "misc.h"
+
+#define TEST_DATA_SIZE	64
+
+static const char test_obj_id[] = "fs_trans_test";
+
+static TEE_Result check_data(struct tee_file_handle *fh, uint8_t val)
+{
+	uint8_t buf[TEST_DATA_SIZE] = { };
+	size_t len = sizeof(buf);
+	TEE_Result res = TEE_SUCCESS;
+	size_t n = 0;
+
+	res = ree_fs_ops.read(fh, 0, buf, &len);
+	if (res)
+		return res;
+	if (len != sizeof(buf))
+		return TEE_ERROR_GENERIC;
+	for (n = 0; n < len; n++)
+		if (buf[n] != val)
+			return TEE_ERROR_GENERIC;
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result check_object(struct tee_pobj *po, uint8_t val)
+{
+	struct tee_file_handle *fh = NULL;
+	TEE_Result res = TEE_SUCCESS;
+
+	res = ree_fs_ops.open(po, NULL, &fh);
+	if (res)
+		return res;
+	res = check_data(fh, val);
+	ree_fs_ops.close(&fh);
+
+	return res;
+}
+
+/*
+ * Writes @new_val over the object in a transaction, checks that the
+ * handle sees the update and ends the transaction with @commit.
+ */
+static TEE_Result write_in_trans(struct ts_ctx *ctx, struct tee_pobj *po,
+				 uint8_t old_val, uint8_t new_val, bool commit)
+{
+	uint8_t buf[TEST_DATA_SIZE] = { };
+	struct tee_file_handle *fh = NULL;
+	TEE_Result res = TEE_SUCCESS;
+	TEE_Result res2 = TEE_SUCCESS;
+
+	res = ree_fs_ops.begin_transaction(ctx);
+	if (res)
+		return res;
+
+	if (ree_fs_ops.begin_transaction(ctx) != TEE_ERROR_BAD_STATE) {
+		EMSG("Nested transaction accepted");
+		res = TEE_ERROR_GENERIC;
+		goto out;
+	}
+
+	res = ree_fs_ops.open(po, NULL, &fh);
+	if (res)
+		goto out;
+
+	memset(buf, new_val, sizeof(buf));
+	res = ree_fs_ops.write(fh, 0, buf, sizeof(buf));
+	if (!res)
+		res = check_data(fh, new_val);
+out:
+	res2 = ree_fs_ops.end_transaction(ctx, commit);
+	if (!res)
+		res = res2;
+
+	/* An aborted update is dropped from the handles still open too */
+	if (fh) {
+		if (!res)
+			res = check_data(fh, commit ? new_val : old_val);
+		ree_fs_ops.close(&fh);
+	}
+
+	return res;
+}
+
+/*
+ * Replaces the object with a new one in a transaction which is aborted.
+ * The handle of the new object must be dead and the object unchanged.
+ */
+static TEE_Result create_in_trans(struct ts_ctx *ctx, struct tee_pobj *po,
+				  uint8_t old_val)
+{
+	uint8_t buf[TEST_DATA_SIZE] = { };
+	struct tee_file_handle *fh = NULL;
+	size_t len = sizeof(buf);
+	TEE_Result res = TEE_SUCCESS;
+
+	res = ree_fs_ops.begin_transaction(ctx);
+	if (res)
+		return res;
+
+	memset(buf, old_val + 1, sizeof(buf));
+	res = ree_fs_ops.create(po, true, NULL, 0, NULL, 0, buf, sizeof(buf),
+				&fh);
+	if (!res)
+		res = check_data(fh, old_val + 1);
+
+	if (ree_fs_ops.end_transaction(ctx, false) && !res)
+		res = TEE_ERROR_GENERIC;
+	if (!fh)
+		return res;
+
+	if (!res &&
+	    (ree_fs_ops.write(fh, 0, buf, sizeof(buf)) != TEE_ERROR_BAD_STATE ||
+	     ree_fs_ops.truncate(fh, 0) != TEE_ERROR_BAD_STATE ||
+	     ree_fs_ops.read(fh, 0, buf, &len) != TEE_ERROR_BAD_STATE)) {
+		EMSG("Handle of an aborted creation still usable");
+		res = TEE_ERROR_GENERIC;
+	}
+	ree_fs_ops.close(&fh);
+
+	return res;
+}
+
+static TEE_Result test_trans(struct ts_ctx *ctx, struct tee_pobj *po)
+{
+	uint8_t buf[TEST_DATA_SIZE] = { };
+	struct tee_file_handle *fh = NULL;
+	TEE_Result res = TEE_SUCCESS;
+
+	if (ree_fs_ops.end_transaction(ctx, true) != TEE_ERROR_BAD_STATE) {
+		EMSG("Transaction ended before it began");
+		return TEE_ERROR_GENERIC;
+	}
+
+	memset(buf, 1, sizeof(buf));
+	res = ree_fs_ops.create(po, true, NULL, 0, NULL, 0, buf, sizeof(buf),
+				&fh);
+	if (res)
+		return res;
+	ree_fs_ops.close(&fh);
+
+	res = write_in_trans(ctx, po, 1, 2, false);
+	if (res) {
+		EMSG("Aborted transaction: %#"PRIx32, res);
+		return res;
+	}
+	res = check_object(po, 1);
+	if (res) {
+		EMSG("Object updated by an aborted transaction");
+		return res;
+	}
+
+	res = write_in_trans(ctx, po, 1, 3, true);
+	if (res) {
+		EMSG("Committed transaction: %#"PRIx32, res);
+		return res;
+	}
+	res = check_object(po, 3);
+	if (res) {
+		EMSG("Object not updated by a committed transaction");
+		return res;
+	}
+
+	res = create_in_trans(ctx, po, 3);
+	if (res) {
+		EMSG("Aborted creation: %#"PRIx32, res);
+		return res;
+	}
+	res = check_object(po, 3);
+	if (res)
+		EMSG("Object replaced by an aborted transaction");
+
+	return res;
+}
+
+TEE_Result core_fs_trans_tests(uint32_t param_types,
+			       TEE_Param params[TEE_NUM_PARAMS] __unused)
+{
+	struct ts_session *sess = ts_get_current_session();
+	struct tee_pobj po = {
+		.uuid = sess->ctx->uuid,
+		.obj_id = (void *)test_obj_id,
+		.obj_id_len = sizeof(test_obj_id),
+		.fops = &ree_fs_ops,
+	};
+	TEE_Result res = TEE_SUCCESS;
+
+	if (param_types != TEE_PARAM_TYPES(TEE_PARAM_TYPE_NONE,
+					   TEE_PARAM_TYPE_NONE,
+					   TEE_PARAM_TYPE_NONE,
+					   TEE_PARAM_TYPE_NONE))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	res = test_trans(sess->ctx, &po);
+	ree_fs_ops.remove(&po);
+
+	return res;
+}
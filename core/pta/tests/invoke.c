@@ -424,6 +424,8 @@ static TEE_Result invoke_command(void *pSessionContext __unused,
 #if defined(CFG_REE_FS) && defined(CFG_WITH_USER_TA)
 	case PTA_INVOKE_TESTS_CMD_FS_HTREE:
 		return core_fs_htree_tests(nParamTypes, pParams);
+	case PTA_INVOKE_TESTS_CMD_FS_TRANS:
+		return core_fs_trans_tests(nParamTypes, pParams);
 #endif
 	case PTA_INVOKE_TESTS_CMD_MUTEX:
 		return core_mutex_tests(nParamTypes, pParams);
@@ -433,6 +435,14 @@ static TEE_Result invoke_command(void *pSessionContext __unused,
 		return core_aes_perf_tests(nParamTypes, pParams);
 	case PTA_INVOKE_TESTS_CMD_DT_DRIVER_TESTS:
 		return core_dt_driver_tests(nParamTypes, pParams);
+	case PTA_INVOKE_TESTS_CMD_SOCKET_BATCH:
+		return core_socket_batch_tests(nParamTypes, pParams);
+	case PTA_INVOKE_TESTS_CMD_EMB_TS_PERF:
+		return core_emb_ts_perf_tests(nParamTypes, pParams);
+	case PTA_INVOKE_TESTS_CMD_TLB_PERF:
+		return core_tlb_perf_tests(nParamTypes, pParams);
+	case PTA_INVOKE_TESTS_CMD_DRVCRYPT_JOB:
+		return core_drvcrypt_job_tests(nParamTypes, pParams);
 	default:
 		break;
 	}
@@ -0,0 +1,142 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#include <lz4.h>
+#include <malloc.h>
+#include <mm/core_mmu.h>
+#include <string.h>
+#include <trace.h>
+#include <util.h>
+
+#include "misc.h"
+
+/* Worst case size of the LZ4 block of a page which doesn't compress */
+#define LZ4_PAGE_BOUND	(SMALL_PAGE_SIZE + SMALL_PAGE_SIZE / 255 + 16)
+
+enum page_kind { PAGE_ZERO, PAGE_RANDOM, PAGE_REPEAT };
+
+static void fill_page(uint8_t *page, enum page_kind kind)
+{
+	uint32_t x = 0x12345678;
+	size_t n = 0;
+
+	for (n = 0; n < SMALL_PAGE_SIZE; n++) {
+		switch (kind) {
+		case PAGE_ZERO:
+			page[n] = 0;
+			break;
+		case PAGE_RANDOM:
+			/* xorshift32 */
+			x ^= x << 13;
+			x ^= x >> 17;
+			x ^= x << 5;
+			page[n] = x;
+			break;
+		case PAGE_REPEAT:
+			page[n] = "repetitive page content "[n % 24];
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+/*
+ * Compresses a page into @dst of @dst_size bytes and, unless it doesn't
+ * fit, decompresses it back. Returns the compressed size, -1 if it
+ * doesn't fit or -2 if the page doesn't survive the round trip.
+ */
+static int round_trip(const uint8_t *page, uint8_t *dst, size_t dst_size,
+		      uint8_t *out, void *wrkmem)
+{
+	int clen = 0;
+
+	clen = lz4_compress(page, SMALL_PAGE_SIZE, dst, dst_size, wrkmem);
+	if (clen < 0)
+		return -1;
+	if (clen > (int)dst_size)
+		return -2;
+
+	memset(out, 0xa5, SMALL_PAGE_SIZE);
+	if (lz4_decompress(dst, clen, out, SMALL_PAGE_SIZE) !=
+	    (int)SMALL_PAGE_SIZE ||
+	    memcmp(page, out, SMALL_PAGE_SIZE))
+		return -2;
+
+	/* The output buffer must be large enough for the whole page */
+	if (lz4_decompress(dst, clen, out, SMALL_PAGE_SIZE - 1) != -1)
+		return -2;
+
+	return clen;
+}
+
+static int test_page(enum page_kind kind, uint8_t *page, uint8_t *dst,
+		     uint8_t *out, void *wrkmem)
+{
+	int clen = 0;
+
+	fill_page(page, kind);
+
+	/* Anything compresses into a buffer of the worst case size */
+	clen = round_trip(page, dst, LZ4_PAGE_BOUND, out, wrkmem);
+	if (clen < 0)
+		return -1;
+	DMSG("page %d: %d bytes", kind, clen);
+
+	switch (kind) {
+	case PAGE_RANDOM:
+		/* The pager stores such a page uncompressed */
+		if (clen < (int)SMALL_PAGE_SIZE ||
+		    round_trip(page, dst, SMALL_PAGE_SIZE, out, wrkmem) != -1)
+			return -1;
+		break;
+	default:
+		if (clen > (int)SMALL_PAGE_SIZE / 4)
+			return -1;
+		/* The same block when the output is just large enough */
+		if (round_trip(page, dst, clen, out, wrkmem) != clen)
+			return -1;
+		if (round_trip(page, dst, clen - 1, out, wrkmem) != -1)
+			return -1;
+		break;
+	}
+
+	return 0;
+}
+
+int self_test_lz4(void)
+{
+	static const enum page_kind kinds[] = {
+		PAGE_ZERO, PAGE_RANDOM, PAGE_REPEAT,
+	};
+	uint16_t *wrkmem = NULL;
+	uint8_t *page = NULL;
+	uint8_t *dst = NULL;
+	uint8_t *out = NULL;
+	int ret = -1;
+	size_t n = 0;
+
+	wrkmem = malloc(LZ4_COMPRESS_WRKMEM_SIZE);
+	page = malloc(SMALL_PAGE_SIZE);
+	dst = malloc(LZ4_PAGE_BOUND);
+	out = malloc(SMALL_PAGE_SIZE);
+	if (!wrkmem || !page || !dst || !out)
+		goto out;
+
+	for (n = 0; n < ARRAY_SIZE(kinds); n++) {
+		if (test_page(kinds[n], page, dst, out, wrkmem)) {
+			EMSG("LZ4 round trip of page %d failed", kinds[n]);
+			goto out;
+		}
+	}
+	ret = 0;
+out:
+	free(wrkmem);
+	free(page);
+	free(dst);
+	free(out);
+
+	return ret;
+}
@@ -13,9 +13,21 @@
 TEE_Result core_self_tests(uint32_t nParamTypes,
 			   TEE_Param pParams[TEE_NUM_PARAMS]);
 
+#ifdef CFG_LZ4
+int self_test_lz4(void);
+#else
+static inline int self_test_lz4(void)
+{
+	return 0;
+}
+#endif
+
 TEE_Result core_fs_htree_tests(uint32_t nParamTypes,
 			       TEE_Param pParams[TEE_NUM_PARAMS]);
 
+TEE_Result core_fs_trans_tests(uint32_t param_types,
+			       TEE_Param params[TEE_NUM_PARAMS]);
+
 TEE_Result core_mutex_tests(uint32_t nParamTypes,
 			    TEE_Param pParams[TEE_NUM_PARAMS]);
 
@@ -37,4 +49,43 @@ TEE_Result core_aes_perf_tests(uint32_t param_types,
 TEE_Result core_dt_driver_tests(uint32_t param_types,
 				TEE_Param params[TEE_NUM_PARAMS]);
 
+#ifdef CFG_GP_SOCKETS
+TEE_Result core_socket_batch_tests(uint32_t param_types,
+				   TEE_Param params[TEE_NUM_PARAMS]);
+#else
+static inline TEE_Result core_socket_batch_tests(
+		uint32_t param_types __unused,
+		TEE_Param params[TEE_NUM_PARAMS] __unused)
+{
+	return TEE_ERROR_NOT_SUPPORTED;
+}
+#endif
+
+#ifdef CFG_EARLY_TA
+TEE_Result core_emb_ts_perf_tests(uint32_t param_types,
+				  TEE_Param params[TEE_NUM_PARAMS]);
+#else
+static inline TEE_Result core_emb_ts_perf_tests(
+		uint32_t param_types __unused,
+		TEE_Param params[TEE_NUM_PARAMS] __unused)
+{
+	return TEE_ERROR_NOT_SUPPORTED;
+}
+#endif
+
+TEE_Result core_tlb_perf_tests(uint32_t param_types,
+			       TEE_Param params[TEE_NUM_PARAMS]);
+
+#ifdef CFG_CRYPTO_DRV_JOB_SW
+TEE_Result core_drvcrypt_job_tests(uint32_t param_types,
+				   TEE_Param params[TEE_NUM_PARAMS]);
+#else
+static inline TEE_Result core_drvcrypt_job_tests(
+		uint32_t param_types __unused,
+		TEE_Param params[TEE_NUM_PARAMS] __unused)
+{
+	return TEE_ERROR_NOT_SUPPORTED;
+}
+#endif
+
 #endif /*CORE_PTA_TESTS_MISC_H*/
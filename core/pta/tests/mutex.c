@@ -5,8 +5,11 @@
 
 #include <atomic.h>
 #include <kernel/mutex.h>
+#include <kernel/percpu_rwlock.h>
+#include <kernel/tee_time.h>
 #include <pta_invoke_tests.h>
 #include <trace.h>
+#include <util.h>
 
 #include "misc.h"
 
@@ -68,6 +71,98 @@ static TEE_Result mutex_test_reader(TEE_Param params[TEE_NUM_PARAMS])
 	return res;
 }
 
+/*
+ * Takes the mutex @params[0].value.b times for a short critical section.
+ * Invoked from several normal world threads at the same time it measures
+ * the cost of the mutex under contention.
+ */
+static TEE_Result mutex_test_contended(TEE_Param params[TEE_NUM_PARAMS])
+{
+	TEE_Time start = { };
+	TEE_Time end = { };
+	uint32_t max_waiters = 0;
+	uint32_t waiters = 0;
+	size_t n = 0;
+
+	tee_time_get_sys_time(&start);
+	for (n = 0; n < params[0].value.b; n++) {
+		waiters = atomic_inc32(&before_lock_writers);
+		mutex_lock(&test_mutex);
+		atomic_dec32(&before_lock_writers);
+		max_waiters = MAX(max_waiters, waiters);
+
+		val0++;
+		val1 += 2;
+
+		mutex_unlock(&test_mutex);
+	}
+	tee_time_get_sys_time(&end);
+
+	params[1].value.a = (end.seconds - start.seconds) * 1000 +
+			    end.millis - start.millis;
+	params[1].value.b = max_waiters;
+
+	return TEE_SUCCESS;
+}
+
+/* Registry of PTA_MUTEX_TEST_READ_MOSTLY, read only once initialized */
+static uint32_t test_registry[16] = {
+	0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88,
+	0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff, 0x100,
+};
+static struct percpu_rwlock test_rwlock = PERCPU_RWLOCK_INITIALIZER;
+
+static bool test_registry_find(uint32_t id)
+{
+	size_t n = 0;
+
+	for (n = 0; n < ARRAY_SIZE(test_registry); n++)
+		if (test_registry[n] == id)
+			return true;
+
+	return false;
+}
+
+static uint32_t elapsed_ms(TEE_Time *start)
+{
+	TEE_Time end = { };
+
+	tee_time_get_sys_time(&end);
+
+	return (end.seconds - start->seconds) * 1000 + end.millis -
+	       start->millis;
+}
+
+static TEE_Result mutex_test_read_mostly(TEE_Param params[TEE_NUM_PARAMS])
+{
+	TEE_Result res = TEE_SUCCESS;
+	TEE_Time start = { };
+	uint32_t id = 0;
+	size_t n = 0;
+
+	tee_time_get_sys_time(&start);
+	for (n = 0; n < params[0].value.b; n++) {
+		id = test_registry[n % ARRAY_SIZE(test_registry)];
+		percpu_rwlock_read_lock(&test_rwlock);
+		if (!test_registry_find(id))
+			res = TEE_ERROR_ITEM_NOT_FOUND;
+		percpu_rwlock_read_unlock(&test_rwlock);
+	}
+	params[1].value.a = elapsed_ms(&start);
+
+	tee_time_get_sys_time(&start);
+	for (n = 0; n < params[0].value.b; n++) {
+		id = test_registry[n % ARRAY_SIZE(test_registry)];
+		mutex_read_lock(&test_mutex);
+		if (!test_registry_find(id))
+			res = TEE_ERROR_ITEM_NOT_FOUND;
+		mutex_read_unlock(&test_mutex);
+	}
+	params[1].value.b = elapsed_ms(&start);
+
+	return res;
+}
+
 TEE_Result core_mutex_tests(uint32_t param_types,
 			    TEE_Param params[TEE_NUM_PARAMS])
 {
@@ -86,6 +181,10 @@ TEE_Result core_mutex_tests(uint32_t param_types,
 		return mutex_test_writer(params);
 	case PTA_MUTEX_TEST_READER:
 		return mutex_test_reader(params);
+	case PTA_MUTEX_TEST_CONTENDED:
+		return mutex_test_contended(params);
+	case PTA_MUTEX_TEST_READ_MOSTLY:
+		return mutex_test_read_mostly(params);
 	default:
 		return TEE_ERROR_BAD_PARAMETERS;
 	}
@@ -0,0 +1,202 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#include <kernel/tee_time.h>
+#include <optee_rpc_cmd.h>
+#include <pta_invoke_tests.h>
+#include <pta_socket.h>
+#include <stdlib.h>
+#include <string.h>
+#include <tee/socket_batch.h>
+#include <trace.h>
+#include <util.h>
+
+#include "misc.h"
+
+#define TEST_TOTAL_SIZE		(1024 * 1024)
+#define TEST_CHUNK_SIZE		1024
+#define TEST_MAX_OPS		16
+#define TEST_OP_SIZE		(sizeof(struct pta_socket_batch_op) + \
+				 TEST_CHUNK_SIZE)
+
+/*
+ * Loopback stand-in for tee-supplicant: the data sent on any socket is
+ * queued and returned by the following receive operations.
+ */
+static uint8_t fifo[TEST_MAX_OPS * TEST_CHUNK_SIZE];
+static size_t fifo_len;
+static size_t num_xfers;
+
+static TEE_Result loopback_xfer(uint32_t instance_id __unused,
+				uint32_t timeout __unused, uint32_t num_ops,
+				struct mobj *mobj __unused, void *va,
+				size_t size)
+{
+	struct pta_socket_batch_op op = { };
+	uint8_t *buf = va;
+	size_t pos = 0;
+	size_t n = 0;
+
+	num_xfers++;
+
+	for (; num_ops; num_ops--, pos += sizeof(op) + ROUNDUP(op.len, 8)) {
+		if (size - pos < sizeof(op))
+			return TEE_ERROR_BAD_PARAMETERS;
+		memcpy(&op, buf + pos, sizeof(op));
+
+		if (op.cmd == OPTEE_RPC_SOCKET_SEND) {
+			n = MIN(op.len, sizeof(fifo) - fifo_len);
+			memcpy(fifo + fifo_len, buf + pos + sizeof(op), n);
+			fifo_len += n;
+		} else {
+			n = MIN(op.len, fifo_len);
+			memcpy(buf + pos + sizeof(op), fifo, n);
+			memmove(fifo, fifo + n, fifo_len - n);
+			fifo_len -= n;
+		}
+
+		/* Report the result, the payload keeps its original size */
+		op.res = TEE_SUCCESS;
+		memcpy(buf + pos + offsetof(struct pta_socket_batch_op, res),
+		       &op.res, sizeof(op.res));
+		memcpy(buf + pos + offsetof(struct pta_socket_batch_op, len),
+		       &n, sizeof(op.len));
+	}
+
+	return TEE_SUCCESS;
+}
+
+static void add_op(uint8_t *ops, size_t idx, uint32_t cmd, uint32_t seq)
+{
+	struct pta_socket_batch_op op = {
+		.cmd = cmd,
+		.len = TEST_CHUNK_SIZE,
+	};
+	uint8_t *p = ops + idx * TEST_OP_SIZE;
+
+	memcpy(p, &op, sizeof(op));
+	if (cmd == PTA_SOCKET_SEND)
+		memset(p + sizeof(op), seq, TEST_CHUNK_SIZE);
+	else
+		memset(p + sizeof(op), 0, TEST_CHUNK_SIZE);
+}
+
+static TEE_Result check_recv(uint8_t *ops, size_t idx, uint32_t seq)
+{
+	struct pta_socket_batch_op op = { };
+	uint8_t *p = ops + idx * TEST_OP_SIZE;
+	size_t n = 0;
+
+	memcpy(&op, p, sizeof(op));
+	if (op.res || op.len != TEST_CHUNK_SIZE)
+		return TEE_ERROR_GENERIC;
+	for (n = 0; n < TEST_CHUNK_SIZE; n++)
+		if (p[sizeof(op) + n] != (uint8_t)seq)
+			return TEE_ERROR_GENERIC;
+
+	return TEE_SUCCESS;
+}
+
+/*
+ * Streams TEST_TOTAL_SIZE bytes through the loopback, @num_ops / 2
+ * chunks sent then received per batch. Returns the number of transfers
+ * and the elapsed time in milliseconds.
+ */
+static TEE_Result run_loopback(size_t num_ops, uint8_t *ops, uint8_t *shm,
+			       size_t *xfers, uint32_t *ms)
+{
+	size_t pairs = num_ops / 2;
+	TEE_Result res = TEE_SUCCESS;
+	TEE_Time start = { };
+	TEE_Time end = { };
+	uint32_t seq = 0;
+	size_t done = 0;
+	size_t n = 0;
+
+	fifo_len = 0;
+	num_xfers = 0;
+	tee_time_get_sys_time(&start);
+
+	for (done = 0; done < TEST_TOTAL_SIZE;
+	     done += pairs * TEST_CHUNK_SIZE) {
+		for (n = 0; n < pairs; n++) {
+			add_op(ops, n, PTA_SOCKET_SEND, seq + n);
+			add_op(ops, pairs + n, PTA_SOCKET_RECV, 0);
+		}
+
+		res = socket_batch_run(0, OPTEE_RPC_SOCKET_TIMEOUT_NONBLOCKING,
+				       ops, num_ops * TEST_OP_SIZE, NULL, shm,
+				       loopback_xfer);
+		if (res)
+			return res;
+
+		for (n = 0; n < pairs; n++) {
+			res = check_recv(ops, pairs + n, seq + n);
+			if (res) {
+				EMSG("Bad data received, chunk %"PRIu32,
+				     seq + (uint32_t)n);
+				return res;
+			}
+		}
+		seq += pairs;
+	}
+
+	tee_time_get_sys_time(&end);
+	*xfers = num_xfers;
+	*ms = (end.seconds - start.seconds) * 1000 + end.millis - start.millis;
+
+	return TEE_SUCCESS;
+}
+
+/*
+ * [out]    value[0].a	Transfers per MiB with one operation per transfer
+ * [out]    value[0].b	Transfers per MiB with batched operations
+ * [out]    value[1].a	Throughput of the batched run in KiB/s, 0 if too
+ *			fast to be measured
+ */
+TEE_Result core_socket_batch_tests(uint32_t param_types,
+				   TEE_Param params[TEE_NUM_PARAMS])
+{
+	uint32_t exp_pt = TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_OUTPUT,
+					  TEE_PARAM_TYPE_VALUE_OUTPUT,
+					  TEE_PARAM_TYPE_NONE,
+					  TEE_PARAM_TYPE_NONE);
+	size_t size = TEST_MAX_OPS * TEST_OP_SIZE;
+	TEE_Result res = TEE_ERROR_OUT_OF_MEMORY;
+	size_t single_xfers = 0;
+	size_t batch_xfers = 0;
+	uint8_t *ops = NULL;
+	uint8_t *shm = NULL;
+	uint32_t ms = 0;
+
+	if (param_types != exp_pt)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	ops = malloc(size);
+	shm = malloc(size);
+	if (!ops || !shm)
+		goto out;
+
+	/* One send and one receive per transfer, as without batching */
+	res = run_loopback(2, ops, shm, &single_xfers, &ms);
+	if (res)
+		goto out;
+	res = run_loopback(TEST_MAX_OPS, ops, shm, &batch_xfers, &ms);
+	if (res)
+		goto out;
+
+	params[0].value.a = single_xfers * 1024 * 1024 / TEST_TOTAL_SIZE;
+	params[0].value.b = batch_xfers * 1024 * 1024 / TEST_TOTAL_SIZE;
+	params[1].value.a = 0;
+	if (ms)
+		params[1].value.a = TEST_TOTAL_SIZE / 1024 * 1000 / ms;
+
+	IMSG("socket batch loopback: %"PRIu32" -> %"PRIu32" RPCs/MiB, %"PRIu32" KiB/s",
+	     params[0].value.a, params[0].value.b, params[1].value.a);
+out:
+	free(ops);
+	free(shm);
+	return res;
+}
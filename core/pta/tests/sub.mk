@@ -1,7 +1,13 @@
 srcs-$(call cfg-all-enabled,CFG_REE_FS CFG_WITH_USER_TA) += fs_htree.c
+srcs-$(call cfg-all-enabled,CFG_REE_FS CFG_WITH_USER_TA) += fs_trans.c
 srcs-y += invoke.c
 srcs-$(CFG_LOCKDEP) += lockdep.c
+srcs-$(CFG_LZ4) += lz4.c
 srcs-y += misc.c
 cflags-misc.c-y += -fno-builtin
 srcs-y += mutex.c
 srcs-y += aes_perf.c
+srcs-$(CFG_GP_SOCKETS) += socket_batch.c
+srcs-$(CFG_EARLY_TA) += emb_ts_perf.c
+srcs-y += tlb_perf.c
+srcs-$(CFG_CRYPTO_DRV_JOB_SW) += drvcrypt_job.c
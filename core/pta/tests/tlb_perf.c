@@ -0,0 +1,99 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#include <kernel/tee_time.h>
+#include <kernel/ts_manager.h>
+#include <kernel/user_mode_ctx.h>
+#include <mm/core_mmu.h>
+#include <mm/vm.h>
+#include <pta_invoke_tests.h>
+#include <string.h>
+#include <trace.h>
+#include <util.h>
+
+#include "misc.h"
+
+/*
+ * Reads one word per small page of @buf, visiting the pages with a large
+ * stride so that nearly every access needs another TLB entry unless the
+ * pages are covered by a block or a contiguous hint mapping.
+ */
+static uint32_t touch_pages(const uint8_t *buf, size_t num_pages)
+{
+	const size_t stride = 17;
+	uint32_t sum = 0;
+	size_t n = 0;
+	size_t i = 0;
+
+	for (n = 0; n < num_pages; n++) {
+		sum += *(volatile const uint32_t *)(buf + i * SMALL_PAGE_SIZE);
+		i = (i + stride) % num_pages;
+	}
+
+	return sum;
+}
+
+/*
+ * The buffer is read through the mapping of the calling TA, which is
+ * still active while the PTA runs. A memref parameter wouldn't do, it's
+ * read through a core mapping which never has the contiguous hint.
+ *
+ * [in]     value[0].a	Low 32 bits of the address of the buffer
+ * [in]     value[0].b	High 32 bits of the address of the buffer
+ * [in]     value[1].a	Size of the buffer, at least one small page
+ * [in]     value[1].b	Number of passes over the buffer
+ * [out]    value[2].a	Elapsed time in ms
+ * [out]    value[2].b	Number of pages read per pass
+ */
+TEE_Result core_tlb_perf_tests(uint32_t param_types,
+			       TEE_Param params[TEE_NUM_PARAMS])
+{
+	uint32_t exp_pt = TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+					  TEE_PARAM_TYPE_VALUE_INPUT,
+					  TEE_PARAM_TYPE_VALUE_OUTPUT,
+					  TEE_PARAM_TYPE_NONE);
+	uint32_t flags = TEE_MEMORY_ACCESS_READ | TEE_MEMORY_ACCESS_ANY_OWNER;
+	struct ts_session *s = ts_get_calling_session();
+	TEE_Result res = TEE_SUCCESS;
+	size_t num_pages = 0;
+	uint32_t passes = 0;
+	TEE_Time start = { };
+	TEE_Time end = { };
+	uint32_t sum = 0;
+	vaddr_t va = 0;
+	uint32_t n = 0;
+
+	if (param_types != exp_pt)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	/* Only a user TA has a mapping which may use the contiguous hint */
+	if (!s || !is_user_ta_ctx(s->ctx))
+		return TEE_ERROR_ACCESS_DENIED;
+
+	va = reg_pair_to_64(params[0].value.b, params[0].value.a);
+	num_pages = params[1].value.a / SMALL_PAGE_SIZE;
+	passes = params[1].value.b;
+	if (!num_pages || !passes)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	res = vm_check_access_rights(to_user_mode_ctx(s->ctx), flags, va,
+				     num_pages * SMALL_PAGE_SIZE);
+	if (res)
+		return res;
+
+	tee_time_get_sys_time(&start);
+	for (n = 0; n < passes; n++)
+		sum += touch_pages((const uint8_t *)va, num_pages);
+	tee_time_get_sys_time(&end);
+
+	params[2].value.a = (end.seconds - start.seconds) * 1000 +
+			    end.millis - start.millis;
+	params[2].value.b = num_pages;
+
+	DMSG("%zu pages, %"PRIu32" passes: %"PRIu32" ms (sum %#"PRIx32")",
+	     num_pages, passes, params[2].value.a, sum);
+
+	return TEE_SUCCESS;
+}
@@ -20,9 +20,13 @@ recipe-ldelf = $(PYTHON3) scripts/gen_ldelf_hex.py --input $(out-dir)/ldelf/ldel
 			--output $(sub-dir-out)/ldelf_hex.c
 endif
 
+ifeq ($(CFG_EMBEDDED_TS_COMPRESS_LZ4),y)
+ts-compress-algo = --compress-algo lz4
+endif
+
 ifeq ($(CFG_WITH_USER_TA)-$(CFG_EARLY_TA),y-y)
 ifeq ($(CFG_EARLY_TA_COMPRESS),y)
-early-ta-compress = --compress
+early-ta-compress = --compress $(ts-compress-algo)
 endif
 define process_early_ta
 early-ta-$1-uuid := $(firstword $(subst ., ,$(notdir $1)))
@@ -44,7 +48,8 @@ produce-sp-$1 = sp_$$(sp-$1-uuid).c
 depends-sp-$1 = $1 scripts/ts_bin_to_c.py
 dtb-$1-path = $(dir $1)
 dtb-$1 = $$(dtb-$1-path)../manifest/$$(sp-$1-uuid).dtb
-recipe-sp-$1 = $(PYTHON3) scripts/ts_bin_to_c.py --compress --sp $1 \
+recipe-sp-$1 = $(PYTHON3) scripts/ts_bin_to_c.py --compress \
+		$(ts-compress-algo) --sp $1 \
 		--out $(sub-dir-out)/sp_$$(sp-$1-uuid).c \
 		--manifest $$(dtb-$1)
 endef
@@ -359,14 +359,17 @@ static void entry_open_session(struct optee_msg_arg *arg, uint32_t num_params)
 	struct tee_ta_param param;
 	size_t num_meta;
 	uint64_t saved_attr[TEE_NUM_PARAMS] = { 0 };
+	uint64_t bm_begin = 0;
 
 	res = get_open_session_meta(num_params, arg->params, &num_meta, &uuid,
 				    &clnt_id);
 	if (res != TEE_SUCCESS)
 		goto out;
 
+	bm_begin = bm_tp_begin();
 	res = copy_in_params(arg->params + num_meta, num_params - num_meta,
 			     &param, saved_attr);
+	bm_tp_end_session(BENCHMARK_TP_PARAM_MAP, bm_begin, 0);
 	if (res != TEE_SUCCESS)
 		goto cleanup_shm_refs;
 
@@ -424,10 +427,13 @@ static void entry_invoke_command(struct optee_msg_arg *arg, uint32_t num_params)
 	struct tee_ta_session *s;
 	struct tee_ta_param param = { 0 };
 	uint64_t saved_attr[TEE_NUM_PARAMS] = { 0 };
+	uint64_t bm_begin = 0;
 
 	bm_timestamp();
 
+	bm_begin = bm_tp_begin();
 	res = copy_in_params(arg->params, num_params, &param, saved_attr);
+	bm_tp_end_session(BENCHMARK_TP_PARAM_MAP, bm_begin, arg->session);
 	if (res != TEE_SUCCESS)
 		goto out;
 
@@ -537,6 +543,7 @@ TEE_Result __weak tee_entry_std(struct optee_msg_arg *arg, uint32_t num_params)
  */
 TEE_Result __tee_entry_std(struct optee_msg_arg *arg, uint32_t num_params)
 {
+	uint64_t bm_begin = bm_tp_begin();
 	TEE_Result res = TEE_SUCCESS;
 
 	/* Enable foreign interrupts for STD calls */
@@ -584,6 +591,8 @@ err:
 		res = TEE_ERROR_NOT_IMPLEMENTED;
 	}
 
+	bm_tp_end_session(BENCHMARK_TP_STD_ENTRY, bm_begin, arg->session);
+
 	return res;
 }
 
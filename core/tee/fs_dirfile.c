@@ -346,6 +346,18 @@ TEE_Result tee_fs_dirfile_remove(struct tee_fs_dirfile_dirh *dirh,
 	return res;
 }
 
+TEE_Result tee_fs_dirfile_hold_file_number(struct tee_fs_dirfile_dirh *dirh,
+					   uint32_t file_number)
+{
+	return set_file(dirh, file_number);
+}
+
+void tee_fs_dirfile_release_file_number(struct tee_fs_dirfile_dirh *dirh,
+					uint32_t file_number)
+{
+	clear_file(dirh, file_number);
+}
+
 TEE_Result tee_fs_dirfile_update_hash(struct tee_fs_dirfile_dirh *dirh,
 				      const struct tee_fs_dirfile_fileh *dfh)
 {
@@ -363,6 +375,29 @@ TEE_Result tee_fs_dirfile_update_hash(struct tee_fs_dirfile_dirh *dirh,
 	return write_dent(dirh, dfh->idx, &dent);
 }
 
+TEE_Result tee_fs_dirfile_get_fileh(struct tee_fs_dirfile_dirh *dirh,
+				   const TEE_UUID *uuid, int idx,
+				   struct tee_fs_dirfile_fileh *dfh)
+{
+	TEE_Result res;
+	struct dirfile_entry dent;
+
+	if (idx < 0)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	res = read_dent(dirh, idx, &dent);
+	if (res)
+		return res;
+	if (is_free(&dent) || memcmp(&dent.uuid, uuid, sizeof(dent.uuid)))
+		return TEE_ERROR_ITEM_NOT_FOUND;
+
+	dfh->idx = idx;
+	dfh->file_number = dent.file_number;
+	memcpy(dfh->hash, dent.hash, sizeof(dent.hash));
+
+	return TEE_SUCCESS;
+}
+
 TEE_Result tee_fs_dirfile_get_next(struct tee_fs_dirfile_dirh *dirh,
 				   const TEE_UUID *uuid, int *idx, void *oid,
 				   size_t *oidlen)
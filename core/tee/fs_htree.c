@@ -70,6 +70,14 @@
  *
  * Where different elements are stored in the file is managed by the file
  * system.
+ *
+ * The hash of a node covers the hashes of its children. When a file is
+ * opened only the root node is verified, other nodes are verified when a
+ * block below them is accessed, from the top of their root path down to
+ * the first node already verified.
+ *
+ * A node that is dirty always has dirty ancestors, so a sync only visits
+ * the subtrees that were updated and hashes each updated node once.
  */
 
 #define HTREE_NODE_COMMITTED_BLOCK	BIT32(0)
@@ -80,6 +88,7 @@ struct htree_node {
 	size_t id;
 	bool dirty;
 	bool block_updated;
+	bool verified;
 	struct tee_fs_htree_node_image node;
 	struct htree_node *parent;
 	struct htree_node *child[2];
@@ -251,9 +260,13 @@ static struct htree_node *find_node(struct tee_fs_htree *ht, size_t node_id)
 	return NULL;
 }
 
+static TEE_Result verify_node_path(struct tee_fs_htree *ht,
+				   struct htree_node *node);
+
 static TEE_Result get_node(struct tee_fs_htree *ht, bool create,
 			   size_t node_id, struct htree_node **node_ret)
 {
+	TEE_Result res;
 	struct htree_node *node;
 	struct htree_node *nc;
 	size_t n;
@@ -283,10 +296,16 @@ static TEE_Result get_node(struct tee_fs_htree *ht, bool create,
 		assert((n >> 1) == node->id);
 		assert(!node->child[n & 1]);
 
+		/* Don't build on a node that hasn't been verified */
+		res = verify_node_path(ht, node);
+		if (res != TEE_SUCCESS)
+			return res;
+
 		nc = calloc(1, sizeof(*nc));
 		if (!nc)
 			return TEE_ERROR_OUT_OF_MEMORY;
 		nc->id = n;
+		nc->verified = true;
 		nc->parent = node;
 		node->child[n & 1] = nc;
 		node = nc;
@@ -386,10 +405,14 @@ static TEE_Result init_tree_from_data(struct tee_fs_htree *ht)
 		if (res != TEE_SUCCESS)
 			return res;
 
-		res = get_node(ht, true, node_id, &nc);
-		if (res != TEE_SUCCESS)
-			return res;
+		/* Nodes are loaded in order, the parent is already there */
+		nc = calloc(1, sizeof(*nc));
+		if (!nc)
+			return TEE_ERROR_OUT_OF_MEMORY;
+		nc->id = node_id;
+		nc->parent = node;
 		nc->node = node_image;
+		node->child[node_id & 1] = nc;
 		node_id++;
 	}
 
@@ -559,34 +582,63 @@ static TEE_Result verify_root(struct tee_fs_htree *ht)
 				     sizeof(ht->imeta), &ht->imeta);
 }
 
-static TEE_Result verify_node(struct traverse_arg *targ,
+static TEE_Result verify_node(struct tee_fs_htree *ht, void *ctx,
 			      struct htree_node *node)
 {
-	void *ctx = targ->arg;
 	TEE_Result res;
 	uint8_t digest[TEE_FS_HTREE_HASH_SIZE];
 
 	if (node->parent)
 		res = calc_node_hash(node, NULL, ctx, digest);
 	else
-		res = calc_node_hash(node, &targ->ht->imeta.meta, ctx, digest);
+		res = calc_node_hash(node, &ht->imeta.meta, ctx, digest);
 	if (res == TEE_SUCCESS &&
 	    consttime_memcmp(digest, node->node.hash, sizeof(digest)))
 		return TEE_ERROR_CORRUPT_OBJECT;
 
+	if (res == TEE_SUCCESS)
+		node->verified = true;
+
 	return res;
 }
 
-static TEE_Result verify_tree(struct tee_fs_htree *ht)
+static TEE_Result verify_path(struct tee_fs_htree *ht, void *ctx,
+			      struct htree_node *node)
+{
+	TEE_Result res;
+
+	/*
+	 * This function is recursing but not very deep, only with Log(N)
+	 * maximum depth.
+	 */
+
+	if (node->verified)
+		return TEE_SUCCESS;
+
+	/* The hash of the node is only trusted once the parent is */
+	if (node->parent) {
+		res = verify_path(ht, ctx, node->parent);
+		if (res != TEE_SUCCESS)
+			return res;
+	}
+
+	return verify_node(ht, ctx, node);
+}
+
+static TEE_Result verify_node_path(struct tee_fs_htree *ht,
+				   struct htree_node *node)
 {
 	TEE_Result res;
 	void *ctx;
 
+	if (node->verified)
+		return TEE_SUCCESS;
+
 	res = crypto_hash_alloc_ctx(&ctx, TEE_FS_HTREE_HASH_ALG);
 	if (res != TEE_SUCCESS)
 		return res;
 
-	res = htree_traverse_post_order(ht, verify_node, ctx);
+	res = verify_path(ht, ctx, node);
 	crypto_hash_free_ctx(ctx);
 
 	return res;
@@ -603,6 +655,7 @@ static TEE_Result init_root_node(struct tee_fs_htree *ht)
 
 	ht->root.id = 1;
 	ht->root.dirty = true;
+	ht->root.verified = true;
 
 	res = calc_node_hash(&ht->root, &ht->imeta.meta, ctx,
 			     ht->root.node.hash);
@@ -659,7 +712,7 @@ TEE_Result tee_fs_htree_open(bool create, uint8_t *hash, const TEE_UUID *uuid,
 		if (res != TEE_SUCCESS)
 			goto out;
 
-		res = verify_tree(ht);
+		res = verify_node_path(ht, &ht->root);
 	}
 out:
 	if (res == TEE_SUCCESS)
@@ -674,10 +727,19 @@ struct tee_fs_htree_meta *tee_fs_htree_get_meta(struct tee_fs_htree *ht)
 	return &ht->imeta.meta;
 }
 
+static void mark_node_dirty(struct htree_node *node)
+{
+	/* Ancestors of a dirty node are already dirty */
+	while (node && !node->dirty) {
+		node->dirty = true;
+		node = node->parent;
+	}
+}
+
 void tee_fs_htree_meta_set_dirty(struct tee_fs_htree *ht)
 {
 	ht->dirty = true;
-	ht->root.dirty = true;
+	mark_node_dirty(&ht->root);
 }
 
 static TEE_Result free_node(struct traverse_arg *targ __unused,
@@ -739,6 +801,29 @@ static TEE_Result htree_sync_node_to_storage(struct traverse_arg *targ,
 	return rpc_write_node(targ->ht, node->id, vers, &node->node);
 }
 
+static TEE_Result htree_sync_subtree(struct traverse_arg *targ,
+				     struct htree_node *node)
+{
+	TEE_Result res;
+
+	/*
+	 * A clean node has no dirty descendants, see mark_node_dirty(),
+	 * so clean subtrees are skipped.
+	 */
+	if (!node || !node->dirty)
+		return TEE_SUCCESS;
+
+	res = htree_sync_subtree(targ, node->child[0]);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	res = htree_sync_subtree(targ, node->child[1]);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	return htree_sync_node_to_storage(targ, node);
+}
+
 static TEE_Result update_root(struct tee_fs_htree *ht)
 {
 	TEE_Result res;
@@ -759,6 +844,7 @@ TEE_Result tee_fs_htree_sync_to_storage(struct tee_fs_htree **ht_arg,
 {
 	TEE_Result res;
 	struct tee_fs_htree *ht = *ht_arg;
+	struct traverse_arg targ;
 	void *ctx;
 
 	if (!ht)
@@ -771,7 +857,8 @@ TEE_Result tee_fs_htree_sync_to_storage(struct tee_fs_htree **ht_arg,
 	if (res != TEE_SUCCESS)
 		return res;
 
-	res = htree_traverse_post_order(ht, htree_sync_node_to_storage, ctx);
+	targ = (struct traverse_arg){ ht, htree_sync_node_to_storage, ctx };
+	res = htree_sync_subtree(&targ, &ht->root);
 	if (res != TEE_SUCCESS)
 		goto out;
 
@@ -801,6 +888,10 @@ static TEE_Result get_block_node(struct tee_fs_htree *ht, bool create,
 	struct htree_node *nd;
 
 	res = get_node(ht, create, BLOCK_NUM_TO_NODE_ID(block_num), &nd);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	res = verify_node_path(ht, nd);
 	if (res == TEE_SUCCESS)
 		*node = nd;
 
@@ -849,7 +940,7 @@ TEE_Result tee_fs_htree_write_block(struct tee_fs_htree **ht_arg,
 		goto out;
 
 	node->block_updated = true;
-	node->dirty = true;
+	mark_node_dirty(node);
 	ht->dirty = true;
 out:
 	if (res != TEE_SUCCESS)
@@ -909,6 +1000,7 @@ TEE_Result tee_fs_htree_truncate(struct tee_fs_htree **ht_arg, size_t block_num)
 	struct tee_fs_htree *ht = *ht_arg;
 	size_t node_id = BLOCK_NUM_TO_NODE_ID(block_num);
 	struct htree_node *node;
+	TEE_Result res;
 
 	if (!ht)
 		return TEE_ERROR_CORRUPT_OBJECT;
@@ -919,6 +1011,18 @@ TEE_Result tee_fs_htree_truncate(struct tee_fs_htree **ht_arg, size_t block_num)
 		assert(!node->child[0] && !node->child[1]);
 		assert(node->parent);
 		assert(node->parent->child[node->id & 1] == node);
+
+		/*
+		 * The hash of the parent covers this node, verify it while
+		 * the node is there and have it rehashed without it.
+		 */
+		res = verify_node_path(ht, node->parent);
+		if (res != TEE_SUCCESS) {
+			tee_fs_htree_close(ht_arg);
+			return res;
+		}
+		mark_node_dirty(node->parent);
+
 		node->parent->child[node->id & 1] = NULL;
 		free(node);
 		ht->imeta.max_node_id--;
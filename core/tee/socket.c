@@ -3,14 +3,28 @@
  * Copyright (c) 2016-2017, Linaro Limited
  */
 
-#include <assert.h>
 #include <mm/mobj.h>
 #include <kernel/pseudo_ta.h>
 #include <optee_rpc_cmd.h>
 #include <pta_socket.h>
+#include <stdlib.h>
 #include <string.h>
+#include <tee/socket_batch.h>
 #include <tee/tee_fs_rpc.h>
 
+/*
+ * @instance_id	Instance id of the calling TA
+ * @batch_mobj	Buffer allocated with PTA_SOCKET_BATCH_BUF_ALLOC or NULL
+ * @batch_va	Virtual address of @batch_mobj
+ * @batch_size	Size of @batch_mobj
+ */
+struct socket_sess {
+	uint32_t instance_id;
+	struct mobj *batch_mobj;
+	void *batch_va;
+	size_t batch_size;
+};
+
 static uint32_t get_instance_id(struct ts_session *sess)
 {
 	return sess->ctx->ops->get_instance_id(sess->ctx);
@@ -198,6 +212,205 @@ static TEE_Result socket_ioctl(uint32_t instance_id, uint32_t param_types,
 	return res;
 }
 
+/*
+ * Reads the header of the operation at offset @pos of a batch and returns
+ * the size of the operation including its padded payload, 0 if it is
+ * malformed.
+ */
+static size_t batch_get_op(const uint8_t *ops, size_t size, size_t pos,
+			   struct pta_socket_batch_op *op)
+{
+	size_t sz = 0;
+
+	if (size - pos < sizeof(*op))
+		return 0;
+	memcpy(op, ops + pos, sizeof(*op));
+
+	if (op->cmd != PTA_SOCKET_SEND && op->cmd != PTA_SOCKET_RECV)
+		return 0;
+	if (ROUNDUP_OVERFLOW(op->len, 8, &sz) ||
+	    ADD_OVERFLOW(sz, sizeof(*op), &sz) || sz > size - pos)
+		return 0;
+
+	return sz;
+}
+
+TEE_Result socket_batch_run(uint32_t instance_id, uint32_t timeout,
+			    void *ops, size_t size, struct mobj *mobj,
+			    void *va, socket_batch_xfer_fn xfer)
+{
+	struct pta_socket_batch_op *hdrs = NULL;
+	struct pta_socket_batch_op rop = { };
+	struct pta_socket_batch_op *op = NULL;
+	uint8_t *shm = va;
+	uint8_t *buf = ops;
+	TEE_Result res = TEE_SUCCESS;
+	uint32_t num_ops = 0;
+	size_t pos = 0;
+	size_t sz = 0;
+	size_t n = 0;
+
+	/*
+	 * @ops may be shared with normal world, the headers are read once
+	 * into a private copy which is all the second pass relies on.
+	 */
+	if (size < sizeof(*hdrs))
+		return TEE_ERROR_BAD_PARAMETERS;
+	hdrs = calloc(size / sizeof(*hdrs), sizeof(*hdrs));
+	if (!hdrs)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	/* Validate the batch and serialize it in shared memory */
+	for (pos = 0; pos < size; pos += sz) {
+		op = hdrs + num_ops;
+		sz = batch_get_op(buf, size, pos, op);
+		if (!sz) {
+			res = TEE_ERROR_BAD_PARAMETERS;
+			goto out;
+		}
+
+		rop = *op;
+		rop.res = TEE_ERROR_GENERIC;
+		if (op->cmd == PTA_SOCKET_SEND) {
+			rop.cmd = OPTEE_RPC_SOCKET_SEND;
+			memcpy(shm + pos + sizeof(*op), buf + pos + sizeof(*op),
+			       op->len);
+		} else {
+			rop.cmd = OPTEE_RPC_SOCKET_RECV;
+		}
+		memcpy(shm + pos, &rop, sizeof(rop));
+		num_ops++;
+	}
+	if (!num_ops) {
+		res = TEE_ERROR_BAD_PARAMETERS;
+		goto out;
+	}
+
+	res = xfer(instance_id, timeout, num_ops, mobj, va, size);
+	if (res)
+		goto out;
+
+	/*
+	 * Copy back the results, the headers in shared memory are only
+	 * trusted for the result and a length bounded by the request.
+	 */
+	for (pos = 0, n = 0; n < num_ops; pos += sz, n++) {
+		op = hdrs + n;
+		sz = ROUNDUP(op->len, 8) + sizeof(*op);
+		memcpy(&rop, shm + pos, sizeof(rop));
+
+		op->res = rop.res;
+		op->len = MIN(op->len, rop.len);
+		if (op->cmd == PTA_SOCKET_RECV)
+			memcpy(buf + pos + sizeof(*op),
+			       shm + pos + sizeof(*op), op->len);
+		/* The length of the operation is not updated in place */
+		memcpy(buf + pos + offsetof(struct pta_socket_batch_op, len),
+		       &op->len, sizeof(op->len));
+		memcpy(buf + pos + offsetof(struct pta_socket_batch_op, res),
+		       &op->res, sizeof(op->res));
+	}
+out:
+	free(hdrs);
+
+	return res;
+}
+
+static TEE_Result batch_rpc_xfer(uint32_t instance_id, uint32_t timeout,
+				 uint32_t num_ops, struct mobj *mobj,
+				 void *va __unused, size_t size)
+{
+	struct thread_param tpm[3] = {
+		[0] = THREAD_PARAM_VALUE(IN, OPTEE_RPC_SOCKET_BATCH,
+					 instance_id, 0),
+		[1] = THREAD_PARAM_MEMREF(INOUT, mobj, 0, size),
+		[2] = THREAD_PARAM_VALUE(IN, timeout, num_ops, 0),
+	};
+
+	return thread_rpc_cmd(OPTEE_RPC_CMD_SOCKET, 3, tpm);
+}
+
+static TEE_Result socket_batch(struct socket_sess *sess, uint32_t param_types,
+			       TEE_Param params[TEE_NUM_PARAMS])
+{
+	struct mobj *mobj = sess->batch_mobj;
+	size_t size = params[1].memref.size;
+	void *va = sess->batch_va;
+	uint32_t exp_pt = TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+					  TEE_PARAM_TYPE_MEMREF_INOUT,
+					  TEE_PARAM_TYPE_NONE,
+					  TEE_PARAM_TYPE_NONE);
+
+	if (exp_pt != param_types) {
+		DMSG("got param_types 0x%x, expected 0x%x",
+		     param_types, exp_pt);
+		return TEE_ERROR_BAD_PARAMETERS;
+	}
+
+	if (!size)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (size > sess->batch_size) {
+		va = thread_rpc_shm_cache_alloc(THREAD_SHM_CACHE_USER_SOCKET,
+						THREAD_SHM_TYPE_APPLICATION,
+						size, &mobj);
+		if (!va)
+			return TEE_ERROR_OUT_OF_MEMORY;
+	}
+
+	return socket_batch_run(sess->instance_id, params[0].value.b,
+				params[1].memref.buffer, size, mobj, va,
+				batch_rpc_xfer);
+}
+
+static void batch_buf_free(struct socket_sess *sess)
+{
+	if (sess->batch_mobj)
+		thread_rpc_free_payload(sess->batch_mobj);
+	sess->batch_mobj = NULL;
+	sess->batch_va = NULL;
+	sess->batch_size = 0;
+}
+
+static TEE_Result socket_batch_buf_alloc(struct socket_sess *sess,
+					 uint32_t param_types,
+					 TEE_Param params[TEE_NUM_PARAMS])
+{
+	size_t size = params[0].value.a;
+	struct mobj *mobj = NULL;
+	void *va = NULL;
+	uint32_t exp_pt = TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+					  TEE_PARAM_TYPE_NONE,
+					  TEE_PARAM_TYPE_NONE,
+					  TEE_PARAM_TYPE_NONE);
+
+	if (exp_pt != param_types) {
+		DMSG("got param_types 0x%x, expected 0x%x",
+		     param_types, exp_pt);
+		return TEE_ERROR_BAD_PARAMETERS;
+	}
+
+	batch_buf_free(sess);
+	if (!size)
+		return TEE_SUCCESS;
+
+	mobj = thread_rpc_alloc_payload(size);
+	if (!mobj)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	va = mobj_get_va(mobj, 0, size);
+	if (!va) {
+		thread_rpc_free_payload(mobj);
+		return TEE_ERROR_GENERIC;
+	}
+
+	sess->batch_mobj = mobj;
+	sess->batch_va = va;
+	sess->batch_size = size;
+
+	return TEE_SUCCESS;
+}
+
 typedef TEE_Result (*ta_func)(uint32_t instance_id, uint32_t param_types,
 			      TEE_Param params[TEE_NUM_PARAMS]);
 
@@ -218,35 +431,56 @@ static TEE_Result pta_socket_open_session(uint32_t param_types __unused,
 			void **sess_ctx)
 {
 	struct ts_session *s = ts_get_calling_session();
+	struct socket_sess *sess = NULL;
 
 	/* Check that we're called from a TA */
 	if (!s || !is_user_ta_ctx(s->ctx))
 		return TEE_ERROR_ACCESS_DENIED;
 
-	*sess_ctx = (void *)(vaddr_t)get_instance_id(s);
+	sess = calloc(1, sizeof(*sess));
+	if (!sess)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	sess->instance_id = get_instance_id(s);
+	*sess_ctx = sess;
 
 	return TEE_SUCCESS;
 }
 
 static void pta_socket_close_session(void *sess_ctx)
 {
+	struct socket_sess *sess = sess_ctx;
 	TEE_Result res;
 	struct thread_param tpm = {
 		.attr = THREAD_PARAM_ATTR_VALUE_IN, .u.value = {
-			.a = OPTEE_RPC_SOCKET_CLOSE_ALL, .b = (vaddr_t)sess_ctx,
+			.a = OPTEE_RPC_SOCKET_CLOSE_ALL, .b = sess->instance_id,
 		},
 	};
 
 	res = thread_rpc_cmd(OPTEE_RPC_CMD_SOCKET, 1, &tpm);
 	if (res != TEE_SUCCESS)
 		DMSG("OPTEE_RPC_SOCKET_CLOSE_ALL failed: %#" PRIx32, res);
+
+	batch_buf_free(sess);
+	free(sess);
 }
 
 static TEE_Result pta_socket_invoke_command(void *sess_ctx, uint32_t cmd_id,
 			uint32_t param_types, TEE_Param params[TEE_NUM_PARAMS])
 {
+	struct socket_sess *sess = sess_ctx;
+
+	switch (cmd_id) {
+	case PTA_SOCKET_BATCH:
+		return socket_batch(sess, param_types, params);
+	case PTA_SOCKET_BATCH_BUF_ALLOC:
+		return socket_batch_buf_alloc(sess, param_types, params);
+	default:
+		break;
+	}
+
 	if (cmd_id < ARRAY_SIZE(ta_funcs) && ta_funcs[cmd_id])
-		return ta_funcs[cmd_id]((vaddr_t)sess_ctx, param_types, params);
+		return ta_funcs[cmd_id](sess->instance_id, param_types, params);
 
 	return TEE_ERROR_NOT_IMPLEMENTED;
 }
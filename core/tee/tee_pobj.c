@@ -8,10 +8,62 @@
 #include <string.h>
 #include <tee/tee_pobj.h>
 #include <trace.h>
+#include <util.h>
 
-static TAILQ_HEAD(tee_pobjs, tee_pobj) tee_pobjs =
-		TAILQ_HEAD_INITIALIZER(tee_pobjs);
-static struct mutex pobjs_mutex = MUTEX_INITIALIZER;
+/*
+ * Open persistent objects are hashed on UUID and object ID, each bucket
+ * has its own mutex protecting the list and the objects in it.
+ */
+#define POBJ_HASH_BITS	5
+
+struct pobj_bucket {
+	struct mutex mu;
+	LIST_HEAD(, tee_pobj) list;
+	size_t len;
+	uint64_t locks;
+	uint64_t contended;
+};
+
+static struct pobj_bucket pobj_buckets[BIT(POBJ_HASH_BITS)] = {
+	[0 ... BIT(POBJ_HASH_BITS) - 1] = { .mu = MUTEX_INITIALIZER },
+};
+
+/* FNV-1a */
+static uint32_t hash_bytes(uint32_t h, const void *buf, size_t len)
+{
+	const uint8_t *b = buf;
+	size_t n = 0;
+
+	for (n = 0; n < len; n++)
+		h = (h ^ b[n]) * 16777619U;
+
+	return h;
+}
+
+static struct pobj_bucket *pobj_bucket(const TEE_UUID *uuid,
+				       const void *obj_id, uint32_t obj_id_len)
+{
+	uint32_t h = 2166136261U;
+
+	h = hash_bytes(h, uuid, sizeof(*uuid));
+	h = hash_bytes(h, obj_id, obj_id_len);
+
+	return pobj_buckets + (h >> (32 - POBJ_HASH_BITS));
+}
+
+static void bucket_lock(struct pobj_bucket *b)
+{
+	if (!mutex_trylock(&b->mu)) {
+		mutex_lock(&b->mu);
+		b->contended++;
+	}
+	b->locks++;
+}
+
+static void bucket_unlock(struct pobj_bucket *b)
+{
+	mutex_unlock(&b->mu);
+}
 
 static TEE_Result tee_pobj_check_access(uint32_t oflags, uint32_t nflags)
 {
@@ -62,19 +114,21 @@ TEE_Result tee_pobj_get(TEE_UUID *uuid, void *obj_id, uint32_t obj_id_len,
 			const struct tee_file_operations *fops,
 			struct tee_pobj **obj)
 {
+	struct pobj_bucket *b = pobj_bucket(uuid, obj_id, obj_id_len);
 	TEE_Result res = TEE_SUCCESS;
 	struct tee_pobj *o = NULL;
 
 	*obj = NULL;
 
-	mutex_lock(&pobjs_mutex);
+	bucket_lock(b);
 	/* Check if file is open */
-	TAILQ_FOREACH(o, &tee_pobjs, link) {
+	LIST_FOREACH(o, &b->list, link) {
 		if ((obj_id_len == o->obj_id_len) &&
 		    (memcmp(obj_id, o->obj_id, obj_id_len) == 0) &&
 		    (memcmp(uuid, &o->uuid, sizeof(TEE_UUID)) == 0) &&
 		    (fops == o->fops)) {
 			*obj = o;
+			break;
 		}
 	}
 
@@ -120,38 +174,46 @@ TEE_Result tee_pobj_get(TEE_UUID *uuid, void *obj_id, uint32_t obj_id_len,
 	memcpy(o->obj_id, obj_id, obj_id_len);
 	o->obj_id_len = obj_id_len;
 
-	TAILQ_INSERT_TAIL(&tee_pobjs, o, link);
+	LIST_INSERT_HEAD(&b->list, o, link);
+	b->len++;
 	*obj = o;
 
 	res = TEE_SUCCESS;
 out:
 	if (res != TEE_SUCCESS)
 		*obj = NULL;
-	mutex_unlock(&pobjs_mutex);
+	bucket_unlock(b);
 	return res;
 }
 
 void tee_pobj_create_final(struct tee_pobj *po)
 {
-	mutex_lock(&pobjs_mutex);
+	struct pobj_bucket *b = pobj_bucket(&po->uuid, po->obj_id,
+					    po->obj_id_len);
+
+	bucket_lock(b);
 	po->temporary = false;
 	po->creating = false;
-	mutex_unlock(&pobjs_mutex);
+	bucket_unlock(b);
 }
 
 TEE_Result tee_pobj_release(struct tee_pobj *obj)
 {
+	struct pobj_bucket *b = NULL;
+
 	if (obj == NULL)
 		return TEE_ERROR_BAD_PARAMETERS;
 
-	mutex_lock(&pobjs_mutex);
+	b = pobj_bucket(&obj->uuid, obj->obj_id, obj->obj_id_len);
+	bucket_lock(b);
 	obj->refcnt--;
 	if (obj->refcnt == 0) {
-		TAILQ_REMOVE(&tee_pobjs, obj, link);
+		LIST_REMOVE(obj, link);
+		b->len--;
 		free(obj->obj_id);
 		free(obj);
 	}
-	mutex_unlock(&pobjs_mutex);
+	bucket_unlock(b);
 
 	return TEE_SUCCESS;
 }
@@ -159,33 +221,72 @@ TEE_Result tee_pobj_release(struct tee_pobj *obj)
 TEE_Result tee_pobj_rename(struct tee_pobj *obj, void *obj_id,
 			   uint32_t obj_id_len)
 {
+	struct pobj_bucket *old_b = NULL;
+	struct pobj_bucket *new_b = NULL;
 	TEE_Result res = TEE_SUCCESS;
 	void *new_obj_id = NULL;
 
 	if (obj == NULL || obj_id == NULL)
 		return TEE_ERROR_BAD_PARAMETERS;
 
-	mutex_lock(&pobjs_mutex);
+	new_obj_id = malloc(obj_id_len);
+	if (new_obj_id == NULL)
+		return TEE_ERROR_OUT_OF_MEMORY;
+	memcpy(new_obj_id, obj_id, obj_id_len);
+
+	old_b = pobj_bucket(&obj->uuid, obj->obj_id, obj->obj_id_len);
+	new_b = pobj_bucket(&obj->uuid, obj_id, obj_id_len);
+
+	/* Buckets are always locked in address order */
+	if (new_b < old_b)
+		bucket_lock(new_b);
+	bucket_lock(old_b);
+	if (new_b > old_b)
+		bucket_lock(new_b);
+
 	if (obj->refcnt != 1) {
 		res = TEE_ERROR_BAD_STATE;
 		goto exit;
 	}
 
-	new_obj_id = malloc(obj_id_len);
-	if (new_obj_id == NULL) {
-		res = TEE_ERROR_OUT_OF_MEMORY;
-		goto exit;
-	}
-	memcpy(new_obj_id, obj_id, obj_id_len);
-
 	/* update internal data */
 	free(obj->obj_id);
 	obj->obj_id = new_obj_id;
 	obj->obj_id_len = obj_id_len;
 	new_obj_id = NULL;
 
+	if (new_b != old_b) {
+		LIST_REMOVE(obj, link);
+		old_b->len--;
+		LIST_INSERT_HEAD(&new_b->list, obj, link);
+		new_b->len++;
+	}
+
 exit:
-	mutex_unlock(&pobjs_mutex);
+	if (new_b != old_b)
+		bucket_unlock(new_b);
+	bucket_unlock(old_b);
 	free(new_obj_id);
 	return res;
 }
+
+void tee_pobj_get_stats(struct tee_pobj_stats *stats, bool reset)
+{
+	struct pobj_bucket *b = NULL;
+
+	*stats = (struct tee_pobj_stats){ .buckets = ARRAY_SIZE(pobj_buckets) };
+
+	for (b = pobj_buckets; b < pobj_buckets + ARRAY_SIZE(pobj_buckets);
+	     b++) {
+		mutex_lock(&b->mu);
+		stats->locks += b->locks;
+		stats->contended += b->contended;
+		stats->objects += b->len;
+		stats->max_chain = MAX(stats->max_chain, (uint32_t)b->len);
+		if (reset) {
+			b->locks = 0;
+			b->contended = 0;
+		}
+		mutex_unlock(&b->mu);
+	}
+}
@@ -7,7 +7,9 @@
 #include <config.h>
 #include <kernel/mutex.h>
 #include <kernel/panic.h>
+#include <kernel/tee_time.h>
 #include <kernel/thread.h>
+#include <kernel/ts_manager.h>
 #include <mempool.h>
 #include <mm/core_memprot.h>
 #include <mm/tee_pager.h>
@@ -30,17 +32,38 @@
 
 #define BLOCK_SIZE	(1 << BLOCK_SHIFT)
 
+/*
+ * Files internal to the REE FS, dirf.db and the object info index, are
+ * scanned one small record at a time. @rblock caches the last block read
+ * from such a file so that a scan reads each block only once.
+ *
+ * A file updated in a transaction has @in_trans set, it's shared by all
+ * handles opened on it until the transaction ends and @trans_hash is the
+ * hash of the file when the transaction started, @created is set if the
+ * file was created by the transaction. If the transaction is aborted the
+ * file of such a handle is deleted, or it may fail to be reopened, @ht is
+ * then left NULL, the handle is dead and can only be closed.
+ */
 struct tee_fs_fd {
 	struct tee_fs_htree *ht;
 	int fd;
 	struct tee_fs_dirfile_fileh dfh;
 	const TEE_UUID *uuid;
+	uint8_t *rblock;
+	int rblock_num;
+	unsigned int refcount;
+	bool in_trans;
+	bool removed;
+	bool created;
+	uint8_t trans_hash[TEE_FS_HTREE_HASH_SIZE];
+	TAILQ_ENTRY(tee_fs_fd) trans_link;
 };
 
 struct tee_fs_dir {
 	struct tee_fs_dirfile_dirh *dirh;
 	int idx;
 	struct tee_fs_dirent d;
+	struct tee_fs_dirfile_fileh dfh;
 	const TEE_UUID *uuid;
 };
 
@@ -84,6 +107,8 @@ static TEE_Result out_of_place_write(struct tee_fs_fd *fdp, size_t pos,
 	if (!block)
 		return TEE_ERROR_OUT_OF_MEMORY;
 
+	fdp->rblock_num = -1;
+
 	while (start_block_num <= end_block_num) {
 		size_t offset = pos % BLOCK_SIZE;
 		size_t size_to_write = MIN(remain_bytes, (size_t)BLOCK_SIZE);
@@ -278,6 +303,7 @@ static TEE_Result ree_fs_ftruncate_internal(struct tee_fs_fd *fdp,
 		if (res != TEE_SUCCESS)
 			return res;
 
+		fdp->rblock_num = -1;
 		res = tee_fs_htree_truncate(&fdp->ht,
 					    new_file_len / BLOCK_SIZE);
 		if (res != TEE_SUCCESS)
@@ -323,10 +349,23 @@ static TEE_Result ree_fs_read_primitive(struct tee_file_handle *fh, size_t pos,
 	start_block_num = pos_to_block_num(pos);
 	end_block_num = pos_to_block_num(pos + remain_bytes - 1);
 
-	block = get_tmp_block();
-	if (!block) {
-		res = TEE_ERROR_OUT_OF_MEMORY;
-		goto exit;
+	if (fdp->rblock) {
+		if (start_block_num == end_block_num &&
+		    start_block_num == fdp->rblock_num) {
+			memcpy(data_ptr, fdp->rblock + pos % BLOCK_SIZE,
+			       remain_bytes);
+			res = TEE_SUCCESS;
+			goto exit;
+		}
+		/* The cached block is overwritten below */
+		fdp->rblock_num = -1;
+		block = fdp->rblock;
+	} else {
+		block = get_tmp_block();
+		if (!block) {
+			res = TEE_ERROR_OUT_OF_MEMORY;
+			goto exit;
+		}
 	}
 
 	while (start_block_num <= end_block_num) {
@@ -339,6 +378,8 @@ static TEE_Result ree_fs_read_primitive(struct tee_file_handle *fh, size_t pos,
 		res = tee_fs_htree_read_block(&fdp->ht, start_block_num, block);
 		if (res != TEE_SUCCESS)
 			goto exit;
+		if (block == fdp->rblock)
+			fdp->rblock_num = start_block_num;
 
 		memcpy(data_ptr, block + offset, size_to_read);
 
@@ -350,7 +391,7 @@ static TEE_Result ree_fs_read_primitive(struct tee_file_handle *fh, size_t pos,
 	}
 	res = TEE_SUCCESS;
 exit:
-	if (block)
+	if (block && block != fdp->rblock)
 		put_tmp_block(block);
 	return res;
 }
@@ -361,7 +402,10 @@ static TEE_Result ree_fs_read(struct tee_file_handle *fh, size_t pos,
 	TEE_Result res;
 
 	mutex_lock(&ree_fs_mutex);
-	res = ree_fs_read_primitive(fh, pos, buf, len);
+	if (((struct tee_fs_fd *)fh)->ht)
+		res = ree_fs_read_primitive(fh, pos, buf, len);
+	else
+		res = TEE_ERROR_BAD_STATE;
 	mutex_unlock(&ree_fs_mutex);
 
 	return res;
@@ -404,6 +448,16 @@ static TEE_Result ree_fs_open_primitive(bool create, uint8_t *hash,
 		return TEE_ERROR_OUT_OF_MEMORY;
 	fdp->fd = -1;
 	fdp->uuid = uuid;
+	fdp->refcount = 1;
+	fdp->rblock_num = -1;
+	if (!uuid) {
+		/* Not a TA object, see struct tee_fs_fd */
+		fdp->rblock = malloc(BLOCK_SIZE);
+		if (!fdp->rblock) {
+			free(fdp);
+			return TEE_ERROR_OUT_OF_MEMORY;
+		}
+	}
 
 	if (create)
 		res = tee_fs_rpc_create_dfh(OPTEE_RPC_CMD_FS,
@@ -430,6 +484,7 @@ out:
 			tee_fs_rpc_close(OPTEE_RPC_CMD_FS, fdp->fd);
 		if (create)
 			tee_fs_rpc_remove_dfh(OPTEE_RPC_CMD_FS, dfh);
+		free(fdp->rblock);
 		free(fdp);
 	}
 
@@ -443,6 +498,7 @@ static void ree_fs_close_primitive(struct tee_file_handle *fh)
 	if (fdp) {
 		tee_fs_htree_close(&fdp->ht);
 		tee_fs_rpc_close(OPTEE_RPC_CMD_FS, fdp->fd);
+		free(fdp->rblock);
 		free(fdp);
 	}
 }
@@ -568,6 +624,145 @@ static void close_dirh(struct tee_fs_dirfile_dirh **dirh)
 }
 #endif /*!CFG_REE_FS_INTEGRITY_RPMB*/
 
+/*
+ * Transactions
+ *
+ * While a TA has a transaction open the updates of its objects are made
+ * to dirf.db in memory only. The files written in the transaction aren't
+ * synced either, so the versions dirf.db refers to on storage stay
+ * intact, and the files removed or replaced are only deleted once the
+ * transaction is committed. Committing syncs the updated files and
+ * commits dirf.db once, aborting drops the in-memory state of dirf.db
+ * and of the updated files.
+ *
+ * Any commit of dirf.db would include the pending changes, so only one TA
+ * instance at a time can have a transaction. The storage operations of
+ * the others wait until it ends, at most REE_FS_TRANS_WAIT_MS.
+ */
+#define REE_FS_TRANS_WAIT_MS	5000
+#define REE_FS_TRANS_POLL_MS	10
+
+struct ree_fs_trans {
+	struct ts_ctx *ctx;
+	TAILQ_HEAD(, tee_fs_fd) fds;
+	struct tee_fs_dirfile_fileh *removed;
+	size_t num_removed;
+	struct tee_fs_dirfile_fileh *created;
+	size_t num_created;
+	bool failed;
+};
+
+static struct ree_fs_trans *ree_fs_trans;
+
+#ifdef CFG_REE_FS_ENUM_INFO
+/*
+ * Object info index
+ *
+ * Record n of the index caches the object information of the file in
+ * entry n of dirf.db. A record is only valid while its hash matches the
+ * hash in the dirf.db entry, any update of the object file invalidates it.
+ *
+ * The index is an htree file listed in dirf.db with a nil UUID, which no
+ * TA can have, so it's covered by the hash of dirf.db. Records are added
+ * while enumerating objects and the index is committed when the
+ * enumeration ends.
+ */
+struct info_rec {
+	uint8_t hash[TEE_FS_HTREE_HASH_SIZE];
+	struct tee_fs_obj_info info;
+	uint32_t reserved[3];
+};
+
+static const TEE_UUID info_uuid;
+static const char info_oid[] = "dirf.info";
+static struct tee_file_handle *info_fh;
+static bool info_dirty;
+
+static TEE_Result open_info(struct tee_fs_dirfile_dirh *dirh, bool create)
+{
+	struct tee_fs_dirfile_fileh dfh = { .idx = -1 };
+	TEE_Result res = TEE_SUCCESS;
+
+	if (info_fh)
+		return TEE_SUCCESS;
+
+	res = tee_fs_dirfile_find(dirh, &info_uuid, info_oid,
+				  sizeof(info_oid) - 1, &dfh);
+	if (!res)
+		return ree_fs_open_primitive(false, dfh.hash, NULL, &dfh,
+					     &info_fh);
+	if (res != TEE_ERROR_ITEM_NOT_FOUND || !create)
+		return res;
+
+	/* Added to dirf.db by the first flush_info() */
+	res = tee_fs_dirfile_get_tmp(dirh, &dfh);
+	if (res)
+		return res;
+	dfh.idx = -1;
+
+	return ree_fs_open_primitive(true, dfh.hash, NULL, &dfh, &info_fh);
+}
+
+static void close_info(void)
+{
+	struct tee_fs_fd *fdp = (struct tee_fs_fd *)info_fh;
+	struct tee_fs_dirfile_fileh dfh = { };
+
+	if (!fdp)
+		return;
+
+	dfh = fdp->dfh;
+	ree_fs_close_primitive(info_fh);
+	info_fh = NULL;
+	info_dirty = false;
+
+	/* Never committed, nothing refers to the file */
+	if (dfh.idx == -1)
+		tee_fs_rpc_remove_dfh(OPTEE_RPC_CMD_FS, &dfh);
+}
+
+static TEE_Result flush_info(struct tee_fs_dirfile_dirh *dirh)
+{
+	struct tee_fs_fd *fdp = (struct tee_fs_fd *)info_fh;
+	TEE_Result res = TEE_SUCCESS;
+
+	/* Committing dirf.db would also commit the transaction */
+	if (!info_dirty || ree_fs_trans)
+		return TEE_SUCCESS;
+
+	res = tee_fs_htree_sync_to_storage(&fdp->ht, fdp->dfh.hash);
+	if (res)
+		goto out;
+
+	if (fdp->dfh.idx == -1)
+		res = tee_fs_dirfile_rename(dirh, &info_uuid, &fdp->dfh,
+					    info_oid, sizeof(info_oid) - 1);
+	else
+		res = tee_fs_dirfile_update_hash(dirh, &fdp->dfh);
+	if (res)
+		goto out;
+
+	res = commit_dirh_writes(dirh);
+out:
+	if (res) {
+		DMSG("Can't commit object info index: %#"PRIx32, res);
+		close_info();
+	}
+	info_dirty = false;
+
+	return res;
+}
+#else
+static void close_info(void)
+{
+}
+
+static TEE_Result flush_info(struct tee_fs_dirfile_dirh *dirh __unused)
+{
+	return TEE_SUCCESS;
+}
+#endif /*CFG_REE_FS_ENUM_INFO*/
+
 static TEE_Result get_dirh(struct tee_fs_dirfile_dirh **dirh)
 {
 	if (!ree_fs_dirh) {
@@ -602,8 +797,13 @@ static void put_dirh_primitive(bool close)
 	 * ree_fs_dirh may actually be NULL.
 	 */
 	ree_fs_dirh_refcount--;
-	if (ree_fs_dirh && (!ree_fs_dirh_refcount || close))
+	if (ree_fs_dirh && (!ree_fs_dirh_refcount || close)) {
+		/* The changes made in the transaction are lost */
+		if (ree_fs_trans)
+			ree_fs_trans->failed = true;
+		close_info();
 		close_dirh(&ree_fs_dirh);
+	}
 }
 
 static void put_dirh(struct tee_fs_dirfile_dirh *dirh, bool close)
@@ -614,6 +814,181 @@ static void put_dirh(struct tee_fs_dirfile_dirh *dirh, bool close)
 	}
 }
 
+static struct ts_ctx *get_current_ctx(void)
+{
+	struct ts_session *sess = ts_get_current_session_may_fail();
+
+	if (!sess)
+		return NULL;
+	return sess->ctx;
+}
+
+/*
+ * Waits with ree_fs_mutex held until the current TA instance can update
+ * the storage. A TA which keeps its transaction open must not stall the
+ * storage of all the others, so the wait is bounded.
+ */
+static TEE_Result wait_trans(void)
+{
+	struct ts_ctx *ctx = get_current_ctx();
+	unsigned int ms = 0;
+
+	while (ree_fs_trans && ree_fs_trans->ctx != ctx) {
+		if (ms >= REE_FS_TRANS_WAIT_MS)
+			return TEE_ERROR_STORAGE_NOT_AVAILABLE;
+		mutex_unlock(&ree_fs_mutex);
+		tee_time_wait(REE_FS_TRANS_POLL_MS);
+		mutex_lock(&ree_fs_mutex);
+		ms += REE_FS_TRANS_POLL_MS;
+	}
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result add_dfh(struct tee_fs_dirfile_fileh **dfhs, size_t *num,
+			  const struct tee_fs_dirfile_fileh *dfh)
+{
+	struct tee_fs_dirfile_fileh *p = NULL;
+
+	p = realloc(*dfhs, (*num + 1) * sizeof(*p));
+	if (!p)
+		return TEE_ERROR_OUT_OF_MEMORY;
+	p[*num] = *dfh;
+	*dfhs = p;
+	(*num)++;
+
+	return TEE_SUCCESS;
+}
+
+static struct tee_fs_fd *trans_find_fd(uint32_t file_number)
+{
+	struct tee_fs_fd *fdp = NULL;
+
+	TAILQ_FOREACH(fdp, &ree_fs_trans->fds, trans_link)
+		if (!fdp->removed && fdp->dfh.file_number == file_number)
+			return fdp;
+
+	return NULL;
+}
+
+/* Called before the file of @fdp is updated in the transaction */
+static TEE_Result trans_add_fd(struct tee_fs_fd *fdp)
+{
+	if (fdp->in_trans)
+		return TEE_SUCCESS;
+
+	/*
+	 * Two handles can't update the same file without syncing in
+	 * between, handles opened after this one share it.
+	 */
+	if (trans_find_fd(fdp->dfh.file_number))
+		return TEE_ERROR_ACCESS_CONFLICT;
+
+	memcpy(fdp->trans_hash, fdp->dfh.hash, sizeof(fdp->trans_hash));
+	fdp->in_trans = true;
+	TAILQ_INSERT_TAIL(&ree_fs_trans->fds, fdp, trans_link);
+
+	return TEE_SUCCESS;
+}
+
+/* @dfh was removed from dirf.db, delete the file once committed */
+static TEE_Result trans_remove_file(struct tee_fs_dirfile_dirh *dirh,
+				    const struct tee_fs_dirfile_fileh *dfh)
+{
+	struct tee_fs_fd *fdp = trans_find_fd(dfh->file_number);
+	TEE_Result res = TEE_SUCCESS;
+
+	res = add_dfh(&ree_fs_trans->removed, &ree_fs_trans->num_removed,
+		      dfh);
+	if (res)
+		return res;
+
+	if (fdp)
+		fdp->removed = true;
+
+	return tee_fs_dirfile_hold_file_number(dirh, dfh->file_number);
+}
+
+static TEE_Result trans_commit(struct tee_fs_dirfile_dirh *dirh)
+{
+	struct tee_fs_fd *fdp = NULL;
+	TEE_Result res = TEE_SUCCESS;
+	size_t n = 0;
+
+	if (ree_fs_trans->failed)
+		return TEE_ERROR_BAD_STATE;
+
+	TAILQ_FOREACH(fdp, &ree_fs_trans->fds, trans_link) {
+		if (fdp->removed)
+			continue;
+
+		res = tee_fs_htree_sync_to_storage(&fdp->ht, fdp->dfh.hash);
+		if (res)
+			return res;
+
+		res = tee_fs_dirfile_update_hash(dirh, &fdp->dfh);
+		if (res)
+			return res;
+	}
+
+	res = commit_dirh_writes(dirh);
+	if (res)
+		return res;
+
+	for (n = 0; n < ree_fs_trans->num_removed; n++) {
+		struct tee_fs_dirfile_fileh *dfh = ree_fs_trans->removed + n;
+
+		tee_fs_rpc_remove_dfh(OPTEE_RPC_CMD_FS, dfh);
+		tee_fs_dirfile_release_file_number(dirh, dfh->file_number);
+	}
+
+	return TEE_SUCCESS;
+}
+
+static void trans_release_fds(bool committed)
+{
+	struct tee_fs_htree *ht = NULL;
+	struct tee_fs_fd *fdp = NULL;
+	TEE_Result res = TEE_SUCCESS;
+	bool created = false;
+
+	while ((fdp = TAILQ_FIRST(&ree_fs_trans->fds))) {
+		TAILQ_REMOVE(&ree_fs_trans->fds, fdp, trans_link);
+		created = fdp->created;
+		fdp->in_trans = false;
+		fdp->created = false;
+
+		if (!fdp->refcount) {
+			ree_fs_close_primitive((struct tee_file_handle *)fdp);
+			continue;
+		}
+
+		if (committed)
+			continue;
+
+		/* The file removed in the transaction is back in dirf.db */
+		fdp->removed = false;
+		if (created) {
+			/* The file and its entry in dirf.db are gone */
+			tee_fs_htree_close(&fdp->ht);
+			continue;
+		}
+
+		/* Back to the version of the file before the transaction */
+		memcpy(fdp->dfh.hash, fdp->trans_hash, sizeof(fdp->dfh.hash));
+		fdp->rblock_num = -1;
+		ht = NULL;
+		res = tee_fs_htree_open(false, fdp->dfh.hash, fdp->uuid,
+					&ree_fs_storage_ops, fdp, &ht);
+		tee_fs_htree_close(&fdp->ht);
+		if (res)
+			EMSG("Can't reopen file %"PRIu32": %#"PRIx32,
+			     fdp->dfh.file_number, res);
+		else
+			fdp->ht = ht;
+	}
+}
+
 static TEE_Result ree_fs_open(struct tee_pobj *po, size_t *size,
 			      struct tee_file_handle **fh)
 {
@@ -622,6 +997,9 @@ static TEE_Result ree_fs_open(struct tee_pobj *po, size_t *size,
 	struct tee_fs_dirfile_fileh dfh;
 
 	mutex_lock(&ree_fs_mutex);
+	res = wait_trans();
+	if (res)
+		goto out;
 
 	res = get_dirh(&dirh);
 	if (res != TEE_SUCCESS)
@@ -632,6 +1010,23 @@ static TEE_Result ree_fs_open(struct tee_pobj *po, size_t *size,
 	if (res != TEE_SUCCESS)
 		goto out;
 
+	if (ree_fs_trans) {
+		struct tee_fs_fd *fdp = trans_find_fd(dfh.file_number);
+
+		/* The file has updates not synced yet, share its handle */
+		if (fdp) {
+			if (!fdp->ht) {
+				res = TEE_ERROR_BAD_STATE;
+				goto out;
+			}
+			fdp->refcount++;
+			*fh = (struct tee_file_handle *)fdp;
+			if (size)
+				*size = tee_fs_htree_get_meta(fdp->ht)->length;
+			goto out;
+		}
+	}
+
 	res = ree_fs_open_primitive(false, dfh.hash, &po->uuid, &dfh, fh);
 	if (res == TEE_ERROR_ITEM_NOT_FOUND) {
 		/*
@@ -680,6 +1075,12 @@ static TEE_Result set_name(struct tee_fs_dirfile_dirh *dirh,
 	if (res)
 		return res;
 
+	if (ree_fs_trans) {
+		if (have_old_dfh)
+			return trans_remove_file(dirh, &old_dfh);
+		return TEE_SUCCESS;
+	}
+
 	res = commit_dirh_writes(dirh);
 	if (res)
 		return res;
@@ -692,10 +1093,15 @@ static TEE_Result set_name(struct tee_fs_dirfile_dirh *dirh,
 
 static void ree_fs_close(struct tee_file_handle **fh)
 {
-	if (*fh) {
+	struct tee_fs_fd *fdp = (struct tee_fs_fd *)*fh;
+
+	if (fdp) {
 		mutex_lock(&ree_fs_mutex);
 		put_dirh_primitive(false);
-		ree_fs_close_primitive(*fh);
+		fdp->refcount--;
+		/* Files updated in a transaction are closed when it ends */
+		if (!fdp->refcount && !fdp->in_trans)
+			ree_fs_close_primitive(*fh);
 		*fh = NULL;
 		mutex_unlock(&ree_fs_mutex);
 
@@ -716,6 +1122,9 @@ static TEE_Result ree_fs_create(struct tee_pobj *po, bool overwrite,
 
 	*fh = NULL;
 	mutex_lock(&ree_fs_mutex);
+	res = wait_trans();
+	if (res)
+		goto out;
 
 	res = get_dirh(&dirh);
 	if (res)
@@ -755,6 +1164,15 @@ static TEE_Result ree_fs_create(struct tee_pobj *po, bool overwrite,
 		goto out;
 
 	res = set_name(dirh, fdp, po, overwrite);
+	/* Deleted if the transaction is aborted */
+	if (!res && ree_fs_trans) {
+		res = add_dfh(&ree_fs_trans->created,
+			      &ree_fs_trans->num_created, &dfh);
+		if (!res)
+			res = trans_add_fd(fdp);
+		if (!res)
+			fdp->created = true;
+	}
 out:
 	if (res) {
 		put_dirh(dirh, true);
@@ -777,11 +1195,26 @@ static TEE_Result ree_fs_write(struct tee_file_handle *fh, size_t pos,
 	struct tee_fs_fd *fdp = (struct tee_fs_fd *)fh;
 
 	mutex_lock(&ree_fs_mutex);
+	res = wait_trans();
+	if (res)
+		goto out;
+
+	if (!fdp->ht) {
+		res = TEE_ERROR_BAD_STATE;
+		goto out;
+	}
 
 	res = get_dirh(&dirh);
 	if (res)
 		goto out;
 
+	if (ree_fs_trans) {
+		res = trans_add_fd(fdp);
+		if (!res)
+			res = ree_fs_write_primitive(fh, pos, buf, len);
+		goto out;
+	}
+
 	res = ree_fs_write_primitive(fh, pos, buf, len);
 	if (res)
 		goto out;
@@ -795,7 +1228,7 @@ static TEE_Result ree_fs_write(struct tee_file_handle *fh, size_t pos,
 		goto out;
 	res = commit_dirh_writes(dirh);
 out:
-	put_dirh(dirh, res);
+	put_dirh(dirh, res != TEE_SUCCESS);
 	mutex_unlock(&ree_fs_mutex);
 
 	return res;
@@ -813,6 +1246,9 @@ static TEE_Result ree_fs_rename(struct tee_pobj *old, struct tee_pobj *new,
 		return TEE_ERROR_BAD_PARAMETERS;
 
 	mutex_lock(&ree_fs_mutex);
+	res = wait_trans();
+	if (res)
+		goto out;
 	res = get_dirh(&dirh);
 	if (res)
 		goto out;
@@ -840,6 +1276,12 @@ static TEE_Result ree_fs_rename(struct tee_pobj *old, struct tee_pobj *new,
 			goto out;
 	}
 
+	if (ree_fs_trans) {
+		if (remove_dfh.idx != -1)
+			res = trans_remove_file(dirh, &remove_dfh);
+		goto out;
+	}
+
 	res = commit_dirh_writes(dirh);
 	if (res)
 		goto out;
@@ -848,7 +1290,7 @@ static TEE_Result ree_fs_rename(struct tee_pobj *old, struct tee_pobj *new,
 		tee_fs_rpc_remove_dfh(OPTEE_RPC_CMD_FS, &remove_dfh);
 
 out:
-	put_dirh(dirh, res);
+	put_dirh(dirh, res != TEE_SUCCESS);
 	mutex_unlock(&ree_fs_mutex);
 
 	return res;
@@ -862,6 +1304,9 @@ static TEE_Result ree_fs_remove(struct tee_pobj *po)
 	struct tee_fs_dirfile_fileh dfh;
 
 	mutex_lock(&ree_fs_mutex);
+	res = wait_trans();
+	if (res)
+		goto out;
 	res = get_dirh(&dirh);
 	if (res)
 		goto out;
@@ -875,6 +1320,11 @@ static TEE_Result ree_fs_remove(struct tee_pobj *po)
 	if (res)
 		goto out;
 
+	if (ree_fs_trans) {
+		res = trans_remove_file(dirh, &dfh);
+		goto out;
+	}
+
 	res = commit_dirh_writes(dirh);
 	if (res)
 		goto out;
@@ -884,7 +1334,7 @@ static TEE_Result ree_fs_remove(struct tee_pobj *po)
 	assert(tee_fs_dirfile_find(dirh, &po->uuid, po->obj_id, po->obj_id_len,
 				   &dfh));
 out:
-	put_dirh(dirh, res);
+	put_dirh(dirh, res != TEE_SUCCESS);
 	mutex_unlock(&ree_fs_mutex);
 
 	return res;
@@ -897,11 +1347,26 @@ static TEE_Result ree_fs_truncate(struct tee_file_handle *fh, size_t len)
 	struct tee_fs_fd *fdp = (struct tee_fs_fd *)fh;
 
 	mutex_lock(&ree_fs_mutex);
+	res = wait_trans();
+	if (res)
+		goto out;
+
+	if (!fdp->ht) {
+		res = TEE_ERROR_BAD_STATE;
+		goto out;
+	}
 
 	res = get_dirh(&dirh);
 	if (res)
 		goto out;
 
+	if (ree_fs_trans) {
+		res = trans_add_fd(fdp);
+		if (!res)
+			res = ree_fs_ftruncate_internal(fdp, len);
+		goto out;
+	}
+
 	res = ree_fs_ftruncate_internal(fdp, len);
 	if (res)
 		goto out;
@@ -915,7 +1380,7 @@ static TEE_Result ree_fs_truncate(struct tee_file_handle *fh, size_t len)
 		goto out;
 	res = commit_dirh_writes(dirh);
 out:
-	put_dirh(dirh, res);
+	put_dirh(dirh, res != TEE_SUCCESS);
 	mutex_unlock(&ree_fs_mutex);
 
 	return res;
@@ -934,6 +1399,9 @@ static TEE_Result ree_fs_opendir_rpc(const TEE_UUID *uuid,
 	d->uuid = uuid;
 
 	mutex_lock(&ree_fs_mutex);
+	res = wait_trans();
+	if (res)
+		goto out;
 
 	res = get_dirh(&d->dirh);
 	if (res)
@@ -962,9 +1430,13 @@ out:
 static void ree_fs_closedir_rpc(struct tee_fs_dir *d)
 {
 	if (d) {
+		TEE_Result res = TEE_SUCCESS;
+
 		mutex_lock(&ree_fs_mutex);
 
-		put_dirh(d->dirh, false);
+		res = flush_info(d->dirh);
+		/* Close on failure so that the index is rebuilt next time */
+		put_dirh(d->dirh, res != TEE_SUCCESS);
 		free(d);
 
 		mutex_unlock(&ree_fs_mutex);
@@ -977,12 +1449,166 @@ static TEE_Result ree_fs_readdir_rpc(struct tee_fs_dir *d,
 	TEE_Result res;
 
 	mutex_lock(&ree_fs_mutex);
+	res = wait_trans();
+	if (res)
+		goto out;
 
 	d->d.oidlen = sizeof(d->d.oid);
 	res = tee_fs_dirfile_get_next(d->dirh, d->uuid, &d->idx, d->d.oid,
 				      &d->d.oidlen);
+	if (res == TEE_SUCCESS && IS_ENABLED(CFG_REE_FS_ENUM_INFO))
+		res = tee_fs_dirfile_get_fileh(d->dirh, d->uuid, d->idx,
+					       &d->dfh);
 	if (res == TEE_SUCCESS)
 		*ent = &d->d;
+out:
+	mutex_unlock(&ree_fs_mutex);
+
+	return res;
+}
+
+#ifdef CFG_REE_FS_ENUM_INFO
+static TEE_Result ree_fs_get_dirent_info(struct tee_fs_dir *d,
+					 struct tee_fs_obj_info *info)
+{
+	struct info_rec rec = { };
+	size_t len = sizeof(rec);
+	TEE_Result res = TEE_SUCCESS;
+
+	mutex_lock(&ree_fs_mutex);
+
+	res = open_info(d->dirh, false);
+	if (res)
+		goto out;
+
+	res = ree_fs_read_primitive(info_fh, d->idx * sizeof(rec), &rec,
+				    &len);
+	if (res)
+		goto out;
+
+	if (len != sizeof(rec) ||
+	    memcmp(rec.hash, d->dfh.hash, sizeof(rec.hash))) {
+		res = TEE_ERROR_ITEM_NOT_FOUND;
+		goto out;
+	}
+
+	*info = rec.info;
+out:
+	mutex_unlock(&ree_fs_mutex);
+
+	return res;
+}
+
+static void ree_fs_set_dirent_info(struct tee_fs_dir *d,
+				   const struct tee_fs_obj_info *info)
+{
+	struct tee_fs_dirfile_fileh dfh = { };
+	struct info_rec rec = { .info = *info };
+	TEE_Result res = TEE_SUCCESS;
+
+	mutex_lock(&ree_fs_mutex);
+
+	/*
+	 * The information was read after readdir() and the object may have
+	 * been updated in between, only record it if it's still current.
+	 */
+	res = tee_fs_dirfile_get_fileh(d->dirh, d->uuid, d->idx, &dfh);
+	if (res || dfh.file_number != d->dfh.file_number ||
+	    memcmp(dfh.hash, d->dfh.hash, sizeof(dfh.hash)))
+		goto out;
+
+	res = open_info(d->dirh, true);
+	if (res)
+		goto out;
+
+	memcpy(rec.hash, dfh.hash, sizeof(rec.hash));
+	res = ree_fs_write_primitive(info_fh, d->idx * sizeof(rec), &rec,
+				     sizeof(rec));
+	if (res)
+		close_info();
+	else
+		info_dirty = true;
+out:
+	mutex_unlock(&ree_fs_mutex);
+}
+#endif /*CFG_REE_FS_ENUM_INFO*/
+
+static TEE_Result ree_fs_begin_transaction(struct ts_ctx *ctx)
+{
+	struct tee_fs_dirfile_dirh *dirh = NULL;
+	struct ree_fs_trans *trans = NULL;
+	TEE_Result res = TEE_SUCCESS;
+
+	mutex_lock(&ree_fs_mutex);
+	res = wait_trans();
+	if (res)
+		goto out;
+
+	if (ree_fs_trans) {
+		res = TEE_ERROR_BAD_STATE;
+		goto out;
+	}
+
+	trans = calloc(1, sizeof(*trans));
+	if (!trans) {
+		res = TEE_ERROR_OUT_OF_MEMORY;
+		goto out;
+	}
+
+	/* Keeps dirf.db open until the transaction ends */
+	res = get_dirh(&dirh);
+	if (res) {
+		free(trans);
+		goto out;
+	}
+
+	trans->ctx = ctx;
+	TAILQ_INIT(&trans->fds);
+	ree_fs_trans = trans;
+out:
+	mutex_unlock(&ree_fs_mutex);
+
+	return res;
+}
+
+static TEE_Result ree_fs_end_transaction(struct ts_ctx *ctx, bool commit)
+{
+	struct tee_fs_dirfile_dirh *dirh = NULL;
+	struct ree_fs_trans *trans = NULL;
+	TEE_Result res = TEE_SUCCESS;
+	size_t n = 0;
+
+	mutex_lock(&ree_fs_mutex);
+
+	trans = ree_fs_trans;
+	if (!trans || trans->ctx != ctx) {
+		mutex_unlock(&ree_fs_mutex);
+		return TEE_ERROR_BAD_STATE;
+	}
+
+	if (commit) {
+		res = get_dirh(&dirh);
+		if (!res)
+			res = trans_commit(dirh);
+		put_dirh(dirh, res != TEE_SUCCESS);
+	}
+
+	if (commit && !res) {
+		trans_release_fds(true);
+		put_dirh_primitive(false);
+	} else {
+		for (n = 0; n < trans->num_created; n++)
+			tee_fs_rpc_remove_dfh(OPTEE_RPC_CMD_FS,
+					      trans->created + n);
+		trans_release_fds(false);
+		/* Drop the changes made to dirf.db in memory */
+		put_dirh_primitive(true);
+	}
+
+	ree_fs_trans = NULL;
+	free(trans->removed);
+	free(trans->created);
+	free(trans);
 
 	mutex_unlock(&ree_fs_mutex);
 
@@ -1001,4 +1627,10 @@ const struct tee_file_operations ree_fs_ops = {
 	.opendir = ree_fs_opendir_rpc,
 	.closedir = ree_fs_closedir_rpc,
 	.readdir = ree_fs_readdir_rpc,
+	.begin_transaction = ree_fs_begin_transaction,
+	.end_transaction = ree_fs_end_transaction,
+#ifdef CFG_REE_FS_ENUM_INFO
+	.get_dirent_info = ree_fs_get_dirent_info,
+	.set_dirent_info = ree_fs_set_dirent_info,
+#endif
 };
@@ -638,6 +638,7 @@ TEE_Result syscall_storage_next_enum(unsigned long obj_enum,
 	struct ts_session *sess = ts_get_current_session();
 	struct user_ta_ctx *utc = to_user_ta_ctx(sess->ctx);
 	struct tee_storage_enum *e = NULL;
+	struct tee_fs_obj_info fi = { };
 	struct tee_fs_dirent *d = NULL;
 	TEE_Result res = TEE_SUCCESS;
 	struct tee_obj *o = NULL;
@@ -684,9 +685,33 @@ TEE_Result syscall_storage_next_enum(unsigned long obj_enum,
 	o->info.handleFlags = o->pobj->flags | TEE_HANDLE_FLAG_PERSISTENT |
 			      TEE_HANDLE_FLAG_INITIALIZED;
 
-	res = tee_svc_storage_read_head(o);
-	if (res != TEE_SUCCESS)
-		goto exit;
+	/*
+	 * Use the object information cached with the directory entry if
+	 * available, the object doesn't have to be opened then.
+	 */
+	if (e->fops->get_dirent_info &&
+	    !e->fops->get_dirent_info(e->dir, &fi)) {
+		o->info.objectType = fi.obj_type;
+		o->info.objectSize = fi.obj_size;
+		o->info.maxObjectSize = fi.max_obj_size;
+		o->info.objectUsage = fi.obj_usage;
+		o->info.dataSize = fi.data_size;
+	} else {
+		res = tee_svc_storage_read_head(o);
+		if (res != TEE_SUCCESS)
+			goto exit;
+
+		if (e->fops->set_dirent_info) {
+			fi = (struct tee_fs_obj_info){
+				.obj_type = o->info.objectType,
+				.obj_size = o->info.objectSize,
+				.max_obj_size = o->info.maxObjectSize,
+				.obj_usage = o->info.objectUsage,
+				.data_size = o->info.dataSize,
+			};
+			e->fops->set_dirent_info(e->dir, &fi);
+		}
+	}
 
 	*info = (struct utee_object_info){
 		.obj_type = o->info.objectType,
@@ -935,3 +960,52 @@ void tee_svc_storage_close_all_enum(struct user_ta_ctx *utc)
 	while (!TAILQ_EMPTY(eh))
 		tee_svc_close_enum(utc, TAILQ_FIRST(eh));
 }
+
+TEE_Result syscall_storage_trans_begin(unsigned long storage_id)
+{
+	const struct tee_file_operations *fops =
+			tee_svc_storage_file_ops(storage_id);
+	struct ts_session *sess = ts_get_current_session();
+	struct user_ta_ctx *utc = to_user_ta_ctx(sess->ctx);
+	TEE_Result res = TEE_SUCCESS;
+
+	if (!fops)
+		return TEE_ERROR_ITEM_NOT_FOUND;
+
+	if (!fops->begin_transaction)
+		return TEE_ERROR_NOT_SUPPORTED;
+
+	if (utc->storage_trans_fops)
+		return TEE_ERROR_BAD_STATE;
+
+	res = fops->begin_transaction(sess->ctx);
+	if (res)
+		return res;
+
+	utc->storage_trans_fops = fops;
+
+	return TEE_SUCCESS;
+}
+
+TEE_Result syscall_storage_trans_end(unsigned long commit)
+{
+	struct ts_session *sess = ts_get_current_session();
+	struct user_ta_ctx *utc = to_user_ta_ctx(sess->ctx);
+	const struct tee_file_operations *fops = utc->storage_trans_fops;
+
+	if (!fops)
+		return TEE_ERROR_BAD_STATE;
+
+	utc->storage_trans_fops = NULL;
+
+	return fops->end_transaction(sess->ctx, commit);
+}
+
+void tee_svc_storage_abort_trans(struct user_ta_ctx *utc)
+{
+	const struct tee_file_operations *fops = utc->storage_trans_fops;
+
+	utc->storage_trans_fops = NULL;
+	if (fops)
+		fops->end_transaction(&utc->ta_ctx.ts_ctx, false);
+}
@@ -3,8 +3,10 @@
  * Copyright (c) 2019, Linaro Limited
  */
 
+#include <arm_user_sysreg.h>
 #include <assert.h>
 #include <printk.h>
+#include <string.h>
 #include <sys/queue.h>
 #include <types_ext.h>
 #include <util.h>
@@ -53,10 +55,18 @@ bool ftrace_init(struct ftrace_buf **fbuf_ptr)
 	fbuf->ret_func_ptr = finfo->ret_ptr.ptr64;
 	fbuf->ret_idx = 0;
 	fbuf->lr_idx = 0;
+	fbuf->last_time = 0;
 	fbuf->suspend_time = 0;
-	fbuf->buf_off = fbuf->head_off + count;
+	fbuf->overhead = 0;
+	fbuf->rec_count = 0;
+	fbuf->rec_dropped = 0;
+	fbuf->cntfrq = read_cntfrq();
+	/* Records are aligned, the header string is padded with zeroes */
+	fbuf->buf_off = ROUNDUP(fbuf->head_off + count + 1,
+				__alignof__(struct ftrace_rec));
 	fbuf->curr_size = 0;
-	fbuf->max_size = fbuf_size - sizeof(struct ftrace_buf) - count;
+	fbuf->max_size = fbuf_size - fbuf->buf_off;
+	fbuf->wr_off = 0;
 	fbuf->syscall_trace_enabled = false;
 	fbuf->syscall_trace_suspended = false;
 
@@ -65,16 +75,41 @@ bool ftrace_init(struct ftrace_buf **fbuf_ptr)
 	return true;
 }
 
+/*
+ * The dump is the header string followed by a line describing the binary
+ * records, which are then copied oldest first.
+ */
 void ftrace_copy_buf(void *pctx, void (*copy_func)(void *pctx, void *b,
 						   size_t bl))
 {
 	if (fbuf) {
 		struct ta_elf *elf = TAILQ_FIRST(&main_elf_queue);
-		size_t dump_size = fbuf->buf_off - fbuf->head_off +
-				   fbuf->curr_size;
+		char *head = (char *)fbuf + fbuf->head_off;
+		char *recs = (char *)fbuf + fbuf->buf_off;
+		char line[MAX_HEADER_STRLEN] = { };
+		int count = 0;
 
 		assert(elf && elf->is_main);
-		copy_func(pctx, (char *)fbuf + fbuf->head_off, dump_size);
+		copy_func(pctx, head,
+			  strnlen(head, fbuf->buf_off - fbuf->head_off));
+
+		count = snprintk(line, sizeof(line),
+				 "Binary records: size %zu count %"PRIu32
+				 " cntfrq %"PRIu32" overhead %"PRIu64
+				 " total %"PRIu64" dropped %"PRIu64"\n",
+				 sizeof(struct ftrace_rec),
+				 (uint32_t)(fbuf->curr_size /
+					    sizeof(struct ftrace_rec)),
+				 fbuf->cntfrq, fbuf->overhead,
+				 fbuf->rec_count, fbuf->rec_dropped);
+		assert(count < (int)sizeof(line));
+		copy_func(pctx, line, count);
+
+		/* The ring has wrapped if there are valid records after wr_off */
+		if (fbuf->curr_size > fbuf->wr_off)
+			copy_func(pctx, recs + fbuf->wr_off,
+				  fbuf->curr_size - fbuf->wr_off);
+		copy_func(pctx, recs, fbuf->wr_off);
 	}
 }
 
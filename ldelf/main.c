@@ -140,6 +140,8 @@ void ldelf(struct ldelf_arg *arg)
 	}
 	malloc_add_pool((void *)mpool_base, mpool_size);
 
+	ta_elf_plt_self_test();
+
 	/* Load the main binary and get a list of dependencies, if any. */
 	ta_elf_load_main(&arg->uuid, &arg->is_32bit, &arg->stack_ptr,
 			 &arg->flags);
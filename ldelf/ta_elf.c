@@ -393,6 +393,91 @@ static void save_soname(struct ta_elf *elf)
 	}
 }
 
+static void save_plt_info_from_segment(struct ta_elf *elf, unsigned int type,
+				       vaddr_t addr, size_t memsz)
+{
+	size_t dyn_entsize = 0;
+	size_t rel_entsize = 0;
+	size_t num_dyns = 0;
+	size_t n = 0;
+	unsigned int tag = 0;
+	size_t val = 0;
+	size_t jmprel_sz = 0;
+	size_t addrsz = 0;
+	bool aligned = false;
+
+	if (type != PT_DYNAMIC)
+		return;
+
+	if (elf->is_32bit) {
+		dyn_entsize = sizeof(Elf32_Dyn);
+		rel_entsize = sizeof(Elf32_Rel);
+		addrsz = 4;
+	} else {
+		dyn_entsize = sizeof(Elf64_Dyn);
+		rel_entsize = sizeof(Elf64_Rela);
+		addrsz = 8;
+	}
+
+	assert(!(memsz % dyn_entsize));
+	num_dyns = memsz / dyn_entsize;
+
+	for (n = 0; n < num_dyns; n++) {
+		read_dyn(elf, addr, n, &tag, &val);
+		if (tag == DT_PLTGOT)
+			elf->pltgot = val + elf->load_addr;
+		else if (tag == DT_JMPREL)
+			elf->jmprel = (void *)(val + elf->load_addr);
+		else if (tag == DT_PLTRELSZ)
+			jmprel_sz = val;
+		else if (tag == DT_FLAGS && (val & DF_BIND_NOW))
+			elf->bind_now = true;
+		else if (tag == DT_FLAGS_1 && (val & DF_1_BIND_NOW))
+			elf->bind_now = true;
+	}
+
+	/* The first three GOT entries are reserved for the dynamic linker */
+	if (elf->pltgot)
+		check_range(elf, "DT_PLTGOT", (void *)elf->pltgot, 3 * addrsz);
+
+	if (!elf->jmprel)
+		return;
+
+	if (elf->is_32bit)
+		aligned = IS_ALIGNED_WITH_TYPE(elf->jmprel, Elf32_Rel);
+	else
+		aligned = IS_ALIGNED_WITH_TYPE(elf->jmprel, Elf64_Rela);
+	if (!aligned || jmprel_sz % rel_entsize)
+		err(TEE_ERROR_BAD_FORMAT, "Bad DT_JMPREL/DT_PLTRELSZ");
+	check_range(elf, "DT_JMPREL", elf->jmprel, jmprel_sz);
+	elf->num_jmprels = jmprel_sz / rel_entsize;
+}
+
+/*
+ * Save the location of the PLT GOT and its relocations, needed by
+ * ta_elf_relocate() if the PLT slots are to be bound lazily.
+ */
+static void save_plt_info(struct ta_elf *elf)
+{
+	size_t n = 0;
+
+	if (elf->is_32bit) {
+		Elf32_Phdr *phdr = elf->phdr;
+
+		for (n = 0; n < elf->e_phnum; n++)
+			save_plt_info_from_segment(elf, phdr[n].p_type,
+						   phdr[n].p_vaddr,
+						   phdr[n].p_memsz);
+	} else {
+		Elf64_Phdr *phdr = elf->phdr;
+
+		for (n = 0; n < elf->e_phnum; n++)
+			save_plt_info_from_segment(elf, phdr[n].p_type,
+						   phdr[n].p_vaddr,
+						   phdr[n].p_memsz);
+	}
+}
+
 static void e32_save_symtab(struct ta_elf *elf, size_t tab_idx)
 {
 	Elf32_Shdr *shdr = elf->shdr;
@@ -472,6 +557,7 @@ static void save_symtab(struct ta_elf *elf)
 
 	save_hashtab(elf);
 	save_soname(elf);
+	save_plt_info(elf);
 }
 
 static void init_elf(struct ta_elf *elf)
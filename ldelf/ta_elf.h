@@ -31,6 +31,7 @@ struct ta_elf {
 	bool is_32bit;	/* Initialized from Elf32_Ehdr/Elf64_Ehdr */
 	bool is_legacy;
 	bool bti_enabled;
+	bool lazy_binding;
 
 	vaddr_t load_addr;
 	vaddr_t max_addr;
@@ -67,6 +68,13 @@ struct ta_elf {
 	/* DT_SONAME */
 	char *soname;
 
+	/* DT_PLTGOT, DT_JMPREL and DT_PLTRELSZ, used for lazy binding */
+	vaddr_t pltgot;
+	void *jmprel;
+	size_t num_jmprels;
+	/* DF_BIND_NOW in DT_FLAGS or DF_1_BIND_NOW in DT_FLAGS_1 */
+	bool bind_now;
+
 	struct segment_head segs;
 
 	vaddr_t exidx_start;
@@ -125,6 +133,13 @@ void ta_elf_load_main(const TEE_UUID *uuid, uint32_t *is_32bit, uint64_t *sp,
 void ta_elf_finalize_load_main(uint64_t *entry, uint64_t *load_addr);
 void ta_elf_load_dependency(struct ta_elf *elf, bool is_32bit);
 void ta_elf_relocate(struct ta_elf *elf);
+#if defined(ARM64) && defined(CFG_LDELF_SELF_TEST)
+void ta_elf_plt_self_test(void);
+#else
+static inline void ta_elf_plt_self_test(void)
+{
+}
+#endif
 void ta_elf_finalize_mappings(struct ta_elf *elf);
 
 void ta_elf_print_mappings(void *pctx, print_func_t print_func,
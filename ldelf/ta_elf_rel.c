@@ -11,6 +11,7 @@
 #include <elf_common.h>
 #include <string.h>
 #include <tee_api_types.h>
+#include <user_ta_header.h>
 #include <util.h>
 
 #include "sys.h"
@@ -571,6 +572,184 @@ static void e64_process_tlsdesc_rela(const Elf64_Sym *sym_tab, size_t num_syms,
 	e64_process_tls_tprel_rela(sym_tab, num_syms, str_tab, str_tab_size,
 				   rela, where + 1, elf);
 }
+
+/* Trampoline written in assembly, entered from PLT0 */
+void ta_elf_plt_resolve_a64(void);
+
+/*
+ * Resolves the symbol of the lazily bound PLT slot @slot of @elf and
+ * updates @slot with its address. Returns TEE_ERROR_ITEM_NOT_FOUND if
+ * the symbol can't be found in any module, @slot is then left unchanged.
+ * @name receives the name of the symbol once known.
+ */
+static TEE_Result e64_plt_resolve_slot(struct ta_elf *elf, Elf64_Addr *slot,
+				       const char **name)
+{
+	Elf64_Rela *rela = elf->jmprel;
+	vaddr_t offs = (vaddr_t)slot - elf->load_addr;
+	bool weak_undef = false;
+	TEE_Result res = TEE_SUCCESS;
+	vaddr_t val = 0;
+	size_t n = 0;
+
+	/*
+	 * The PLT GOT starts with three reserved entries followed by one
+	 * slot per DT_JMPREL relocation, normally in the same order. Fall
+	 * back to a search if that doesn't hold.
+	 */
+	n = slot - (Elf64_Addr *)elf->pltgot - 3;
+	if (n >= elf->num_jmprels || rela[n].r_offset != offs) {
+		for (n = 0; n < elf->num_jmprels; n++)
+			if (rela[n].r_offset == offs)
+				break;
+		if (n == elf->num_jmprels)
+			return TEE_ERROR_BAD_FORMAT;
+	}
+	n = confine_array_index(n, elf->num_jmprels);
+
+	if (ELF64_R_TYPE(rela[n].r_info) != R_AARCH64_JUMP_SLOT)
+		return TEE_ERROR_BAD_FORMAT;
+
+	e64_get_sym_name(elf->dynsymtab, elf->num_dynsyms, elf->dynstr,
+			 elf->dynstr_size, rela + n, name, &weak_undef);
+	res = ta_elf_resolve_sym(*name, &val, NULL, NULL);
+	if (res && !weak_undef)
+		return res;
+
+	*slot = val;
+	return TEE_SUCCESS;
+}
+
+/*
+ * Called from ta_elf_plt_resolve_a64() the first time a lazily bound PLT
+ * slot is used. Resolves the symbol and updates @slot so that following
+ * calls branch directly to the function.
+ *
+ * We're executing on behalf of the TA in the middle of one of its
+ * functions, the TA can't be resumed if the symbol can't be resolved so
+ * it's panicked instead of returning an error as during loading.
+ */
+vaddr_t ta_elf_plt_resolve(struct ta_elf *elf, Elf64_Addr *slot);
+vaddr_t ta_elf_plt_resolve(struct ta_elf *elf, Elf64_Addr *slot)
+{
+	const char *name = "?";
+	TEE_Result res = e64_plt_resolve_slot(elf, slot, &name);
+
+	if (res) {
+		EMSG("Lazy binding of symbol %s failed: %#"PRIx32, name, res);
+		panic();
+	}
+
+	return *slot;
+}
+
+static void e64_init_lazy_binding(struct ta_elf *elf)
+{
+	struct ta_elf *main_elf = TAILQ_FIRST(&main_elf_queue);
+	Elf64_Addr *got = (Elf64_Addr *)elf->pltgot;
+
+	if (!(main_elf->head->flags & TA_FLAG_LAZY_BINDING) ||
+	    elf->bind_now || !elf->pltgot || !elf->num_jmprels ||
+	    !elf->dynsymtab)
+		return;
+
+	/*
+	 * GOT[1] and GOT[2] are reserved for the dynamic linker. PLT0 loads
+	 * GOT[2] and branches there with &GOT[2] in x16.
+	 */
+	got[1] = (Elf64_Addr)elf;
+	got[2] = (Elf64_Addr)ta_elf_plt_resolve_a64;
+	elf->lazy_binding = true;
+}
+
+#ifdef CFG_LDELF_SELF_TEST
+/* Enters the trampoline as PLT0 does for @slot, see plt_resolve_a64.S */
+int ta_elf_plt_test_plt0(int arg, Elf64_Addr *slot, Elf64_Addr *got2);
+
+/* Bogus PLT0 address, never called as the slots are resolved first */
+#define PLT_TEST_PLT0		0x1000
+
+static int plt_test_func(int arg)
+{
+	return arg + 1;
+}
+
+/*
+ * Exercises lazy binding with a module made up of a GOT with two PLT
+ * slots, the first for a symbol defined by the module itself and the
+ * second for a symbol that isn't defined anywhere. The module is only
+ * on the list of loaded modules during the test.
+ */
+void ta_elf_plt_self_test(void)
+{
+	static const char dynstr[] = "\0plt_test_func\0plt_test_missing";
+	Elf64_Sym syms[3] = {
+		[1] = {
+			.st_name = 1,
+			.st_info = ELF64_ST_INFO(STB_GLOBAL, STT_FUNC),
+			.st_shndx = 1,
+			.st_value = (vaddr_t)plt_test_func,
+		},
+		[2] = {
+			.st_name = sizeof("plt_test_func") + 1,
+			.st_info = ELF64_ST_INFO(STB_GLOBAL, STT_FUNC),
+			.st_shndx = SHN_UNDEF,
+		},
+	};
+	/* DT_HASH: one bucket chaining symbol 2 and then symbol 1 */
+	uint32_t hashtab[] = { 1, 3, 2, 0, 0, 1 };
+	Elf64_Addr got[5] = { [3] = PLT_TEST_PLT0, [4] = PLT_TEST_PLT0 };
+	Elf64_Rela rela[2] = {
+		{
+			.r_offset = (vaddr_t)(got + 3),
+			.r_info = ELF64_R_INFO(1ULL, R_AARCH64_JUMP_SLOT),
+		},
+		{
+			.r_offset = (vaddr_t)(got + 4),
+			.r_info = ELF64_R_INFO(2ULL, R_AARCH64_JUMP_SLOT),
+		},
+	};
+	struct ta_elf elf = {
+		.max_addr = UINTPTR_MAX,
+		.dynsymtab = syms,
+		.num_dynsyms = ARRAY_SIZE(syms),
+		.dynstr = dynstr,
+		.dynstr_size = sizeof(dynstr),
+		.hashtab = hashtab,
+		.pltgot = (vaddr_t)got,
+		.jmprel = rela,
+		.num_jmprels = ARRAY_SIZE(rela),
+	};
+	TEE_Result res = TEE_SUCCESS;
+	const char *name = NULL;
+	int ret = 0;
+
+	got[1] = (Elf64_Addr)&elf;
+	got[2] = (Elf64_Addr)ta_elf_plt_resolve_a64;
+	TAILQ_INSERT_TAIL(&main_elf_queue, &elf, link);
+
+	/* First call resolves the slot, second call branches directly */
+	ret = ta_elf_plt_test_plt0(41, got + 3, got + 2);
+	if (ret != 42 || got[3] != (vaddr_t)plt_test_func)
+		err(TEE_ERROR_GENERIC, "PLT resolve: ret %d slot %#"PRIx64,
+		    ret, got[3]);
+	ret = ((int (*)(int))got[3])(1);
+	if (ret != 2)
+		err(TEE_ERROR_GENERIC, "PLT call: ret %d", ret);
+
+	/* An unresolved symbol must leave the slot as is */
+	res = e64_plt_resolve_slot(&elf, got + 4, &name);
+	if (res != TEE_ERROR_ITEM_NOT_FOUND || got[4] != PLT_TEST_PLT0)
+		err(TEE_ERROR_GENERIC, "PLT unresolved: res %#"PRIx32, res);
+
+	TAILQ_REMOVE(&main_elf_queue, &elf, link);
+	DMSG("Lazy binding self test passed");
+}
+#endif /*CFG_LDELF_SELF_TEST*/
+#else /*ARM64*/
+static void e64_init_lazy_binding(struct ta_elf *elf __unused)
+{
+}
 #endif /*ARM64*/
 
 static void e64_relocate(struct ta_elf *elf, unsigned int rel_sidx)
@@ -680,8 +859,18 @@ static void e64_relocate(struct ta_elf *elf, unsigned int rel_sidx)
 		case R_AARCH64_RELATIVE:
 			*where = rela->r_addend + elf->load_addr;
 			break;
-		case R_AARCH64_GLOB_DAT:
 		case R_AARCH64_JUMP_SLOT:
+			if (elf->lazy_binding) {
+				/*
+				 * The slot initially holds the unrelocated
+				 * address of PLT0, which will enter
+				 * ta_elf_plt_resolve_a64() on first call.
+				 */
+				*where += elf->load_addr;
+				break;
+			}
+			fallthrough;
+		case R_AARCH64_GLOB_DAT:
 			e64_process_dyn_rela(sym_tab, num_syms, str_tab,
 					     str_tab_size, rela, where);
 			break;
@@ -724,6 +913,10 @@ static void e64_relocate(struct ta_elf *elf, unsigned int rel_sidx)
 	}
 }
 #else /*ARM64 || RV64*/
+static void e64_init_lazy_binding(struct ta_elf *elf __unused)
+{
+}
+
 static void __noreturn e64_relocate(struct ta_elf *elf __unused,
 				    unsigned int rel_sidx __unused)
 {
@@ -744,6 +937,7 @@ void ta_elf_relocate(struct ta_elf *elf)
 	} else {
 		Elf64_Shdr *shdr = elf->shdr;
 
+		e64_init_lazy_binding(elf);
 		for (n = 0; n < elf->e_shnum; n++)
 			if (shdr[n].sh_type == SHT_RELA)
 				e64_relocate(elf, n);
@@ -6,9 +6,12 @@
 #ifndef __PTA_BENCHMARK_H
 #define __PTA_BENCHMARK_H
 
+#include <stdint.h>
+
 /*
  * Interface to the benchmark pseudo-TA, which is used for registering
- * timestamp buffers
+ * timestamp buffers and reading the latency statistics of the core
+ * tracepoints
  */
 
 #define BENCHMARK_UUID \
@@ -23,4 +26,74 @@
 #define BENCHMARK_CMD_GET_MEMREF		BENCHMARK_CMD(2)
 #define BENCHMARK_CMD_UNREGISTER		BENCHMARK_CMD(3)
 
+/*
+ * Enable or disable the tracepoints, enabling them resets the histograms
+ * and discards the recorded events.
+ *
+ * [in] value[0].a: 1 to enable, 0 to disable
+ */
+#define BENCHMARK_CMD_TP_ENABLE			BENCHMARK_CMD(4)
+
+/*
+ * Get the latency histograms of the tracepoints, aggregated over all CPUs
+ *
+ * [out] memref[0]: array of struct benchmark_tp_hist indexed by tracepoint
+ *		    ID, at least BENCHMARK_TP_COUNT entries
+ */
+#define BENCHMARK_CMD_TP_GET_HIST		BENCHMARK_CMD(5)
+
+/*
+ * Read and remove the recorded tracepoint events, oldest first per CPU
+ *
+ * [out] memref[0]: array of struct benchmark_tp_event, size updated with
+ *		    the number of bytes written
+ * [out] value[1].a: number of events overwritten before they could be read
+ */
+#define BENCHMARK_CMD_TP_READ_EVENTS		BENCHMARK_CMD(6)
+
+/*
+ * Tracepoint IDs, each tracepoint measures the time spent in a path:
+ * BENCHMARK_TP_STD_ENTRY	handling of a standard call from normal world
+ * BENCHMARK_TP_THREAD_ALLOC	allocation of a thread for a standard call
+ * BENCHMARK_TP_PARAM_MAP	mapping of the parameters of a standard call
+ * BENCHMARK_TP_TA_ENTRY	TA open session or invoke command entry point
+ * BENCHMARK_TP_RPC		RPC to normal world, other than storage
+ * BENCHMARK_TP_STORAGE_RPC	RPC to the REE FS or RPMB storage backends
+ * BENCHMARK_TP_CRYPTO_OP	crypto operation system call of a TA
+ */
+#define BENCHMARK_TP_STD_ENTRY		0
+#define BENCHMARK_TP_THREAD_ALLOC	1
+#define BENCHMARK_TP_PARAM_MAP		2
+#define BENCHMARK_TP_TA_ENTRY		3
+#define BENCHMARK_TP_RPC		4
+#define BENCHMARK_TP_STORAGE_RPC	5
+#define BENCHMARK_TP_CRYPTO_OP		6
+#define BENCHMARK_TP_COUNT		7
+
+/* Bucket n counts the durations in [2^n, 2^(n+1)) ns, bucket 0 also 0 ns */
+#define BENCHMARK_TP_HIST_BUCKETS	32
+
+struct benchmark_tp_hist {
+	uint64_t count;
+	uint64_t sum_ns;
+	uint64_t min_ns;
+	uint64_t max_ns;
+	uint64_t buckets[BENCHMARK_TP_HIST_BUCKETS];
+};
+
+/*
+ * @begin_ns:	time stamp of the beginning of the path
+ * @duration_ns: time spent in the path
+ * @session:	ID of the session the path belongs to, 0 if unknown
+ * @tp:		tracepoint ID
+ * @cpu:	CPU which recorded the event
+ */
+struct benchmark_tp_event {
+	uint64_t begin_ns;
+	uint64_t duration_ns;
+	uint32_t session;
+	uint16_t tp;
+	uint16_t cpu;
+};
+
 #endif /* __PTA_BENCHMARK_H */
@@ -9,6 +9,9 @@
 /*
  * Interface to the gprof pseudo-TA, which is used by libutee to control TA
  * profiling and forward data to tee-supplicant.
+ *
+ * With CFG_CORE_SAMPLING_PROFILER=y, normal world clients can also use it to
+ * control the system-wide sampling profiler.
  */
 
 #define PTA_GPROF_UUID { 0x2f6e0d48, 0xc574, 0x426d, { \
@@ -40,4 +43,41 @@
  */
 #define PTA_GPROF_STOP_PC_SAMPLING	2
 
+/*
+ * Start system-wide sampling of the OP-TEE core and user TAs, discarding
+ * the samples not read yet. Only available to normal world clients.
+ *
+ * [in] value[0].a: maximum number of call stack entries per sample,
+ *                  including the PC (1..16)
+ */
+#define PTA_GPROF_START_SYS_SAMPLING	3
+
+/*
+ * Stop system-wide sampling. The samples taken so far can still be read.
+ * Only available to normal world clients.
+ */
+#define PTA_GPROF_STOP_SYS_SAMPLING	4
+
+/*
+ * Read and remove pending system-wide samples. Only available to normal
+ * world clients.
+ *
+ * The buffer is filled with a stream of 64-bit aligned perf records in the
+ * native endianness, as found in the data section of a perf.data file:
+ * - PERF_RECORD_SAMPLE, for an event with sample_type PERF_SAMPLE_IP |
+ *   PERF_SAMPLE_TID | PERF_SAMPLE_TIME | PERF_SAMPLE_CPU |
+ *   PERF_SAMPLE_CALLCHAIN. The misc field tells whether the sample hit
+ *   the core (PERF_RECORD_MISC_KERNEL) or a TA (PERF_RECORD_MISC_USER).
+ *   pid is the first field (timeLow) of the UUID of the current user TA,
+ *   or 0, tid is the OP-TEE thread index and time is in nanoseconds.
+ * - PERF_RECORD_LOST, when samples were dropped because the per-CPU buffer
+ *   was full.
+ *
+ * [out] memref[0]: records, size updated with the number of bytes written,
+ *                  0 when there is nothing to read. TEE_ERROR_SHORT_BUFFER
+ *                  is returned with the needed size if the buffer is too
+ *                  small for the next record.
+ */
+#define PTA_GPROF_READ_SYS_SAMPLES	5
+
 #endif /* __PTA_GPROF_H */
@@ -63,9 +63,25 @@
  * [in]  value[0].b	delay number
  * [out] value[1].a	before lock concurency
  * [out] value[1].b	during lock concurency
+ *
+ * PTA_MUTEX_TEST_CONTENDED is a benchmark to invoke from several threads
+ * at the same time, with a multi-core normal world:
+ * [in]  value[0].b	Number of times the mutex is taken
+ * [out] value[1].a	Elapsed time in milliseconds
+ * [out] value[1].b	Maximum number of threads seen waiting for the mutex
+ *
+ * PTA_MUTEX_TEST_READ_MOSTLY looks up entries of a small registry, once
+ * protected by a struct percpu_rwlock and once by a read locked mutex.
+ * Invoked from one thread, then from as many threads as there are cores,
+ * it shows how the lookups scale with the number of cores:
+ * [in]  value[0].b	Number of lookups with each lock
+ * [out] value[1].a	Elapsed time in milliseconds, struct percpu_rwlock
+ * [out] value[1].b	Elapsed time in milliseconds, mutex_read_lock()
  */
 #define PTA_MUTEX_TEST_WRITER			0
 #define PTA_MUTEX_TEST_READER			1
+#define PTA_MUTEX_TEST_CONTENDED		2
+#define PTA_MUTEX_TEST_READ_MOSTLY		3
 #define PTA_INVOKE_TESTS_CMD_MUTEX		7
 
 /*
@@ -108,5 +124,64 @@
  */
 #define PTA_INVOKE_TESTS_CMD_DT_DRIVER_TESTS	11
 
+/*
+ * Stream data through a batch of socket operations and a loopback
+ * stand-in for tee-supplicant, compare the number of transfers to normal
+ * world per MiB with and without batching
+ *
+ * [out]    value[0].a	Transfers per MiB, one operation per transfer
+ * [out]    value[0].b	Transfers per MiB, batched operations
+ * [out]    value[1].a	Throughput with batched operations in KiB/s
+ */
+#define PTA_INVOKE_TESTS_CMD_SOCKET_BATCH	12
+
+/*
+ * Decompress the compressed early TAs, to compare the image size and the
+ * decompression time of the formats selectable at build time, see
+ * CFG_EMBEDDED_TS_COMPRESS_LZ4
+ *
+ * [in]     value[0].a	Number of times each early TA is decompressed
+ * [out]    value[1].a	Total size of the compressed early TAs
+ * [out]    value[1].b	Total size of the early TAs once decompressed
+ * [out]    value[2].a	Decompression throughput in KiB/s of output
+ * [out]    value[2].b	Compression format, 0: DEFLATE, 1: LZ4
+ */
+#define PTA_INVOKE_TESTS_CMD_EMB_TS_PERF	13
+
+/*
+ * Read one word per page of a buffer of the calling TA with a large
+ * stride, to compare the cost of TLB misses with and without
+ * CFG_CORE_MMU_USER_CONTIG_HINT. The buffer is read through the user
+ * mapping so the command is only available to user TAs.
+ *
+ * [in]     value[0].a	Low 32 bits of the address of the buffer
+ * [in]     value[0].b	High 32 bits of the address of the buffer
+ * [in]     value[1].a	Size of the buffer, at least one small page
+ * [in]     value[1].b	Number of passes over the buffer
+ * [out]    value[2].a	Elapsed time in ms
+ * [out]    value[2].b	Number of pages read per pass
+ */
+#define PTA_INVOKE_TESTS_CMD_TLB_PERF		14
+
+/*
+ * Encrypt data with a number of jobs through the crypto job queue, check
+ * the results against the synchronous cipher API and compare the time
+ * taken by both, see CFG_CRYPTO_DRV_JOB_SW
+ *
+ * [in]     value[0].a	Number of jobs, at most 32
+ * [out]    value[1].a	Time in ms with the synchronous cipher API
+ * [out]    value[1].b	Time in ms through the job queue
+ * [out]    value[2].a	Number of batches passed to the backend
+ * [out]    value[2].b	Maximum number of jobs waiting for a slot
+ */
+#define PTA_INVOKE_TESTS_CMD_DRVCRYPT_JOB	15
+
+/*
+ * Tests that the REE FS transactions commit or drop the updates of an
+ * object, including through a handle left open when the transaction ends,
+ * and that aborting the creation of an object leaves its handle dead
+ */
+#define PTA_INVOKE_TESTS_CMD_FS_TRANS		16
+
 #endif /*__PTA_INVOKE_TESTS_H*/
 
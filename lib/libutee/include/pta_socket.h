@@ -6,6 +6,8 @@
 #ifndef __PTA_SOCKET
 #define __PTA_SOCKET
 
+#include <stdint.h>
+
 #define PTA_SOCKET_UUID { 0x3b996a7d, 0x2c2b, 0x4a49, { \
 			  0xa8, 0x96, 0xe1, 0xfb, 0x57, 0x66, 0xd2, 0xf4 } }
 
@@ -48,4 +50,42 @@
  */
 #define PTA_SOCKET_IOCTL	5
 
+/*
+ * Run a batch of send and receive operations with a single request to
+ * normal world
+ *
+ * The batch is a sequence of operations, each made of a struct
+ * pta_socket_batch_op followed by a payload of @len bytes padded to a
+ * multiple of 8 bytes. The operations are processed in order, each with
+ * the timeout of the batch.
+ *
+ * For a PTA_SOCKET_SEND operation the payload holds the data to transmit,
+ * for a PTA_SOCKET_RECV operation it receives the data. On return @len
+ * holds the number of bytes transmitted or received and @res the result
+ * of the operation.
+ *
+ * The batch goes through the buffer allocated with
+ * PTA_SOCKET_BATCH_BUF_ALLOC if it is large enough, else through a
+ * temporary buffer.
+ *
+ * [in]		value[0].b	timeout ms or TEE_TIMEOUT_INFINITE
+ * [in/out]	memref[1]	operations
+ */
+#define PTA_SOCKET_BATCH	6
+
+/*
+ * Allocate a buffer shared with normal world for the batches of the
+ * session, kept until the session is closed. A size of 0 frees the buffer.
+ *
+ * [in]		value[0].a	size of the buffer
+ */
+#define PTA_SOCKET_BATCH_BUF_ALLOC	7
+
+struct pta_socket_batch_op {
+	uint32_t cmd;		/* PTA_SOCKET_SEND or PTA_SOCKET_RECV */
+	uint32_t handle;	/* Socket handle */
+	uint32_t len;		/* Payload length */
+	uint32_t res;		/* Result of the operation */
+};
+
 #endif /*__PTA_SOCKET*/
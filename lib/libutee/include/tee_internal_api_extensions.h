@@ -78,4 +78,46 @@ TEE_Result tee_invoke_supp_plugin(const TEE_UUID *uuid, uint32_t cmd,
 				  uint32_t sub_cmd, void *buf, size_t len,
 				  size_t *outlen);
 
+/*
+ * tee_storage_trans_begin() - start a persistent object transaction
+ * @storage_id:	TEE_STORAGE_PRIVATE* storage of the transaction
+ *
+ * Until the transaction is committed or aborted the creations, writes,
+ * truncations, renames and deletions of the persistent objects of the TA
+ * in @storage_id are only visible to the TA. They are committed to storage
+ * all together by tee_storage_trans_commit() and dropped by
+ * tee_storage_trans_abort() or if the TA terminates. The storage
+ * operations of other TA instances wait until the transaction ends, or
+ * fail with TEE_ERROR_STORAGE_NOT_AVAILABLE if it doesn't end soon
+ * enough, so it should be kept short.
+ *
+ * Return TEE_SUCCESS on success, TEE_ERROR_NOT_SUPPORTED if @storage_id
+ * has no transaction support, TEE_ERROR_BAD_STATE if the TA already has a
+ * transaction or TEE_ERRROR_* on failure.
+ */
+TEE_Result tee_storage_trans_begin(uint32_t storage_id);
+
+/*
+ * tee_storage_trans_commit() - commit the persistent object transaction
+ *
+ * The transaction ends whatever the result, on failure none of its
+ * changes are committed.
+ *
+ * Return TEE_SUCCESS on success, TEE_ERROR_BAD_STATE if there's no
+ * transaction or if it already failed, or TEE_ERRROR_* on failure.
+ */
+TEE_Result tee_storage_trans_commit(void);
+
+/*
+ * tee_storage_trans_abort() - drop the persistent object transaction
+ *
+ * Objects still open keep the content they had when the transaction
+ * started. If that content can't be restored the object can only be
+ * closed.
+ *
+ * Return TEE_SUCCESS on success or TEE_ERROR_BAD_STATE if there's no
+ * transaction.
+ */
+TEE_Result tee_storage_trans_abort(void);
+
 #endif
@@ -34,8 +34,14 @@
 	/* See also "gpd.ta.doesNotCloseHandleOnCorruptObject" */
 #define TA_FLAG_DONT_CLOSE_HANDLE_ON_CORRUPT_OBJECT \
 					BIT32(11)
+	/*
+	 * Let ldelf bind PLT slots lazily, that is, resolve an imported
+	 * function on first call instead of when the TA is loaded. Only
+	 * supported for AArch64 TAs, ignored otherwise.
+	 */
+#define TA_FLAG_LAZY_BINDING		BIT32(12)
 
-#define TA_FLAGS_MASK			GENMASK_32(10, 0)
+#define TA_FLAGS_MASK			GENMASK_32(12, 0)
 
 struct ta_head {
 	TEE_UUID uuid;
@@ -60,17 +66,47 @@ struct __ftrace_info {
 	union compat_ptr ret_ptr;
 };
 
+/*
+ * Function graph record, written for each function entry and exit and
+ * decoded on the host by scripts/ftrace_decode.py
+ * @pc_lo:	Bits 31..0 of the function address
+ * @pc_hi:	Bits 55..32 of the function address in bits 23..0, call depth
+ *		in bits 29..24 and FTRACE_REC_* flags in bits 31..30
+ * @delta:	Counter ticks since the previous record
+ *
+ * A delta which doesn't fit in 32 bits is stored in a FTRACE_REC_TIME
+ * record where @pc_lo holds bits 63..32 and @delta bits 31..0, the delta
+ * of the record that follows is then 0.
+ */
+struct ftrace_rec {
+	uint32_t pc_lo;
+	uint32_t pc_hi;
+	uint32_t delta;
+};
+
+#define FTRACE_REC_EXIT			BIT32(31)
+#define FTRACE_REC_TIME			BIT32(30)
+#define FTRACE_REC_DEPTH_SHIFT		24
+#define FTRACE_REC_DEPTH_MASK		GENMASK_32(29, 24)
+#define FTRACE_REC_PC_HI_MASK		GENMASK_32(23, 0)
+
 struct ftrace_buf {
 	uint64_t ret_func_ptr;	/* __ftrace_return pointer */
 	uint64_t ret_stack[FTRACE_RETFUNC_DEPTH]; /* Return stack */
 	uint32_t ret_idx;	/* Return stack index */
 	uint32_t lr_idx;	/* lr index used for stack unwinding */
-	uint64_t begin_time[FTRACE_RETFUNC_DEPTH]; /* Timestamp */
+	uint64_t last_time;	/* Timestamp when the last record was done */
 	uint64_t suspend_time;	/* Suspend timestamp */
-	uint32_t curr_size;	/* Size of ftrace buffer */
+	uint64_t overhead;	/* Counter ticks spent adding records */
+	uint64_t rec_count;	/* Number of records written, including
+				 * the ones overwritten since */
+	uint64_t rec_dropped;	/* Number of records not written */
+	uint32_t cntfrq;	/* Counter frequency */
+	uint32_t curr_size;	/* Size of valid records in ftrace buffer */
 	uint32_t max_size;	/* Max allowed size of ftrace buffer */
 	uint32_t head_off;	/* Ftrace buffer header offset */
 	uint32_t buf_off;	/* Ftrace buffer offset */
+	uint32_t wr_off;	/* Offset of next record relative to buf_off */
 	bool syscall_trace_enabled; /* Some syscalls are never traced */
 	bool syscall_trace_suspended; /* By foreign interrupt or RPC */
 };
@@ -223,6 +223,11 @@ TEE_Result _utee_storage_obj_seek(unsigned long obj, int32_t offset,
 /* op is of type enum _utee_cache_operation */
 TEE_Result _utee_cache_operation(void *va, size_t l, unsigned long op);
 
+TEE_Result _utee_storage_trans_begin(unsigned long storage_id);
+
+/* commit is 0 to abort the transaction */
+TEE_Result _utee_storage_trans_end(unsigned long commit);
+
 TEE_Result _utee_gprof_send(void *buf, size_t size, uint32_t *id);
 
 #endif /* UTEE_SYSCALLS_H */
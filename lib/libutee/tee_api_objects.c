@@ -6,6 +6,7 @@
 #include <string.h>
 
 #include <tee_api.h>
+#include <tee_internal_api_extensions.h>
 #include <utee_syscalls.h>
 #include "tee_api_private.h"
 
@@ -1052,3 +1053,18 @@ TEE_Result __GP11_TEE_SeekObjectData(TEE_ObjectHandle object, int32_t offset,
 {
 	return TEE_SeekObjectData(object, offset, whence);
 }
+
+TEE_Result tee_storage_trans_begin(uint32_t storage_id)
+{
+	return _utee_storage_trans_begin(storage_id);
+}
+
+TEE_Result tee_storage_trans_commit(void)
+{
+	return _utee_storage_trans_end(true);
+}
+
+TEE_Result tee_storage_trans_abort(void)
+{
+	return _utee_storage_trans_end(false);
+}
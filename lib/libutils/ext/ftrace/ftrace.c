@@ -11,6 +11,7 @@
  */
 
 #include <assert.h>
+#include <config.h>
 #include <user_ta_header.h>
 #if defined(__KERNEL__)
 #include <arm.h>
@@ -25,13 +26,6 @@
 #endif
 #include "ftrace.h"
 
-#define DURATION_MAX_LEN		16
-#define ENTRY_SIZE(idx)			(DURATION_MAX_LEN + (idx) + \
-					 (2 * sizeof(unsigned long)) + 8)
-#define EXIT_SIZE(idx)			(DURATION_MAX_LEN + (idx) + 3)
-
-static const char hex_str[] = "0123456789abcdef";
-
 static __noprof struct ftrace_buf *get_fbuf(void)
 {
 #if defined(__KERNEL__)
@@ -62,112 +56,103 @@ static __noprof struct ftrace_buf *get_fbuf(void)
 #endif
 }
 
-#if defined(_CFG_FTRACE_BUF_WHEN_FULL_shift)
-
 /*
- * This API shifts/moves ftrace buffer to create space for new dump
- * in case the buffer size falls short of actual dump.
+ * Returns where to store the next record or NULL if the buffer is full.
+ * The buffer is a ring where the oldest records are overwritten, unless
+ * CFG_FTRACE_BUF_WHEN_FULL=stop in which case recording stops instead.
  */
-static bool __noprof fbuf_make_room(struct ftrace_buf *fbuf, size_t size)
+static __noprof struct ftrace_rec *fbuf_next_rec(struct ftrace_buf *fbuf)
 {
-	char *dst = (char *)fbuf + fbuf->buf_off;
-	const char *src = (char *)fbuf + fbuf->buf_off + size;
-	size_t n = 0;
+	size_t rec_size = sizeof(struct ftrace_rec);
+	struct ftrace_rec *rec = NULL;
+
+	if (fbuf->wr_off + rec_size > fbuf->max_size) {
+		if (IS_ENABLED2(_CFG_FTRACE_BUF_WHEN_FULL_stop) ||
+		    rec_size > fbuf->max_size) {
+			fbuf->rec_dropped++;
+			return NULL;
+		}
+		fbuf->wr_off = 0;
+	}
 
-	fbuf->curr_size -= size;
+	fbuf->rec_count++;
 
-	for (n = 0; n < fbuf->curr_size; n++)
-		dst[n] = src[n];
+	rec = (void *)((char *)fbuf + fbuf->buf_off + fbuf->wr_off);
+	fbuf->wr_off += rec_size;
+	if (fbuf->curr_size < fbuf->wr_off)
+		fbuf->curr_size = fbuf->wr_off;
 
-	return true;
+	return rec;
 }
 
-#elif defined(_CFG_FTRACE_BUF_WHEN_FULL_wrap)
-
-/* Makes room in the trace buffer by discarding the previously recorded data. */
-static bool __noprof fbuf_make_room(struct ftrace_buf *fbuf,
-				    size_t size)
+/* Returns false if the record was dropped */
+static bool __noprof fbuf_add_rec(struct ftrace_buf *fbuf, unsigned long pc,
+				  uint32_t flags, uint64_t now)
 {
-	if (fbuf->buf_off + size > fbuf->max_size)
-		return false;
+	struct ftrace_rec *rec = NULL;
+	uint64_t delta = 0;
+
+	if (!fbuf->last_time)
+		fbuf->last_time = now;
+	if (now > fbuf->last_time)
+		delta = now - fbuf->last_time;
+
+	if (delta > UINT32_MAX) {
+		rec = fbuf_next_rec(fbuf);
+		if (!rec)
+			return false;
+		rec->pc_lo = delta >> 32;
+		rec->pc_hi = FTRACE_REC_TIME;
+		rec->delta = delta;
+		delta = 0;
+	}
 
-	fbuf->curr_size = 0;
+	rec = fbuf_next_rec(fbuf);
+	if (!rec)
+		return false;
+	rec->pc_lo = pc;
+	rec->pc_hi = ((uint64_t)pc >> 32) & FTRACE_REC_PC_HI_MASK;
+	rec->pc_hi |= SHIFT_U32(fbuf->ret_idx, FTRACE_REC_DEPTH_SHIFT) | flags;
+	rec->delta = delta;
 
 	return true;
 }
 
-#elif defined(_CFG_FTRACE_BUF_WHEN_FULL_stop)
-
-static bool __noprof fbuf_make_room(struct ftrace_buf *fbuf __unused,
-				    size_t size __unused)
+/*
+ * Time spent in the tracer is kept out of the deltas and accounted
+ * separately so the host can report the per record overhead. Calls where
+ * the record was dropped aren't accounted as the overhead is divided by
+ * the number of records written.
+ */
+static void __noprof fbuf_done(struct ftrace_buf *fbuf, uint64_t start,
+			       bool written)
 {
-	return false;
-}
-
-#else
-#error CFG_FTRACE_BUF_WHEN_FULL value not supported
-#endif
+	uint64_t now = barrier_read_counter_timer();
 
-static size_t __noprof to_func_enter_fmt(char *buf, uint32_t ret_idx,
-					 unsigned long pc)
-{
-	char *str = buf;
-	uint32_t addr_size = 2 * sizeof(unsigned long);
-	uint32_t i = 0;
-
-	for (i = 0; i < (DURATION_MAX_LEN + ret_idx); i++)
-		if (i == (DURATION_MAX_LEN - 2))
-			*str++ = '|';
-		else
-			*str++ = ' ';
-
-	*str++ = '0';
-	*str++ = 'x';
-
-	for (i = 0; i < addr_size; i++)
-		*str++ = hex_str[(pc >> 4 * (addr_size - i - 1)) & 0xf];
-
-	*str++ = '(';
-	*str++ = ')';
-	*str++ = ' ';
-	*str++ = '{';
-	*str++ = '\n';
-	*str = '\0';
-
-	return str - buf;
+	if (written)
+		fbuf->overhead += now - start;
+	fbuf->last_time = now;
 }
 
 void __noprof ftrace_enter(unsigned long pc, unsigned long *lr)
 {
 	struct ftrace_buf *fbuf = NULL;
-	size_t line_size = 0;
-	bool full = false;
+	bool written = false;
+	uint64_t now = 0;
 
 	fbuf = get_fbuf();
 
 	if (!fbuf || !fbuf->buf_off || !fbuf->max_size)
 		return;
 
-	line_size = ENTRY_SIZE(fbuf->ret_idx);
+	now = barrier_read_counter_timer();
 
-	/*
-	 * Check if we have enough space in ftrace buffer. If not then try to
-	 * make room.
-	 */
-	full = (fbuf->curr_size + line_size) > fbuf->max_size;
-	if (full)
-		full = !fbuf_make_room(fbuf, line_size);
-
-	if (!full)
-		fbuf->curr_size += to_func_enter_fmt((char *)fbuf +
-						     fbuf->buf_off +
-						     fbuf->curr_size,
-						     fbuf->ret_idx,
-						     pc);
+	COMPILE_TIME_ASSERT(FTRACE_RETFUNC_DEPTH <=
+			    (FTRACE_REC_DEPTH_MASK >> FTRACE_REC_DEPTH_SHIFT));
+	written = fbuf_add_rec(fbuf, pc, 0, now);
 
 	if (fbuf->ret_idx < FTRACE_RETFUNC_DEPTH) {
 		fbuf->ret_stack[fbuf->ret_idx] = *lr;
-		fbuf->begin_time[fbuf->ret_idx] = barrier_read_counter_timer();
 		fbuf->ret_idx++;
 	} else {
 		/*
@@ -182,70 +167,15 @@ void __noprof ftrace_enter(unsigned long pc, unsigned long *lr)
 	}
 
 	*lr = (unsigned long)&__ftrace_return;
-}
 
-static void __noprof ftrace_duration(char *buf, uint64_t start, uint64_t end)
-{
-	uint32_t max_us = CFG_FTRACE_US_MS;
-	uint32_t cntfrq = read_cntfrq();
-	uint64_t ticks = end - start;
-	uint32_t ms = 0;
-	uint32_t us = 0;
-	uint32_t ns = 0;
-	uint32_t frac = 0;
-	uint32_t in = 0;
-	char unit = 'u';
-	int i = 0;
-
-	ticks = ticks * 1000000000 / cntfrq;
-	us = ticks / 1000;
-	ns = ticks % 1000;
-
-	if (max_us && us >= max_us) {
-		/* Display value in milliseconds */
-		unit = 'm';
-		ms = us / 1000;
-		us = us % 1000;
-		frac = us;
-		in = ms;
-	} else {
-		/* Display value in microseconds */
-		frac = ns;
-		in = us;
-	}
-
-	*buf-- = 's';
-	*buf-- = unit;
-	*buf-- = ' ';
-
-	COMPILE_TIME_ASSERT(DURATION_MAX_LEN == 16);
-	if (in > 999999) {
-		/* Not enough space to print the value */
-		for (i = 0; i < 10; i++)
-			*buf-- = '-';
-		return;
-	}
-
-	for (i = 0; i < 3; i++) {
-		*buf-- = hex_str[frac % 10];
-		frac /= 10;
-	}
-
-	*buf-- = '.';
-
-	while (in) {
-		*buf-- = hex_str[in % 10];
-		in /= 10;
-	}
+	fbuf_done(fbuf, now, written);
 }
 
 unsigned long __noprof ftrace_return(void)
 {
 	struct ftrace_buf *fbuf = NULL;
-	char *line = NULL;
-	size_t line_size = 0;
-	char *dur_loc = NULL;
-	uint32_t i = 0;
+	bool written = false;
+	uint64_t now = 0;
 
 	fbuf = get_fbuf();
 
@@ -255,63 +185,10 @@ unsigned long __noprof ftrace_return(void)
 	else
 		return 0;
 
-	/*
-	 * Check if we have a minimum ftrace buffer current size. If we have
-	 * somehow corrupted ftrace buffer formatting, the function call chain
-	 * shouldn't get broken since we have a valid fbuf->ret_idx at this
-	 * point which can retrieve correct return pointer from fbuf->ret_stack.
-	 */
-	line_size = ENTRY_SIZE(fbuf->ret_idx);
-	if (fbuf->curr_size < line_size)
-		goto out;
-
-	line = (char *)fbuf + fbuf->buf_off + fbuf->curr_size - line_size;
-
-	/*
-	 * Check for '{' symbol as it represents if it is an exit from current
-	 * or nested function. If exit is from current function, than exit dump
-	 * via ';' symbol else exit dump via '}' symbol.
-	 */
-	if (line[line_size - 2] == '{') {
-		line[line_size - 3] = ';';
-		line[line_size - 2] = '\n';
-		line[line_size - 1] = '\0';
-		fbuf->curr_size -= 1;
-
-		dur_loc = &line[DURATION_MAX_LEN - 3];
-		ftrace_duration(dur_loc, fbuf->begin_time[fbuf->ret_idx],
-				barrier_read_counter_timer());
-	} else {
-		bool full = false;
-
-		line_size = EXIT_SIZE(fbuf->ret_idx);
-		full = (fbuf->curr_size + line_size) > fbuf->max_size;
-		if (full)
-			full = !fbuf_make_room(fbuf, line_size);
-
-		if (!full) {
-			line = (char *)fbuf + fbuf->buf_off + fbuf->curr_size;
+	now = barrier_read_counter_timer();
+	written = fbuf_add_rec(fbuf, 0, FTRACE_REC_EXIT, now);
+	fbuf_done(fbuf, now, written);
 
-			for (i = 0; i < DURATION_MAX_LEN + fbuf->ret_idx; i++) {
-				if (i == (DURATION_MAX_LEN - 2))
-					line[i] = '|';
-				else
-					line[i] = ' ';
-			}
-
-			line[i] = '}';
-			line[i + 1] = '\n';
-			line[i + 2] = '\0';
-
-			fbuf->curr_size += line_size - 1;
-
-			dur_loc = &line[DURATION_MAX_LEN - 4];
-			ftrace_duration(dur_loc,
-					fbuf->begin_time[fbuf->ret_idx],
-					barrier_read_counter_timer());
-		}
-	}
-out:
 	return fbuf->ret_stack[fbuf->ret_idx];
 }
 
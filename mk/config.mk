@@ -80,6 +80,18 @@ CFG_TEE_TA_LOG_LEVEL ?= 1
 # CFG_TEE_TA_LOG_LEVEL. Otherwise, they are not output at all
 CFG_TEE_CORE_TA_TRACE ?= y
 
+# If y, once normal world has started the asynchronous notifications the
+# core messages are stored in a per-CPU ring buffer instead of being written
+# to the secure console by the CPU logging them. The buffered messages are
+# printed, oldest first and prefixed with the counter timer value, by the
+# bottom half requested when a standard call returns to the normal world,
+# and before a panic message. A CPU logging while its ring is full drops the
+# message, the number of dropped messages is printed with the other ones.
+# CFG_CORE_ASYNC_TRACE_RING_SIZE is the size in bytes of each ring, it must
+# be a power of two. Requires CFG_CORE_ASYNC_NOTIF.
+CFG_CORE_ASYNC_TRACE ?= n
+CFG_CORE_ASYNC_TRACE_RING_SIZE ?= 4096
+
 # If y, enable the memory leak detection feature in the bget memory allocator.
 # When this feature is enabled, calling mdbg_check(1) will print a list of all
 # the currently allocated buffers and the location of the allocation (file and
@@ -106,6 +118,21 @@ CFG_MSG_LONG_PREFIX_MASK ?= 0x1a
 # Number of threads
 CFG_NUM_THREADS ?= 2
 
+# CFG_CORE_THREAD_POOL, when enabled, only gives a permanent stack to the
+# first CFG_CORE_THREAD_POOL_MIN threads. The other threads, up to
+# CFG_NUM_THREADS, get a stack from the core heap when a standard call
+# needs them and give it back when they become free while
+# CFG_CORE_THREAD_POOL_MIN threads with a stack are already idle.
+# CFG_CORE_HEAP_SIZE must leave room for these stacks. With CFG_WITH_PAGER
+# the thread stacks are already paged in on demand.
+CFG_CORE_THREAD_POOL ?= n
+CFG_CORE_THREAD_POOL_MIN ?= 2
+ifeq ($(CFG_CORE_THREAD_POOL),y)
+ifeq ($(call cfg-one-enabled,CFG_WITH_PAGER CFG_NS_VIRTUALIZATION),y)
+$(error CFG_CORE_THREAD_POOL is incompatible with CFG_WITH_PAGER and CFG_NS_VIRTUALIZATION)
+endif
+endif
+
 # API implementation version
 CFG_TEE_API_VERSION ?= GPD-1.1-dev
 
@@ -156,6 +183,12 @@ CFG_RPMB_FS ?= n
 CFG_REE_FS_INTEGRITY_RPMB ?= $(CFG_RPMB_FS)
 $(eval $(call cfg-depends-all,CFG_REE_FS_INTEGRITY_RPMB,CFG_RPMB_FS))
 
+# Cache the information of the objects in the REE FS (type, sizes, usage) in
+# an index file covered by the hash of dirf.db. Enumerating the objects of a
+# TA then only scans the index instead of opening each object.
+CFG_REE_FS_ENUM_INFO ?= $(CFG_REE_FS)
+$(eval $(call cfg-depends-all,CFG_REE_FS_ENUM_INFO,CFG_REE_FS))
+
 # Device identifier used when CFG_RPMB_FS = y.
 # The exact meaning of this value is platform-dependent. On Linux, the
 # tee-supplicant process will open /dev/mmcblk<id>rpmb
@@ -403,9 +436,18 @@ ifeq ($(CFG_SECURE_PARTITION),y)
 $(call force,CFG_EMBEDDED_TS,y)
 endif
 
+# If y, the early TAs and secure partitions embedded in the TEE binary are
+# compressed with LZ4 instead of DEFLATE. The images are larger but
+# decompress several times faster, see PTA_INVOKE_TESTS_CMD_EMB_TS_PERF.
+CFG_EMBEDDED_TS_COMPRESS_LZ4 ?= n
+
 ifeq ($(CFG_EMBEDDED_TS),y)
+ifeq ($(CFG_EMBEDDED_TS_COMPRESS_LZ4),y)
+$(call force,CFG_LZ4,y)
+else
 $(call force,CFG_ZLIB,y)
 endif
+endif
 
 # By default the early TAs are compressed in the TEE binary, it is possible to
 # not compress them with CFG_EARLY_TA_COMPRESS=n
@@ -414,6 +456,14 @@ CFG_EARLY_TA_COMPRESS ?= y
 # Enable paging, requires SRAM, can't be enabled by default
 CFG_WITH_PAGER ?= n
 
+# With CFG_WITH_PAGER=y, the hashes of all the pages of the pageable area are
+# checked at boot on the primary CPU. If CFG_CORE_PAGER_LAZY_VERIFY=y only
+# the init part, which executes directly from where it is loaded, is checked
+# at boot. The other pages are checked by the pager when they are first
+# paged in, as is already done each time a page is paged in, so a corrupted
+# page causes a panic when it is used instead of at boot.
+CFG_CORE_PAGER_LAZY_VERIFY ?= n
+
 # Use the pager for user TAs
 CFG_PAGED_USER_TA ?= $(CFG_WITH_PAGER)
 
@@ -421,6 +471,16 @@ CFG_PAGED_USER_TA ?= $(CFG_WITH_PAGER)
 # TAG and IV in order to reduce heap usage.
 CFG_CORE_PAGE_TAG_AND_IV ?= $(CFG_PAGED_USER_TA)
 
+# With CFG_WITH_PAGER=y, evicted R/W pages are compressed with LZ4 before
+# being encrypted if that saves at least a quarter of the page, reducing
+# the amount of data to encrypt and decrypt. Pages that are all zeroes are
+# never encrypted nor stored, whatever this setting.
+CFG_CORE_PAGER_RW_COMPRESS ?= n
+
+ifeq ($(CFG_CORE_PAGER_RW_COMPRESS),y)
+$(call force,CFG_LZ4,y)
+endif
+
 # Runtime lock dependency checker: ensures that a proper locking hierarchy is
 # used in the TEE core when acquiring and releasing mutexes. Any violation will
 # cause a panic as soon as the invalid locking condition is detected. If
@@ -431,6 +491,12 @@ CFG_CORE_PAGE_TAG_AND_IV ?= $(CFG_PAGED_USER_TA)
 CFG_LOCKDEP ?= n
 CFG_LOCKDEP_RECORD_STACK ?= y
 
+# A thread trying to take a mutex write locked by a thread executing on
+# another core busy waits for up to CFG_CORE_MUTEX_SPIN_LOOPS checks of
+# the mutex before going to sleep, which is a round trip to normal world.
+# 0 disables spinning.
+CFG_CORE_MUTEX_SPIN_LOOPS ?= 1000
+
 # BestFit algorithm in bget reduces the fragmentation of the heap when running
 # with the pager enabled or lockdep
 CFG_CORE_BGET_BESTFIT ?= $(call cfg-one-enabled, CFG_WITH_PAGER CFG_LOCKDEP)
@@ -522,6 +588,10 @@ CFG_ENABLE_EMBEDDED_TESTS ?= n
 # Enable core self tests and related pseudo TAs
 CFG_TEE_CORE_EMBED_INTERNAL_TESTS ?= $(CFG_ENABLE_EMBEDDED_TESTS)
 
+# Exercises lazy binding of PLT slots, see TA_FLAG_LAZY_BINDING, each
+# time ldelf is started
+CFG_LDELF_SELF_TEST ?= $(CFG_ENABLE_EMBEDDED_TESTS)
+
 # Compiles bget_main_test() to be called from a test TA
 CFG_TA_BGET_TEST ?= $(CFG_ENABLE_EMBEDDED_TESTS)
 
@@ -566,29 +636,47 @@ CFG_CORE_NEX_HEAP_SIZE ?= 16384
 # the TA is linked statically.
 CFG_TA_GPROF_SUPPORT ?= n
 
+# System-wide sampling profiler.
+# When this option is enabled, the PC of the OP-TEE core or of the user TA
+# that is interrupted by a foreign (normal world) interrupt is sampled, along
+# with its call stack, and the samples are made available to normal world
+# clients of the gprof pseudo TA as perf PERF_RECORD_SAMPLE records. Since
+# the normal world scheduler tick is a foreign interrupt, this gives a
+# periodic sampling of everything executing in the TEE without rebuilding the
+# TAs. See scripts/sample_prof_to_perf.py.
+# Kernel call stacks require CFG_UNWIND=y, user call stacks require TAs
+# compiled with frame pointers.
+# Note that the samples expose the code addresses of all the TAs to the
+# normal world, this is meant for profiling builds only.
+# CFG_CORE_SAMPLING_PROFILER_NUM_SAMPLES is the size of the per-CPU sample
+# buffer, samples are dropped (and counted as lost) when it is full.
+CFG_CORE_SAMPLING_PROFILER ?= n
+CFG_CORE_SAMPLING_PROFILER_NUM_SAMPLES ?= 128
+
+# Benchmark pseudo TA, used by the optee_benchmark tool to collect time
+# stamps of the whole invoke path, and to read the latency histograms and
+# events of the core tracepoints (see lib/libutee/include/pta_benchmark.h).
+# CFG_TEE_BENCHMARK_TP_EVENTS is the number of tracepoint events kept per
+# CPU, the oldest events are overwritten when full.
+CFG_TEE_BENCHMARK ?= n
+CFG_TEE_BENCHMARK_TP_EVENTS ?= 256
+
 # TA function tracing.
 # When this option is enabled, OP-TEE can execute Trusted Applications
 # instrumented with GCC's -pg flag and will output function tracing
-# information in ftrace.out format to /tmp/ftrace-<ta_uuid>.out (path is
-# defined in tee-supplicant)
+# records to /tmp/ftrace-<ta_uuid>.out (path is defined in tee-supplicant).
+# The records are binary, scripts/ftrace_decode.py turns them into the
+# ftrace.out text format.
 CFG_FTRACE_SUPPORT ?= n
 
-# How to make room when the function tracing buffer is full?
-# 'shift': shift the previously stored data by the amount needed in order
-#    to always keep the latest logs (slower, especially with big buffer sizes)
-# 'wrap': discard the previous data and start at the beginning of the buffer
-#    again (fast, but can result in a mostly empty buffer)
+# What to do when the function tracing buffer is full?
+# 'wrap': overwrite the oldest records to always keep the latest ones
+# 'shift': same as 'wrap', kept for compatibility
 # 'stop': stop logging new data
-CFG_FTRACE_BUF_WHEN_FULL ?= shift
+CFG_FTRACE_BUF_WHEN_FULL ?= wrap
 $(call cfg-check-value,FTRACE_BUF_WHEN_FULL,shift stop wrap)
 $(call force,_CFG_FTRACE_BUF_WHEN_FULL_$(CFG_FTRACE_BUF_WHEN_FULL),y)
 
-# Function tracing: unit to be used when displaying durations
-#  0: always display durations in microseconds
-# >0: if duration is greater or equal to the specified value (in microseconds),
-#     display it in milliseconds
-CFG_FTRACE_US_MS ?= 10000
-
 # Core syscall function tracing.
 # When this option is enabled, OP-TEE core is instrumented with GCC's
 # -pg flag and will output syscall function graph in user TA ftrace
@@ -680,6 +768,11 @@ CFG_CORE_THREAD_SHIFT ?= 0
 # non-secure memory).
 CFG_CORE_DYN_SHM ?= y
 
+# Registered (dynamic or FF-A) shared memory objects are indexed by cookie
+# in a hash table of 2^CFG_SHM_COOKIE_HASH_BITS buckets, each with its own
+# lock.
+CFG_SHM_COOKIE_HASH_BITS ?= 7
+
 # Enable support for reserved shared memory (shared memory in a carved out
 # memory area).
 CFG_CORE_RESERVED_SHM ?= y
@@ -857,6 +950,15 @@ CFG_PREALLOC_RPC_CACHE ?= n
 endif
 CFG_PREALLOC_RPC_CACHE ?= y
 
+# CFG_THREAD_SHM_CACHE_SLOTS is the number of RPC shared memory buffers of
+# different sizes each thread caches for each user (socket, file system,
+# I2C) during a call. With CFG_PREALLOC_RPC_CACHE, up to
+# CFG_THREAD_SHM_CACHE_POOL_SIZE kernel private buffers are kept registered
+# with normal world between calls and shared by all threads, until normal
+# world disables the shared memory cache.
+CFG_THREAD_SHM_CACHE_SLOTS ?= 2
+CFG_THREAD_SHM_CACHE_POOL_SIZE ?= 4
+
 # When enabled, CFG_DRIVERS_CLK embeds a clock framework in OP-TEE core.
 # This clock framework allows to describe clock tree and provides functions to
 # get and configure the clocks.
@@ -933,6 +1035,8 @@ endif
 # CFG_CORE_ASYNC_NOTIF_GIC_INTID defined.
 CFG_CORE_ASYNC_NOTIF ?= n
 
+$(eval $(call cfg-depends-all,CFG_CORE_ASYNC_TRACE,CFG_CORE_ASYNC_NOTIF))
+
 $(eval $(call cfg-enable-all-depends,CFG_MEMPOOL_REPORT_LAST_OFFSET, \
 	 CFG_WITH_STATS))
 
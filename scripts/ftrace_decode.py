@@ -0,0 +1,157 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: BSD-2-Clause
+#
+# Copyright (c) 2026, Linaro Limited
+#
+
+import argparse
+import re
+import struct
+import sys
+
+BIN_RECS_RE = re.compile(rb'Binary records: size (?P<size>[0-9]+) '
+                         rb'count (?P<count>[0-9]+) '
+                         rb'cntfrq (?P<cntfrq>[0-9]+) '
+                         rb'overhead (?P<overhead>[0-9]+) '
+                         rb'total (?P<total>[0-9]+) '
+                         rb'dropped (?P<dropped>[0-9]+)\n')
+
+# Must match struct ftrace_rec in lib/libutee/include/user_ta_header.h
+REC_FMT = '<III'
+REC_EXIT = 1 << 31
+REC_TIME = 1 << 30
+REC_DEPTH_SHIFT = 24
+REC_DEPTH_MASK = 0x3f << REC_DEPTH_SHIFT
+REC_PC_HI_MASK = 0xffffff
+
+DURATION_MAX_LEN = 16
+
+epilog = '''
+This script reads a function graph dumped by an OP-TEE TA built with
+CFG_FTRACE_SUPPORT=y (usually /tmp/ftrace-<ta_uuid>.out) and converts the
+binary records into the ftrace.out text format. The result can be piped into
+scripts/symbolize.py to resolve the function addresses.
+
+Sample usage:
+
+  $ scripts/ftrace_decode.py < /tmp/ftrace-<ta_uuid>.out | \\
+    scripts/symbolize.py -d <ta_uuid>.elf
+
+A summary with the number of records and the average time spent by the
+tracer for each record is printed on stderr.
+'''
+
+
+def get_args():
+    parser = argparse.ArgumentParser(
+                description='Decodes an OP-TEE binary function graph',
+                formatter_class=argparse.RawDescriptionHelpFormatter,
+                epilog=epilog)
+    parser.add_argument('infile', nargs='?', type=argparse.FileType('rb'),
+                        default=sys.stdin.buffer,
+                        help='the ftrace dump (default: stdin)')
+    parser.add_argument('-m', '--us-ms', type=int, default=10000,
+                        help='display durations greater or equal to this '
+                        'number of microseconds in milliseconds, 0 to always '
+                        'use microseconds (default: 10000)')
+    parser.add_argument('-w', '--addr-width', type=int, default=16,
+                        choices=[8, 16],
+                        help='number of hex digits of the function addresses '
+                        '(default: 16)')
+    return parser.parse_args()
+
+
+def fmt_duration(ticks, cntfrq, us_ms):
+    ns = ticks * 1000000000 // cntfrq
+    us = ns // 1000
+    if us_ms and us >= us_ms:
+        unit = 'm'
+        val = us // 1000
+        frac = us % 1000
+    else:
+        unit = 'u'
+        val = us
+        frac = ns % 1000
+
+    if val > 999999:
+        # Not enough space to print the value
+        return '-' * 10 + ' ' + unit + 's'
+    return (str(val) if val else '') + '.{:03d} {}s'.format(frac, unit)
+
+
+def graph_line(depth, text, duration=None):
+    prefix = [' '] * (DURATION_MAX_LEN + depth)
+    prefix[DURATION_MAX_LEN - 2] = '|'
+    if duration:
+        end = DURATION_MAX_LEN - 3
+        prefix[end - len(duration):end] = duration
+    return ''.join(prefix) + text
+
+
+def decode(recs, cntfrq, us_ms, addr_width):
+    lines = []
+    # depth: (index in lines, timestamp) of the last entry at that depth
+    entries = {}
+    now = 0
+
+    for pc_lo, pc_hi, delta in struct.iter_unpack(REC_FMT, recs):
+        if pc_hi & REC_TIME:
+            now += (pc_lo << 32) | delta
+            continue
+        now += delta
+        depth = (pc_hi & REC_DEPTH_MASK) >> REC_DEPTH_SHIFT
+
+        if not pc_hi & REC_EXIT:
+            pc = ((pc_hi & REC_PC_HI_MASK) << 32) | pc_lo
+            func = '0x{:0{}x}()'.format(pc, addr_width)
+            entries[depth] = (len(lines), now)
+            lines.append({'depth': depth, 'text': func + ' {', 'dur': None})
+            continue
+
+        entry = entries.pop(depth, None)
+        dur = None
+        if entry:
+            dur = fmt_duration(now - entry[1], cntfrq, us_ms)
+        if entry and entry[0] == len(lines) - 1:
+            # Leaf function, output as a single line
+            lines[-1]['text'] = lines[-1]['text'][:-2] + ';'
+            lines[-1]['dur'] = dur
+        else:
+            lines.append({'depth': depth, 'text': '}', 'dur': dur})
+
+    for line in lines:
+        yield graph_line(line['depth'], line['text'], line['dur'])
+
+
+def main():
+    args = get_args()
+    data = args.infile.read()
+
+    match = BIN_RECS_RE.search(data)
+    if not match:
+        sys.exit('No binary function graph records found')
+
+    size = int(match.group('size'))
+    count = int(match.group('count'))
+    cntfrq = int(match.group('cntfrq'))
+    overhead = int(match.group('overhead'))
+    total = int(match.group('total'))
+    dropped = int(match.group('dropped'))
+    if size != struct.calcsize(REC_FMT) or not cntfrq:
+        sys.exit('Unsupported record format')
+
+    sys.stdout.write(data[:match.start()].decode('utf-8', 'replace'))
+    recs = data[match.end():match.end() + size * count]
+    for line in decode(recs, cntfrq, args.us_ms, args.addr_width):
+        print(line)
+
+    print('{} records, {} overwritten, {} dropped'
+          .format(count, total - count, dropped), file=sys.stderr)
+    if total:
+        ns = overhead * 1000000000 // cntfrq // total
+        print('Tracing overhead: {} ns per record, {} ns per traced call'
+              .format(ns, 2 * ns), file=sys.stderr)
+
+
+if __name__ == '__main__':
+    main()
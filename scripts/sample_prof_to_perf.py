@@ -0,0 +1,196 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: BSD-2-Clause
+#
+# Copyright (c) 2026, Linaro Limited
+#
+
+import argparse
+import os
+import struct
+import sys
+
+PERF_MAGIC = b'PERFILE2'
+PERF_TYPE_SOFTWARE = 1
+PERF_COUNT_SW_CPU_CLOCK = 0
+# PERF_SAMPLE_IP | PERF_SAMPLE_TID | PERF_SAMPLE_TIME | PERF_SAMPLE_CALLCHAIN |
+# PERF_SAMPLE_CPU, must match core/kernel/sample_prof.c
+SAMPLE_TYPE = (1 << 0) | (1 << 1) | (1 << 2) | (1 << 5) | (1 << 7)
+PERF_ATTR_SIZE = 112
+PERF_FILE_HEADER_SIZE = 104
+
+PERF_RECORD_MMAP = 1
+PERF_RECORD_LOST = 2
+PERF_RECORD_COMM = 3
+PERF_RECORD_SAMPLE = 9
+PERF_RECORD_MISC_KERNEL = 1
+PERF_RECORD_MISC_USER = 2
+
+PT_LOAD = 1
+
+epilog = '''
+This script converts the records read from the gprof pseudo TA with
+PTA_GPROF_READ_SYS_SAMPLES (OP-TEE built with CFG_CORE_SAMPLING_PROFILER=y)
+into a perf.data file.
+
+The core samples are attributed to the kernel, the TA samples to a process
+which pid is the first field of the TA UUID. Give the TEE core and TA ELF
+files and their load addresses to get the symbols resolved:
+
+  $ scripts/sample_prof_to_perf.py -o perf.data \\
+      --tee out/arm/core/tee.elf@0xe100000 \\
+      --ta 8aaaf200-2450-11e4-abe2-0002a5d5c51b.elf@0x40015000 samples.bin
+  $ perf report -i perf.data --vmlinux out/arm/core/tee.elf
+
+The load addresses are printed in the secure console when the core or the TA
+panics, or are fixed when ASLR is disabled (CFG_CORE_ASLR=n, CFG_TA_ASLR=n).
+'''
+
+
+def get_args():
+    parser = argparse.ArgumentParser(
+                description='Converts OP-TEE system-wide samples to a '
+                'perf.data file',
+                formatter_class=argparse.RawDescriptionHelpFormatter,
+                epilog=epilog)
+    parser.add_argument('infiles', nargs='+', type=argparse.FileType('rb'),
+                        help='sample records, as read from the pseudo TA')
+    parser.add_argument('-o', '--output', default='perf.data',
+                        help='output file (default: perf.data)')
+    parser.add_argument('--tee', metavar='ELF@ADDR',
+                        help='TEE core ELF file and load address')
+    parser.add_argument('--ta', metavar='ELF@ADDR', action='append',
+                        default=[], help='TA ELF file and load address, the '
+                        'file name must start with the TA UUID')
+    return parser.parse_args()
+
+
+def elf_span(path):
+    """Returns the size of the memory covered by the PT_LOAD segments"""
+    with open(path, 'rb') as f:
+        ehdr = f.read(64)
+        if ehdr[:4] != b'\x7fELF':
+            sys.exit('{}: not an ELF file'.format(path))
+        if ehdr[4] == 2:
+            phoff, = struct.unpack_from('<Q', ehdr, 32)
+            phentsize, phnum = struct.unpack_from('<HH', ehdr, 54)
+            phdr_fmt = '<IIQQQQQQ'
+        else:
+            phoff, = struct.unpack_from('<I', ehdr, 28)
+            phentsize, phnum = struct.unpack_from('<HH', ehdr, 42)
+            phdr_fmt = '<IIIIIIII'
+        f.seek(phoff)
+        phdrs = f.read(phentsize * phnum)
+
+    lo = None
+    hi = 0
+    for n in range(phnum):
+        ph = struct.unpack_from(phdr_fmt, phdrs, n * phentsize)
+        if ph[0] != PT_LOAD:
+            continue
+        if ehdr[4] == 2:
+            vaddr, memsz = ph[3], ph[6]
+        else:
+            vaddr, memsz = ph[2], ph[5]
+        lo = vaddr if lo is None else min(lo, vaddr)
+        hi = max(hi, vaddr + memsz)
+    return hi - (lo or 0)
+
+
+def parse_elf_arg(arg):
+    path, _, addr = arg.rpartition('@')
+    if not path:
+        sys.exit('Expected ELF@ADDR, got {}'.format(arg))
+    return path, int(addr, 0)
+
+
+def record(rec_type, misc, payload):
+    payload += b'\0' * (-len(payload) % 8)
+    return struct.pack('<IHH', rec_type, misc, 8 + len(payload)) + payload
+
+
+def mmap_record(pid, misc, addr, size, filename):
+    return record(PERF_RECORD_MMAP, misc,
+                  struct.pack('<IIQQQ', pid, pid, addr, size, 0) +
+                  filename.encode() + b'\0')
+
+
+def comm_record(pid, name):
+    return record(PERF_RECORD_COMM, 0,
+                  struct.pack('<II', pid, pid) + name[:15].encode() + b'\0')
+
+
+def maps_records(args):
+    recs = []
+    if args.tee:
+        path, addr = parse_elf_arg(args.tee)
+        recs.append(mmap_record(0xffffffff, PERF_RECORD_MISC_KERNEL, addr,
+                                elf_span(path), '[kernel.kallsyms]_text'))
+    for ta in args.ta:
+        path, addr = parse_elf_arg(ta)
+        name = os.path.basename(path)
+        pid = int(name.split('-')[0], 16)
+        recs.append(comm_record(pid, name))
+        recs.append(mmap_record(pid, PERF_RECORD_MISC_USER, addr,
+                                elf_span(path), os.path.abspath(path)))
+    return b''.join(recs)
+
+
+def check_records(data):
+    """Validates the record stream and returns (samples, lost)"""
+    samples = 0
+    lost = 0
+    pos = 0
+    while pos < len(data):
+        if len(data) - pos < 8:
+            sys.exit('Truncated record at offset {}'.format(pos))
+        rec_type, _, size = struct.unpack_from('<IHH', data, pos)
+        if size < 8 or size % 8 or pos + size > len(data):
+            sys.exit('Bad record size at offset {}'.format(pos))
+        if rec_type == PERF_RECORD_SAMPLE:
+            samples += 1
+        elif rec_type == PERF_RECORD_LOST:
+            lost += struct.unpack_from('<Q', data, pos + 16)[0]
+        else:
+            sys.exit('Unexpected record type {} at offset {}'
+                     .format(rec_type, pos))
+        pos += size
+    return samples, lost
+
+
+def perf_attr():
+    # struct perf_event_attr, PERF_ATTR_SIZE_VER5
+    attr = struct.pack('<IIQQQQQ', PERF_TYPE_SOFTWARE, PERF_ATTR_SIZE,
+                       PERF_COUNT_SW_CPU_CLOCK, 1, SAMPLE_TYPE, 0, 0)
+    return attr + b'\0' * (PERF_ATTR_SIZE - len(attr))
+
+
+def main():
+    args = get_args()
+    samples = b''.join(f.read() for f in args.infiles)
+    num_samples, num_lost = check_records(samples)
+    data = maps_records(args) + samples
+
+    attr = perf_attr()
+    # Each attr is followed by the file section of its ids, none here
+    attrs = attr + struct.pack('<QQ', 0, 0)
+    attrs_off = PERF_FILE_HEADER_SIZE
+    data_off = attrs_off + len(attrs)
+
+    header = PERF_MAGIC + struct.pack('<QQ', PERF_FILE_HEADER_SIZE,
+                                      len(attrs))
+    header += struct.pack('<QQQQQQ', attrs_off, len(attrs), data_off,
+                          len(data), 0, 0)
+    # No feature sections
+    header += b'\0' * (PERF_FILE_HEADER_SIZE - len(header))
+
+    with open(args.output, 'wb') as f:
+        f.write(header)
+        f.write(attrs)
+        f.write(data)
+
+    print('{} samples, {} lost'.format(num_samples, num_lost),
+          file=sys.stderr)
+
+
+if __name__ == '__main__':
+    main()
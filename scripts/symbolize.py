@@ -66,14 +66,13 @@ Sample usage:
   ^D
 
 Also, this script reads function graph generated for OP-TEE user TA from
-/tmp/ftrace-<ta_uuid>.out file and resolves function addresses to corresponding
-symbols.
+/tmp/ftrace-<ta_uuid>.out file, once decoded by scripts/ftrace_decode.py, and
+resolves function addresses to corresponding symbols.
 
 Sample usage:
 
-  $ cat /tmp/ftrace-<ta_uuid>.out | scripts/symbolize.py -d <ta_uuid>.elf
-  <paste function graph here>
-  ^D
+  $ scripts/ftrace_decode.py /tmp/ftrace-<ta_uuid>.out | \
+    scripts/symbolize.py -d <ta_uuid>.elf
 '''
 
 tee_result_names = {
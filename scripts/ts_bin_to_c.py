@@ -14,6 +14,11 @@ import struct
 import uuid
 import zlib
 
+# Must match EMB_TS_LZ4_CHUNK_SIZE and EMB_TS_LZ4_CHUNK_RAW in
+# core/include/kernel/embedded_ts.h
+LZ4_CHUNK_SIZE = 32 * 1024
+LZ4_CHUNK_RAW = 1 << 31
+
 
 def get_args():
     parser = argparse.ArgumentParser(
@@ -40,8 +45,16 @@ def get_args():
         '--compress',
         dest="compress",
         action="store_true",
-        help='Compress the image using the DEFLATE '
-        'algorithm')
+        help='Compress the image using the algorithm selected with '
+        '--compress-algo')
+
+    parser.add_argument(
+        '--compress-algo',
+        dest="compress_algo",
+        choices=['deflate', 'lz4'],
+        default='deflate',
+        help='Compression algorithm, DEFLATE by default. LZ4 compresses '
+        'less but decompresses faster')
 
     parser.add_argument(
         '--manifest',
@@ -87,11 +100,81 @@ def sp_get_flags(sp_f):
         raise Exception('.sp_head section not found')
 
 
-def dump_bin(f, ts, compress):
+def lz4_write_len(out, n):
+    while n >= 255:
+        out.append(255)
+        n -= 255
+    out.append(n)
+
+
+def lz4_write_seq(out, lit, offset, mlen):
+    # A sequence is a token, the literals and the match if any, see
+    # https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md
+    ml = mlen - 4
+    out.append((min(len(lit), 15) << 4) | (min(ml, 15) if offset else 0))
+    if len(lit) >= 15:
+        lz4_write_len(out, len(lit) - 15)
+    out += lit
+    if offset:
+        out += struct.pack('<H', offset)
+        if ml >= 15:
+            lz4_write_len(out, ml - 15)
+
+
+def lz4_compress_block(src):
+    try:
+        import lz4.block
+        return lz4.block.compress(src, mode='high_compression',
+                                  store_size=False)
+    except ImportError:
+        pass
+
+    # Greedy compressor, following the end of block restrictions: the last
+    # match starts at least 12 bytes before the end, the last 5 bytes are
+    # literals.
+    out = bytearray()
+    table = {}
+    anchor = 0
+    i = 0
+    n = len(src)
+    while i < n - 12:
+        seq = src[i:i + 4]
+        ref = table.get(seq)
+        table[seq] = i
+        if ref is None or i - ref > 65535:
+            i += 1
+            continue
+        mlen = 4
+        while i + mlen < n - 5 and src[ref + mlen] == src[i + mlen]:
+            mlen += 1
+        lz4_write_seq(out, src[anchor:i], i - ref, mlen)
+        i += mlen
+        anchor = i
+    lz4_write_seq(out, src[anchor:], 0, 0)
+    return bytes(out)
+
+
+def lz4_compress(data):
+    # Chunks are compressed independently so that the TEE core only needs
+    # a chunk sized buffer to decompress the image
+    out = bytearray()
+    for i in range(0, len(data), LZ4_CHUNK_SIZE):
+        chunk = data[i:i + LZ4_CHUNK_SIZE]
+        block = lz4_compress_block(chunk)
+        if len(block) < len(chunk):
+            out += struct.pack('<I', len(block)) + block
+        else:
+            out += struct.pack('<I', len(chunk) | LZ4_CHUNK_RAW) + chunk
+    return bytes(out)
+
+
+def dump_bin(f, ts, compress, compress_algo='deflate'):
     with open(ts, 'rb') as _ts:
         bytes = _ts.read()
         uncompressed_size = len(bytes)
-        if compress:
+        if compress and compress_algo == 'lz4':
+            bytes = lz4_compress(bytes)
+        elif compress:
             bytes = zlib.compress(bytes)
         size = len(bytes)
 
@@ -134,7 +217,8 @@ def main():
     f.write('#include <kernel/embedded_ts.h>\n\n')
     f.write('#include <scattered_array.h>\n\n')
     f.write('const uint8_t ts_bin_' + ts_uuid.hex + '[] = {\n')
-    ts_size, ts_uncompressed_size = dump_bin(f, ts, args.compress)
+    ts_size, ts_uncompressed_size = dump_bin(f, ts, args.compress,
+                                             args.compress_algo)
     f.write('};\n')
 
     if is_sp:
@@ -170,6 +254,8 @@ def main():
     if args.compress:
         f.write('\t.uncompressed_size = '
                 '{:d},\n'.format(ts_uncompressed_size))
+        if args.compress_algo == 'lz4':
+            f.write('\t.compression = EMB_TS_COMPRESS_LZ4,\n')
     if is_sp:
         f.write('}\n')
     f.write('};\n')